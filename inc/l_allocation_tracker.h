@@ -0,0 +1,60 @@
+#pragma once
+
+#include "l_types.h"
+
+namespace lain
+{
+  // ---------------------------------------------------------------------------
+  // Replaces the global operator new/delete to count heap allocations. Every
+  // allocation is charged to the tag of the innermost `scoped_tag` on the
+  // allocating thread (`other` if there's none), counters are kept per frame.
+  //
+  // In strict mode, once warmed up, any frame that allocates is a failed
+  // assertion: the steady state is supposed to be allocation free. Except
+  // for `resources`, loading and streaming allocate on any thread whenever a
+  // model comes in, those counts are only reported.
+  // ---------------------------------------------------------------------------
+  namespace allocation_tracker
+  {
+    enum class tag : u32
+      {
+	other,
+	input,
+	update,
+	simulation,
+	render,
+	imgui,
+	resources,
+	count
+      };
+
+    u32 constexpr kTagCount{static_cast<u32>(tag::count)};
+
+    struct allocation_stats final
+    {
+      u32 _allocations[kTagCount];
+      u64 _bytes[kTagCount];
+    };
+
+    struct scoped_tag final
+    {
+      explicit scoped_tag(tag t);
+      ~scoped_tag();
+
+      scoped_tag(scoped_tag const&) = delete;
+      scoped_tag& operator=(scoped_tag const&) = delete;
+
+      tag _previous;
+    };
+
+    // Stores the counters of the frame that just ended and resets them. Checks them in strict mode.
+    void BeginFrame();
+
+    allocation_stats const& GetLastFrameStats();
+
+    // `warmupFrames` frames are allowed to allocate (first ImGui windows, caches filling up...).
+    void SetStrict(bool strict, u32 warmupFrames = 120);
+
+    char const* GetTagName(tag t);
+  };
+};
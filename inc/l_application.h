@@ -2,6 +2,8 @@
 
 #include <string>
 
+#include "l_mesh.h"
+#include "l_texture_cache.h"
 #include "l_types.h"
 
 namespace lain
@@ -11,14 +13,68 @@ namespace lain
   // -----------------------------------------------------------
   namespace application
   {
+    struct headless_options final
+    {
+      i32 _width;
+      i32 _height;
+      u32 _frames;
+      std::string _level; // loaded in the level editor, empty means main menu
+    };
+
+    enum class vsync_mode
+      {
+	off,
+	on,
+	adaptive // tears instead of waiting a whole refresh when a frame is late
+      };
+
     bool Initialise(bool fullScreen);
 
+    // No window, no input and no vsync: creates a surfaceless EGL context, renders
+    // into an offscreen framebuffer and `Run` returns after `_frames` frames
+    // printing a timing report. Works with software drivers like llvmpipe.
+    bool InitialiseHeadless(headless_options const& options);
+
     void ToggleFullScreen();
 
     void Shutdown();
 
     void Run();
 
+    // Falls back to `on` if the driver doesn't do adaptive. Can be called before `Initialise`.
+    void SetVsync(vsync_mode mode);
+
+    vsync_mode GetVsync();
+
+    // Sleeps at the end of the frame to cap the frame rate, 0 disables it.
+    void SetFrameRateLimit(f32 framesPerSecond);
+
+    f32 GetFrameRateLimit();
+
+    // Simulate the next frame on its own thread while this one is drawn (default),
+    // or everything serially on the main thread, handy for debugging.
+    void SetPipelined(bool pipelined);
+
+    bool IsPipelined();
+
+    // Assert if a frame allocates once things have settled down, see allocation_tracker.
+    void SetStrictAllocations(bool strict);
+
+    // Start without waiting for models, they stream in while the game runs. Call before `Initialise`.
+    void SetStreamAssets(bool stream);
+
+    // How textures are baked, see texture_cache. Call before `Initialise`.
+    void SetTextureCompression(texture_cache::compression compression);
+
+    // How mesh vertices are laid out on the GPU. Call before `Initialise`.
+    void SetVertexFormat(vertex_format format);
+
+    // Frame stats get written there (CSV, or JSON for a .json extension) on shutdown.
+    void SetFrameStatsFile(std::string&& file);
+
+    // Use instead of the ImGui backends' NewFrame, there's no SDL backend when headless.
+    void NewImGuiFrame();
+
     f32 GetWindowWidth();
 
     f32 GetWindowHeight();
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "l_mapped_file.h"
+#include "l_types.h"
+
+namespace lain
+{
+  // ---------------------------------------------------------------------------
+  // Every asset in one file: a header, the blobs (each aligned to
+  // `kAlignment`), then a table of contents sorted by name. The pack is
+  // mapped once and assets are handed out as views straight into the mapping.
+  //
+  // Assets are named by their normalised relative path ("res/shaders/x.vert"),
+  // so the same path works whether it's packed or a loose file. Build one with
+  // the pack_assets tool.
+  // ---------------------------------------------------------------------------
+  namespace asset_pack
+  {
+    u32 constexpr kAlignment{64};
+
+    // name -> file on disk
+    using pack_input = std::pair<std::string, std::filesystem::path>;
+
+    bool Write(std::filesystem::path const& pack, std::vector<pack_input> inputs);
+
+    // Maps `pack`, from then on `Open` looks in there first. False if it doesn't exist or isn't a pack.
+    bool Mount(std::filesystem::path const& pack);
+
+    void Unmount();
+
+    bool IsMounted();
+
+    // Looks in the mounted pack first, then on disk. Either way nothing is copied,
+    // give the view back with `Close`.
+    bool Open(std::filesystem::path const& path, mapped_file& file);
+
+    void Close(mapped_file& file);
+
+    // Names of the packed assets anywhere under `directory`, in order. Empty when nothing is mounted.
+    std::vector<std::string> List(std::filesystem::path const& directory);
+
+    std::string NormaliseName(std::filesystem::path const& path);
+
+    // Where a cache built from `source` goes under `directory`, mirroring the source's normalised path so
+    // "props/crate.obj" and "other/crate.obj" don't share a file. The leading "res/", any root and any ".."
+    // are dropped, the result never leaves `directory`.
+    std::filesystem::path GetCachePath(std::filesystem::path const& directory, std::filesystem::path const& source);
+  };
+};
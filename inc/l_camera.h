@@ -12,6 +12,7 @@ namespace lain
   struct camera3D final
   {
     glm::vec3 _position;
+    glm::vec3 _previousPosition; // before the last `Update`, for interpolation
     glm::vec3 _targetPosition;
     glm::vec3 _front;
     glm::vec3 _up;
@@ -22,7 +23,7 @@ namespace lain
     f32 _pitch; // in radians
     f32 _speed;
     f32 _sensitivity;
-    f32 _lerp;
+    f32 _lerp; // fraction of the distance to the target covered every 1/60 s
 
     void ProcessKeyboard(glm::vec3 const& input);
 
@@ -33,6 +34,9 @@ namespace lain
     glm::mat4 GetViewMatrix() const;
 
     void Update(f32 deltaTime);
+
+    // Copy of the camera placed `alpha` of the way between the last two updates.
+    camera3D Interpolated(f32 alpha) const;
   };
 
 };
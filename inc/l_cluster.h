@@ -0,0 +1,43 @@
+#pragma once
+
+#include "l_culling.h"
+#include "l_mesh.h"
+#include "l_types.h"
+
+#include <vector>
+
+namespace lain
+{
+  // ---------------------------------------------------------------------------
+  // Clusters (meshlets). At import level 0 of every mesh is cut into clusters
+  // of up to `kMaxTriangles` neighbouring triangles facing roughly the same
+  // way, each with a bounding sphere and a cone bounding their normals. Every
+  // frame the visible meshes drawn at level 0 drop the clusters outside the
+  // frustum and the ones facing away from the camera before their draws are
+  // built. Tests are done in the mesh's space, so they hold under any model
+  // matrix that doesn't mirror. No GL in here.
+  // ---------------------------------------------------------------------------
+  namespace cluster
+  {
+    // Vertices are what keeps a cluster compact, triangles what it costs to draw.
+    u32 constexpr kMaxVertices{64};
+    u32 constexpr kMaxTriangles{124};
+
+    // Reorders level 0's indices so every cluster's triangles are contiguous, in the order they
+    // were in, and fills in `mesh._clusters`. Call it on welded vertices in vertex cache order,
+    // then `mesh_optimiser::Optimise` (which orders each cluster in place), then `lod::Generate`,
+    // which leaves level 0 alone.
+    void Build(mesh_data& mesh);
+
+    // Can't see any of its triangles' front faces from `cameraPosition`.
+    bool IsBackFacing(mesh_cluster const& cluster, glm::vec3 const& cameraPosition);
+
+    // Fills `visible` with the clusters that intersect the frustum and aren't back facing, in
+    // increasing order. The frustum and the camera are in the mesh's space.
+    culling::cull_stats Cull(culling::frustum const& frustum,
+			     glm::vec3 const& cameraPosition,
+			     mesh_cluster const* clusters,
+			     u32 clusterCount,
+			     std::vector<u32>& visible);
+  };
+};
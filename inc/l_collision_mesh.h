@@ -0,0 +1,45 @@
+#pragma once
+
+#include "glm/ext/vector_float3.hpp"
+#include "l_types.h"
+
+#include <span>
+#include <vector>
+
+namespace lain
+{
+  struct vertex_data;
+
+  // ---------------------------------------------------------------------------
+  // CPU copies of the meshes something still needs triangles of after the
+  // upload (collision), everything else only lives on the GPU. Only positions
+  // are kept, welded, and every mesh shares the same two arrays. Main thread
+  // only, like the resource pools. No GL in here.
+  // ---------------------------------------------------------------------------
+  namespace collision_mesh
+  {
+    // Where a mesh's triangles are in the shared arrays, no indices means no copy.
+    struct collision_mesh_ref final
+    {
+      u32 _firstPosition;
+      u32 _positionCount;
+      u32 _firstIndex;
+      u32 _indexCount;
+    };
+
+    // Indices are relative to the first position.
+    struct collision_mesh_view final
+    {
+      std::span<glm::vec3 const> _positions;
+      std::span<u32 const> _indices;
+    };
+
+    collision_mesh_ref Add(std::vector<vertex_data> const& vertices, std::span<u32 const> indices);
+
+    // Valid until the next `Add`.
+    collision_mesh_view Get(collision_mesh_ref ref);
+
+    // Everything added so far, in bytes.
+    u64 GetResidentBytes();
+  };
+};
@@ -36,6 +36,20 @@ namespace lain {
     return hash;
   };
 
+  // 64-bit FNV-1a over raw bytes, for hashing file contents. Chain calls by passing the previous result.
+  inline u64 fnv1a64(void const* data, std::size_t size, u64 hash = 0xcbf29ce484222325)
+  {
+    u64 constexpr prime{0x100000001b3}; // FNV-1a 64-bit prime
+    auto const* bytes = static_cast<unsigned char const*>(data);
+
+    for (std::size_t i{0}; i < size; ++i) {
+      hash ^= bytes[i];
+      hash *= prime;
+    }
+
+    return hash;
+  }
+
   i32 constexpr kPrimitiveShaderId{fnv1a("PShader", CompileTimeStringLength("PShader"))};
 
   i32 constexpr kLevelEditorModelWithTextureShaderId{fnv1a("LEModelWTex", CompileTimeStringLength("LEModelWTex"))};
@@ -43,4 +57,8 @@ namespace lain {
   i32 constexpr kLevelEditorModelWithoutTextureShaderId{fnv1a("LEModelWOTex",CompileTimeStringLength("LEModelWOTex"))};
 
   i32 constexpr kBoundingBoxShaderId{fnv1a("BBShader", CompileTimeStringLength("BBShader"))};
+
+  i32 constexpr kLevelEditorGridShaderId{fnv1a("LEGrid", CompileTimeStringLength("LEGrid"))};
+
+  i32 constexpr kDebugLinesShaderId{fnv1a("DebugLines", CompileTimeStringLength("DebugLines"))};
 };
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "glm/ext/matrix_float4x4.hpp"
+#include "glm/ext/vector_float4.hpp"
+#include "l_math.h"
+#include "l_types.h"
+#include <vector>
+
+namespace lain
+{
+  // ---------------------------------------------------------------------------
+  // CPU visibility tests. Nothing in here touches GL so it can be used (and
+  // measured) without a context.
+  // ---------------------------------------------------------------------------
+  namespace culling
+  {
+    // Planes point inwards: a point p is inside when dot(plane.xyz, p) + plane.w >= 0.
+    struct frustum final
+    {
+      glm::vec4 _planes[6];
+    };
+
+    // Bounds stored as structure of arrays (centre + half extent) so they can be
+    // tested four at a time.
+    struct bounds_soa final
+    {
+      std::vector<f32> _centreX;
+      std::vector<f32> _centreY;
+      std::vector<f32> _centreZ;
+      std::vector<f32> _extentX;
+      std::vector<f32> _extentY;
+      std::vector<f32> _extentZ;
+    };
+
+    struct cull_stats final
+    {
+      u32 _tested;
+      u32 _visible;
+      u32 _culled;
+    };
+
+    // Gribb/Hartmann plane extraction, `viewProjection` is `projection * view`.
+    frustum ExtractFrustum(glm::mat4 const& viewProjection);
+
+    void ClearBounds(bounds_soa& bounds);
+
+    void AddBounds(bounds_soa& bounds, aabb const& box);
+
+    u32 GetBoundsCount(bounds_soa const& bounds);
+
+    // Fills `visible` with the indices of the boxes that intersect the frustum,
+    // in increasing order. SSE, four boxes per iteration.
+    cull_stats CullBounds(frustum const& frustum, bounds_soa const& bounds, std::vector<u32>& visible);
+
+    // Same as `CullBounds`, one box at a time. Reference for tests and benchmarks.
+    cull_stats CullBoundsScalar(frustum const& frustum, bounds_soa const& bounds, std::vector<u32>& visible);
+  };
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "glm/ext/matrix_float4x4.hpp"
+#include "glm/ext/vector_float3.hpp"
+#include "glm/ext/vector_float4.hpp"
+#include "l_math.h"
+#include "l_types.h"
+
+namespace lain
+{
+  // ---------------------------------------------------------------------------
+  // Immediate mode debug drawing. Call the shape functions from anywhere during
+  // the frame, the vertices go straight into a persistently mapped ring buffer
+  // and `Flush` draws all of them with a single call.
+  // ---------------------------------------------------------------------------
+  namespace debug_draw
+  {
+    struct debug_draw_stats final
+    {
+      u32 _vertices;
+      u32 _dropped; // vertices that didn't fit this frame
+    };
+
+    void Initialise();
+
+    // Waits until the GPU is done with the part of the ring buffer we're about to reuse.
+    void BeginFrame();
+
+    void Line(glm::vec3 const& from, glm::vec3 const& to, glm::vec4 const& colour);
+
+    void Box(aabb const& box, glm::vec4 const& colour);
+
+    void Sphere(glm::vec3 const& centre, f32 radius, glm::vec4 const& colour, u32 segments = 16);
+
+    void Ray(ray const& ray, f32 length, glm::vec4 const& colour);
+
+    // Square grid on the XZ plane, `halfExtent` units in every direction from `centre`.
+    void Grid(glm::vec3 const& centre, f32 halfExtent, f32 spacing, glm::vec4 const& colour);
+
+    void Flush(glm::mat4 const& viewProjection);
+
+    debug_draw_stats GetStats();
+  };
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "l_types.h"
+
+namespace lain
+{
+  // ---------------------------------------------------------------------------
+  // Linear allocator for data that only lives until the end of the frame.
+  // Allocating is a pointer bump, nothing is freed individually, `BeginFrame`
+  // resets the whole thing. Main thread only.
+  // ---------------------------------------------------------------------------
+  namespace frame_arena
+  {
+    void Initialise(std::size_t capacity);
+
+    void Shutdown();
+
+    void BeginFrame();
+
+    // Returns nullptr when the arena is full, which is a bug: make it bigger.
+    void* Allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t));
+
+    // Uninitialised storage for `count` objects, only for trivially destructible types.
+    template<typename T>
+    T* AllocateArray(std::size_t count)
+    {
+      return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    std::size_t GetBytesUsed();
+
+    // Most bytes used in a single frame since `Initialise`.
+    std::size_t GetHighWaterMark();
+
+    std::size_t GetCapacity();
+
+    // So standard containers can live in the arena: std::vector<T, frame_arena::allocator<T>>.
+    // Not final, libstdc++ derives from allocators.
+    template<typename T>
+    struct allocator
+    {
+      using value_type = T;
+
+      allocator() = default;
+
+      template<typename U>
+      allocator(allocator<U> const&) {}
+
+      // Containers don't check for nullptr, a full arena ends it here rather than in one of them.
+      T* allocate(std::size_t count)
+      {
+	T* p{AllocateArray<T>(count)};
+
+	if (p == nullptr) {
+	  std::abort();
+	}
+
+	return p;
+      }
+
+      void deallocate(T*, std::size_t) {}
+
+      template<typename U>
+      bool operator==(allocator<U> const&) const { return true; }
+    };
+  };
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <filesystem>
+
+#include "l_types.h"
+
+namespace lain
+{
+  // ---------------------------------------------------------------------------
+  // Rolling record of the last `kCapacity` frames, split into the phases of
+  // `application::Run`. Used for the frame time graph in the editor and for
+  // dumping hard numbers (CSV or JSON) to compare runs.
+  // ---------------------------------------------------------------------------
+  namespace frame_stats
+  {
+    u32 constexpr kCapacity{1024};
+
+    // All in milliseconds.
+    struct frame_timings final
+    {
+      f32 _input;
+      f32 _update;
+      f32 _render;
+      f32 _swap;
+      f32 _total;
+    };
+
+    struct frame_summary final
+    {
+      u32 _count;
+      f32 _average;
+      f32 _min;
+      f32 _p50;
+      f32 _p95;
+      f32 _p99;
+      f32 _max;
+      u32 _stutters; // frames that took more than twice the median
+    };
+
+    void Record(frame_timings const& timings);
+
+    void Clear();
+
+    u32 GetFrameCount();
+
+    // `index` 0 is the oldest frame still recorded.
+    frame_timings const& GetFrame(u32 index);
+
+    // Summary of the frames' `_total`.
+    frame_summary Summarise();
+
+    // Summary of any list of frame times, `frameTimes` gets sorted.
+    frame_summary Summarise(f32* frameTimes, u32 count);
+
+    bool ExportCSV(std::filesystem::path const& file);
+
+    bool ExportJSON(std::filesystem::path const& file);
+
+    // Picks CSV or JSON from the extension.
+    bool Export(std::filesystem::path const& file);
+  };
+};
@@ -4,6 +4,8 @@
 
 namespace lain
 {
+  struct render_snapshot;
+
   namespace game
   {
     void Initialise();
@@ -14,8 +16,16 @@ namespace lain
 
     void ProcessInput();
 
+    // Once per rendered frame: input driven stuff and UI.
     void Update(f32 deltaTime);
 
-    void Render();
+    // Simulation, called zero or more times per frame with a constant step.
+    void FixedUpdate(f32 deltaTime);
+
+    // `alpha` is how far we are between the last two fixed updates, [0, 1).
+    // Runs on the simulation thread when pipelined, together with FixedUpdate.
+    void BuildSnapshot(f32 alpha, render_snapshot& snapshot);
+
+    void Render(render_snapshot const& snapshot);
   };
 };
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "glad/glad.h"
+#include "l_types.h"
+
+namespace lain
+{
+  // ---------------------------------------------------------------------------
+  // Thin layer over the GL binding calls. It keeps a shadow copy of what is
+  // bound and skips calls that wouldn't change anything. Every bind in the
+  // engine has to go through here, otherwise the shadow copy goes stale.
+  // ---------------------------------------------------------------------------
+  namespace gl_state
+  {
+    struct gl_state_stats final
+    {
+      u32 _calls;   // bind requests
+      u32 _skipped; // how many of those were redundant and never reached GL
+    };
+
+    void Initialise();
+
+    // Stores the counters of the frame that just ended and resets them.
+    void BeginFrame();
+
+    void UseProgram(u32 id);
+
+    void BindVertexArray(u32 id);
+
+    void BindBuffer(GLenum target, u32 id);
+
+    void ActiveTexture(GLenum texture);
+
+    void BindTexture(GLenum target, u32 id);
+
+    // Call next to glDeleteTextures / glDeleteProgram. GL reuses deleted names, so a shadow still holding
+    // one would skip the bind of whatever gets the name next.
+    void ForgetTexture(u32 id);
+
+    void ForgetProgram(u32 id);
+
+    // Forget everything, use it after code that doesn't go through here touched the bindings.
+    void Invalidate();
+
+    // When enabled, every call checks the shadow copy against glGet* and asserts on mismatch. Slow.
+    void SetValidation(bool enabled);
+
+    bool IsValidating();
+
+    gl_state_stats GetLastFrameStats();
+  };
+};
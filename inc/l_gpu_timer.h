@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+
+#include "l_types.h"
+
+namespace lain
+{
+  // ---------------------------------------------------------------------------
+  // GPU time per render pass. Each pass is bracketed by two GL_TIMESTAMP
+  // queries, so passes can nest. Results are read `kLatency` frames later,
+  // when the GPU is long done with them, so reading never stalls.
+  //
+  // If the driver has no timer queries (some software drivers report 0 bits)
+  // everything turns into a no-op and `IsSupported` returns false.
+  // ---------------------------------------------------------------------------
+  namespace gpu_timer
+  {
+    struct pass_time final
+    {
+      char const* _name;
+      f32 _ms;
+      u32 _depth;
+    };
+
+    // Needs a current GL context.
+    void Initialise();
+
+    void Shutdown();
+
+    bool IsSupported();
+
+    // Reads back the oldest frame in flight and starts recording a new one.
+    void BeginFrame();
+
+    // Pass names have to outlive the program, use string literals.
+    void Begin(char const* name);
+
+    void End();
+
+    struct scoped_pass final
+    {
+      explicit scoped_pass(char const* name) { Begin(name); }
+      ~scoped_pass() { End(); }
+
+      scoped_pass(scoped_pass const&) = delete;
+      scoped_pass& operator=(scoped_pass const&) = delete;
+    };
+
+    // Passes of the most recent frame whose results are available, in the order they began.
+    std::vector<pass_time> const& GetLastResults();
+  };
+};
@@ -4,6 +4,8 @@
 
 namespace lain
 {
+  struct render_snapshot;
+
   namespace level_editor
   {
     void Initialise();
@@ -12,6 +14,12 @@ namespace lain
 
     void Update(f32 const deltaTime);
 
-    void Render();
+    void FixedUpdate(f32 const deltaTime);
+
+    void BuildSnapshot(f32 const alpha, render_snapshot& snapshot);
+
+    void Render(render_snapshot const& snapshot);
+
+    void LoadLevel(char const* filename);
   };
 };
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "l_mesh.h"
+#include "l_types.h"
+
+#include <vector>
+
+namespace lain
+{
+  // ---------------------------------------------------------------------------
+  // Levels of detail. At import every mesh gets up to `kMaxLods` index lists,
+  // each about half the triangles of the one before, by collapsing edges in
+  // order of their quadric error (Garland-Heckbert). Collapses only ever move
+  // a vertex onto a neighbour, so all the levels share the mesh's vertices.
+  // Vertices on an open border or an attribute seam (UV or normal splits)
+  // stay where they are. At draw time the coarsest level whose error covers
+  // less than a pixel on screen is picked. No GL in here.
+  // ---------------------------------------------------------------------------
+  namespace lod
+  {
+    // Picking a level.
+    f32 constexpr kPixelError{1.f};
+    // Only go coarser once the error is that far under `kPixelError`, so a mesh sitting right at
+    // the threshold doesn't flip between two levels every frame.
+    f32 constexpr kHysteresis{0.75f};
+
+    // Stops at `targetIndexCount` or when the next collapse would move the surface by more than
+    // `targetError` (in the mesh's units), whichever comes first. `resultError` is the largest
+    // error it went to, measured as the root of the quadric's mean squared distance.
+    std::vector<u32> Simplify(std::vector<vertex_data> const& vertices,
+			      std::vector<u32> const& indices,
+			      u32 targetIndexCount,
+			      f32 targetError,
+			      f32& resultError);
+
+    // Appends the coarser levels to `mesh._indices` and fills in `mesh._lods`, the mesh's
+    // own indices are level 0. Every level is ordered for the vertex cache.
+    void Generate(mesh_data& mesh);
+
+    // `pixelsPerUnit` is how many pixels one unit of the mesh covers where it is, `current` is the
+    // level it was drawn with last time.
+    u32 Select(mesh_lod const* lods, u32 lodCount, f32 pixelsPerUnit, u32 current);
+  };
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+namespace lain
+{
+  // ---------------------------------------------------------------------------
+  // Read only view of a whole file. Memory mapped where the platform allows
+  // it, otherwise the file is read into a buffer, callers don't care which.
+  // ---------------------------------------------------------------------------
+  struct mapped_file final
+  {
+    std::byte const* _data;
+    std::size_t _size;
+  };
+
+  // Returns false if the file doesn't exist or can't be read. Empty files map to {nullptr, 0}.
+  bool MapFile(std::filesystem::path const& path, mapped_file& file);
+
+  void UnmapFile(mapped_file& file);
+};
@@ -24,6 +24,9 @@ namespace lain
 
   bool RayIntersectsAABB(ray const& ray, aabb const& aabb);
 
+  // Smallest AABB that contains `aabb` after being transformed by `m`.
+  aabb TransformAABB(aabb const& aabb, glm::mat4 const& m);
+
   glm::vec4 ScreenSpaceToNormalisedDeviceCoordinates(glm::vec4 const& pos, f32 width, f32 height);
 
   glm::vec4 NormalisedDeviceCoordinatesToClipSpace(glm::vec4 const& pos);
@@ -3,6 +3,7 @@
 #include "glm/ext/vector_float2.hpp"
 #include "glm/ext/vector_float3.hpp"
 
+#include "l_collision_mesh.h"
 #include "l_math.h"
 #include <string>
 #include <vector>
@@ -16,28 +17,96 @@ namespace lain
     glm::vec2 _texCoords;
   };
 
+  // How a mesh's vertices are laid out on the GPU. Packed is half the size,
+  // see vertex_packing.
+  enum class vertex_format
+    {
+      full,
+      packed
+    };
+
+  // What stays on the CPU once a mesh is uploaded: nothing, or positions for
+  // collision, see collision_mesh.
+  enum class mesh_residency
+    {
+      gpu_only,
+      collision
+    };
+
+  // A level of detail: a range of the mesh's indices drawing all of it with
+  // fewer triangles, over the same vertices. `_error` is how far (in the mesh's
+  // units) it strays from the full mesh at most.
+  struct mesh_lod final
+  {
+    u32 _firstIndex;
+    u32 _indexCount;
+    f32 _error;
+  };
+
+  u32 constexpr kMaxLods{6};
+
+  // A cluster of level 0's triangles, a range of its indices. Bounded by a
+  // sphere and by a cone around all its triangles' normals, both in the mesh's
+  // units, see cluster.
+  struct mesh_cluster final
+  {
+    u32 _firstIndex;
+    u32 _indexCount;
+    glm::vec3 _centre;
+    f32 _radius;
+    glm::vec3 _coneAxis;
+    f32 _coneCutoff; // sine of the cone's half angle, 1 when it can't ever be all back facing
+  };
+
   struct mesh_texture final
   {
     u32 _id;
     std::string _type;
-    std::string _path; // cache
+    std::string _path; // as the material has it in the mesh cache, normalised from the model's directory once loaded
   };
 
-  struct mesh final
+  // CPU side result of importing a mesh, it's what gets baked into the mesh
+  // cache. Texture ids stay 0 until the textures are loaded.
+  struct mesh_data final
   {
     std::vector<vertex_data> _vertices;
     std::vector<u32> _indices;
+    std::vector<mesh_texture> _textures;
+    aabb _boundingBox;
+    glm::vec3 _diffuseColour;
+    std::vector<mesh_lod> _lods; // finest first, empty means all the indices are the only one
+    std::vector<mesh_cluster> _clusters; // covering level 0, empty when it wasn't split
+  };
+
+  // Only the GPU copy and what drawing needs, the vertices and indices are
+  // dropped once they're uploaded.
+  struct mesh final
+  {
     std::vector<mesh_texture> _textures;
     aabb _boundingBox;
     glm::vec3 _diffuseColour;
     u32 _vao;
     u32 _vbo;
     u32 _ebo;
+    u32 _vertexCount;
+    u32 _indexType; // GL_UNSIGNED_SHORT when there are few enough vertices, GL_UNSIGNED_INT otherwise
+    mesh_lod _lods[kMaxLods];
+    u32 _lodCount;
+    std::vector<mesh_cluster> _clusters; // kept on the CPU to be culled every frame
+    glm::vec3 _positionOffset; // what the shaders scale positions by, identity unless packed
+    glm::vec3 _positionScale;
+    collision_mesh::collision_mesh_ref _collision; // empty unless kept for collision
 
     mesh(std::vector<vertex_data>&& vertices,
 	 std::vector<u32>&& indices,
 	 std::vector<mesh_texture>&& textures,
 	 glm::vec3 const& diffuseColour,
-	 aabb&& boundingBox);
+	 aabb&& boundingBox,
+	 vertex_format format = vertex_format::full,
+	 mesh_residency residency = mesh_residency::gpu_only);
+
+    explicit mesh(mesh_data&& data,
+		  vertex_format format = vertex_format::full,
+		  mesh_residency residency = mesh_residency::gpu_only);
   };
 };
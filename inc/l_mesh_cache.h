@@ -0,0 +1,37 @@
+#pragma once
+
+#include "l_mesh.h"
+#include "l_types.h"
+
+#include <filesystem>
+#include <vector>
+
+namespace lain
+{
+  // ---------------------------------------------------------------------------
+  // Baked meshes. The first time a model is imported its meshes are written
+  // out exactly as the renderer wants them, later launches map that file and
+  // copy the vertices straight out of it instead of going through Assimp.
+  // A cache file is thrown away when the format version or the hash of the
+  // source it was baked from don't match anymore. Indices are stored as u16
+  // whenever the mesh has few enough vertices, and the levels of detail and
+  // clusters are baked along with them. No GL in here.
+  // ---------------------------------------------------------------------------
+  namespace mesh_cache
+  {
+    // Bump whenever the file layout or the import settings change.
+    u32 constexpr kVersion{5};
+
+    // Hash of the model file plus the material library next to it with the same name.
+    u64 HashSource(std::filesystem::path const& source);
+
+    // ./res/cache/<path>.lmesh, "res/models/props/crate.obj" -> "./res/cache/models/props/crate.lmesh"
+    std::filesystem::path GetCachePath(std::filesystem::path const& source);
+
+    bool Write(std::filesystem::path const& file, u64 sourceHash, std::vector<mesh_data> const& meshes);
+
+    // Returns false if the file is missing, broken, from another version or baked
+    // from a different source, `meshes` is left empty then.
+    bool Read(std::filesystem::path const& file, u64 sourceHash, std::vector<mesh_data>& meshes);
+  };
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "l_mesh.h"
+#include "l_types.h"
+
+#include <vector>
+
+namespace lain
+{
+  // ---------------------------------------------------------------------------
+  // Reorders imported meshes for the GPU, once, before they're baked. Welding
+  // merges identical vertices (Assimp hands out one per face corner), then
+  // triangles are ordered for the post-transform vertex cache (Forsyth), runs
+  // of them are sorted outside in to cut overdraw, and finally vertices are
+  // laid out in the order they're first used. No GL in here.
+  // ---------------------------------------------------------------------------
+  namespace mesh_optimiser
+  {
+    // FIFO, about what current GPUs behave like.
+    u32 constexpr kCacheSize{16};
+
+    struct cache_stats final
+    {
+      f32 _acmr; // vertices transformed per triangle, 3 is the worst, ~0.5 the best
+      f32 _atvr; // vertices transformed per vertex, 1 is the best
+    };
+
+    cache_stats AnalyseVertexCache(std::vector<u32> const& indices, u32 vertexCount, u32 cacheSize = kCacheSize);
+
+    // Merges vertices that are identical to the bit, returns how many are left.
+    u32 WeldVertices(mesh_data& mesh);
+
+    void OptimiseVertexCache(std::vector<u32>& indices, u32 vertexCount);
+
+    // Sorts clusters of triangles so the ones facing away from the centre come first, as long
+    // as the ACMR stays within `threshold` of what it was.
+    void OptimiseOverdraw(std::vector<u32>& indices, std::vector<vertex_data> const& vertices, f32 threshold = 1.05f);
+
+    void OptimiseVertexFetch(mesh_data& mesh);
+
+    // All of the above, in that order. A mesh already split into clusters is ordered within each
+    // cluster, their ranges stay where they are.
+    void Optimise(mesh_data& mesh);
+  };
+};
@@ -1,22 +1,24 @@
 #pragma once
 
 #include "l_mesh.h"
+#include "l_pool.h"
 #include <string>
+#include <vector>
 
 namespace lain
 {
-  // --------------------------------------
-  // Define posible models to load in here.
-  // --------------------------------------
-  enum class model_type
-    {
-      ball,
-      maze
-    };
+  // Hash of the model's source path, see model_registry. The same in every run
+  // and every build, so it's what levels store.
+  using model_id = u32;
+
+  model_id constexpr kNoModel{0};
 
   struct model final
   {
-    std::vector<mesh> _meshes;
+    std::vector<handle<mesh>> _meshes; // resource_manager::GetMesh
     std::string _directory;
+    bool _isOccluder; // opaque, its triangles can hide what's behind them (needs the collision positions)
+    mesh_residency _residency; // what's kept on the CPU after the upload
+    bool _isResident; // false while a streamed model shows the placeholder
   };
 };
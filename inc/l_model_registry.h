@@ -0,0 +1,60 @@
+#pragma once
+
+#include "l_mesh.h"
+#include "l_model.h"
+#include "l_types.h"
+
+#include <filesystem>
+#include <string>
+
+namespace lain
+{
+  // What the registry knows about a model before it's loaded.
+  struct model_info final
+  {
+    model_id _id;
+    std::string _path; // normalised, "res/models/ball.obj"
+    std::string _name; // file name without the extension, for the editor
+    bool _isOccluder; // opaque, its triangles can hide what's behind them
+    mesh_residency _residency; // what's kept on the CPU after the upload
+  };
+
+  // ---------------------------------------------------------------------------
+  // Every model the game can use, found at startup instead of compiled in.
+  // `Load` reads the directory's `models.manifest` for the models that need
+  // flags and scans the directory (loose files and the mounted pack) for the
+  // rest. A model's id is the hash of its normalised path, so it doesn't depend
+  // on what else is there or in which order it was found. Ids are looked up in
+  // a flat open addressing table, models are kept in the order they were
+  // registered. Main thread only. No GL in here.
+  // ---------------------------------------------------------------------------
+  namespace model_registry
+  {
+    u32 constexpr kMaxModels{4096};
+    u32 constexpr kNotFound{~0u};
+
+    // Hash of the normalised path, "./res/models/ball.obj" and "res/models/ball.obj" are the same model.
+    // Never `kNoModel`.
+    model_id GetId(std::filesystem::path const& path);
+
+    // False when the manifest is broken or there are more models than `kMaxModels`, whatever was
+    // registered before that stays.
+    bool Load(std::filesystem::path const& directory);
+
+    // False if it's already registered under another path (two paths hashing the same) or the
+    // registry is full. Registering the same path again keeps the first one.
+    bool Add(model_info const& info);
+
+    void Clear();
+
+    // Registration order, `kNotFound` if there's no such model.
+    u32 GetIndex(model_id id);
+
+    u32 GetCount();
+
+    model_info const& Get(u32 index);
+
+    // nullptr if there's no such model.
+    model_info const* Find(model_id id);
+  };
+};
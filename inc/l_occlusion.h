@@ -0,0 +1,53 @@
+#pragma once
+
+#include "glm/ext/matrix_float4x4.hpp"
+#include "glm/ext/vector_float3.hpp"
+#include "l_math.h"
+#include "l_types.h"
+
+namespace lain
+{
+  // ---------------------------------------------------------------------------
+  // Software occlusion culling. Occluders are rasterised on the CPU into a
+  // small depth buffer, which is then reduced into a hierarchical-Z pyramid
+  // (farthest depth per texel). Occludees are tested by comparing the nearest
+  // depth of their screen-space bounds against the pyramid.
+  //
+  // Usage per frame: BeginFrame -> Rasterise* -> BuildHiZ -> IsVisible.
+  // No GL in here.
+  // ---------------------------------------------------------------------------
+  namespace occlusion
+  {
+    struct occlusion_stats final
+    {
+      u32 _occluders;
+      u32 _tested;
+      u32 _culled;
+      f32 _rasterMs; // rasterisation + pyramid build
+    };
+
+    // Width has to be a multiple of 4, both dimensions a power of two.
+    void Initialise(u32 width, u32 height);
+
+    void BeginFrame(glm::mat4 const& viewProjection);
+
+    // Rasterises the 12 triangles of `box` transformed by `model`. The box has to be
+    // completely solid (e.g. a wall) otherwise things behind it will get culled.
+    void RasteriseBox(aabb const& box, glm::mat4 const& model);
+
+    void RasteriseTriangles(glm::vec3 const* positions,
+			    u32 const* indices,
+			    u32 indexCount,
+			    glm::mat4 const& model);
+
+    void BuildHiZ();
+
+    // Conservative: anything that crosses the near plane is visible.
+    bool IsVisible(aabb const& worldBox);
+
+    occlusion_stats GetStats();
+
+    // Depth at the given texel of the full resolution buffer, [0, 1], 1 is the far plane.
+    f32 GetDepth(u32 x, u32 y);
+  };
+};
@@ -30,6 +30,6 @@ namespace lain
     std::vector<aabb> const& GetCollisionShapes(entity_id id);
 
     // Used for serialisation.
-    physics_component GetPhysicsComponent(entity_id id);
+    physics_component const& GetPhysicsComponent(entity_id id);
   };
 };
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+#include <new>
+#include <utility>
+
+#include "l_types.h"
+
+namespace lain
+{
+  // ---------------------------------------------------------------------------
+  // Generational handle into a `pool<T>`. A handle stays valid until the object
+  // it points to is destroyed, after that the slot's generation moves on and
+  // looking the handle up returns nullptr instead of whatever lives there now.
+  // A zeroed handle never points to anything.
+  // ---------------------------------------------------------------------------
+  template<typename T>
+  struct handle final
+  {
+    u32 _index;
+    u32 _generation;
+
+    bool IsValid() const { return _generation != 0; }
+
+    bool operator==(handle const&) const = default;
+  };
+
+  // ---------------------------------------------------------------------------
+  // Fixed capacity pool, the storage lives inside the pool itself so nothing is
+  // allocated after construction and objects never move. Creating and
+  // destroying are O(1) through an intrusive free list. Slots are handed out
+  // from the front, so `ForEach` walks a mostly dense array.
+  //
+  // A slot's generation is odd while it holds an object and even while it's
+  // free, both creating and destroying bump it.
+  // ---------------------------------------------------------------------------
+  template<typename T, u32 kCapacity>
+  struct pool final
+  {
+    pool() = default;
+
+    pool(pool const&) = delete;
+    pool& operator=(pool const&) = delete;
+
+    ~pool()
+    {
+      Clear();
+    }
+
+    template<typename... Args>
+    handle<T> Create(Args&&... args)
+    {
+      u32 index;
+
+      if (_freeHead != kNone) {
+	index = _freeHead;
+	_freeHead = _next[index];
+      } else if (_used < kCapacity) {
+	index = _used++;
+      } else {
+	std::cerr << __FUNCTION__ << ": pool is full (" << kCapacity << ")\n";
+	assert(false && "pool is full");
+	return {};
+      }
+
+      new (Slot(index)) T{std::forward<Args>(args)...};
+
+      ++_generations[index];
+      ++_count;
+
+      return {index, _generations[index]};
+    }
+
+    // Returns false for handles that don't point to anything anymore.
+    bool Destroy(handle<T> h)
+    {
+      if (!IsAlive(h)) {
+	std::cerr << __FUNCTION__ << ": dangling handle (" << h._index << ", " << h._generation << ")\n";
+	return false;
+      }
+
+      Slot(h._index)->~T();
+
+      ++_generations[h._index];
+      _next[h._index] = _freeHead;
+      _freeHead = h._index;
+      --_count;
+
+      return true;
+    }
+
+    bool IsAlive(handle<T> h) const
+    {
+      return h._index < _used && (h._generation & 1) != 0 && _generations[h._index] == h._generation;
+    }
+
+    T* Get(handle<T> h)
+    {
+      return IsAlive(h) ? Slot(h._index) : nullptr;
+    }
+
+    T const* Get(handle<T> h) const
+    {
+      return IsAlive(h) ? Slot(h._index) : nullptr;
+    }
+
+    // f(handle<T>, T&) for every live object, in slot order.
+    template<typename F>
+    void ForEach(F&& f)
+    {
+      for (u32 i{0}; i < _used; ++i) {
+	if ((_generations[i] & 1) != 0) {
+	  f(handle<T>{i, _generations[i]}, *Slot(i));
+	}
+      }
+    }
+
+    void Clear()
+    {
+      for (u32 i{0}; i < _used; ++i) {
+	if ((_generations[i] & 1) != 0) {
+	  Slot(i)->~T();
+	  ++_generations[i];
+	}
+      }
+
+      // Generations are kept so old handles stay dead.
+      _used = 0;
+      _count = 0;
+      _freeHead = kNone;
+    }
+
+    u32 GetCount() const { return _count; }
+
+    static constexpr u32 GetCapacity() { return kCapacity; }
+
+    static u32 constexpr kNone{~0u};
+
+    T* Slot(u32 index)
+    {
+      return std::launder(reinterpret_cast<T*>(_storage + index * sizeof(T)));
+    }
+
+    T const* Slot(u32 index) const
+    {
+      return std::launder(reinterpret_cast<T const*>(_storage + index * sizeof(T)));
+    }
+
+    alignas(T) std::byte _storage[sizeof(T) * kCapacity];
+    u32 _generations[kCapacity]{};
+    u32 _next[kCapacity];
+    u32 _used{0};     // slots [0, _used) have been handed out at least once
+    u32 _count{0};
+    u32 _freeHead{kNone};
+  };
+};
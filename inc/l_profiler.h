@@ -0,0 +1,69 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include "l_types.h"
+
+// Times the enclosing scope. Compiles to nothing unless LAIN_PROFILER is defined.
+#ifdef LAIN_PROFILER
+#define LAIN_PROFILE_CONCAT_(a, b) a##b
+#define LAIN_PROFILE_CONCAT(a, b) LAIN_PROFILE_CONCAT_(a, b)
+#define LAIN_PROFILE_ZONE(name) ::lain::profiler::scoped_zone LAIN_PROFILE_CONCAT(_profileZone, __LINE__){name}
+#else
+#define LAIN_PROFILE_ZONE(name)
+#endif
+
+namespace lain
+{
+  // ---------------------------------------------------------------------------
+  // CPU frame profiler. Every thread gets its own ring buffer of finished
+  // zones, written without locks or allocations. `BeginFrame` copies the zones
+  // of the frame that just ended out of the rings for the flame graph, and
+  // `ExportChromeTrace` writes everything still in the rings as Chrome trace
+  // JSON (open it in chrome://tracing or ui.perfetto.dev).
+  //
+  // Zone names have to outlive the program, use string literals.
+  // ---------------------------------------------------------------------------
+  namespace profiler
+  {
+    struct zone final
+    {
+      char const* _name;
+      u64 _start; // ns
+      u64 _end;   // ns
+      u32 _depth;
+      u32 _thread;
+    };
+
+    void BeginZone(char const* name);
+
+    void EndZone();
+
+    struct scoped_zone final
+    {
+      explicit scoped_zone(char const* name) { BeginZone(name); }
+      ~scoped_zone() { EndZone(); }
+
+      scoped_zone(scoped_zone const&) = delete;
+      scoped_zone& operator=(scoped_zone const&) = delete;
+    };
+
+    // Nanoseconds from an arbitrary starting point.
+    u64 Now();
+
+    // Call once per frame from the main thread, before any zone of the new frame.
+    void BeginFrame();
+
+    // Zones that started and ended during the last complete frame, sorted by
+    // thread and start time.
+    std::vector<zone> const& GetLastFrame();
+
+    // Start and end of the last complete frame.
+    u64 GetLastFrameStart();
+
+    u64 GetLastFrameEnd();
+
+    bool ExportChromeTrace(std::filesystem::path const& file);
+  };
+};
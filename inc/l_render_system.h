@@ -1,7 +1,10 @@
 #pragma once
 
 #include "glm/ext/matrix_float4x4.hpp"
+#include "l_culling.h"
 #include "l_entity_system.h"
+#include "l_occlusion.h"
+#include "l_pool.h"
 #include "l_types.h"
 #include <string>
 #include <vector>
@@ -18,32 +21,104 @@ namespace lain
     model const* _data;
   };
 
+  // Which mesh of which entity.
+  struct mesh_ref final
+  {
+    u32 _entity;
+    u32 _mesh;
+    u32 _lod; // level of detail it's drawn with, picked by BuildSnapshot
+    u32 _firstCommand; // its draws in render_snapshot::_commands
+    u32 _commandCount;
+    handle<mesh> _built; // the mesh the draws were built for, streaming can swap it before they're drawn
+  };
+
+  // One range of a mesh's indices, laid out like GL's DrawElementsIndirectCommand.
+  struct draw_command final
+  {
+    u32 _count;
+    u32 _instanceCount;
+    u32 _firstIndex;
+    i32 _baseVertex;
+    u32 _baseInstance;
+  };
+
+  // Triangles of the visible meshes for one frame.
+  struct lod_stats final
+  {
+    u32 _triangles; // as drawn, after the clusters were culled
+    u32 _fullDetailTriangles; // had they all been drawn whole at level 0
+  };
+
+  // ---------------------------------------------------------------------------
+  // Everything needed to draw the world for one frame, copied out of the
+  // simulation so it can be drawn while the next frame is being simulated.
+  // Read-only once built.
+  // ---------------------------------------------------------------------------
+  struct render_snapshot final
+  {
+    bool _valid; // false until something built it for the level editor
+    glm::mat4 _view;
+    glm::mat4 _viewProjection;
+    glm::vec3 _cameraPosition;
+    std::vector<glm::mat4> _models; // per entity
+    std::vector<mesh_ref> _visible; // sorted by entity
+    std::vector<draw_command> _commands;
+    culling::cull_stats _cullStats;
+    culling::cull_stats _clusterStats; // of the meshes drawn at level 0
+    lod_stats _lodStats;
+  };
+
   namespace render_system
   {
     void Initialise(f32 width, f32 height);
 
     void UseShader(u32 id);
 
-    void SetUniformMat4(u32 id, std::string const& uniname, glm::mat4 const& m);
+    void SetUniformMat4(u32 id, char const* uniname, glm::mat4 const& m);
 
-    void SetUniformVec2(u32 id, std::string const& uniname, glm::vec2 const& value);
+    void SetUniformVec2(u32 id, char const* uniname, glm::vec2 const& value);
 
-    void SetUniformVec3(u32 id, std::string const& uniname, glm::vec3 const& value);
+    void SetUniformVec3(u32 id, char const* uniname, glm::vec3 const& value);
 
-    void SetUniformVec4(u32 id, std::string const& uniname, glm::vec4 const& value);
+    void SetUniformVec4(u32 id, char const* uniname, glm::vec4 const& value);
 
-    void SetUniformInt(u32 id, std::string const& uniname, i32 value);
+    void SetUniformInt(u32 id, char const* uniname, i32 value);
 
-    void DrawEntities(camera3D const& camera);
+    void SetUniformFloat(u32 id, char const* uniname, f32 value);
 
-    void DrawLines(u32 id, u32 vao, u32 count, glm::mat4 const& view, glm::vec4 const& colour = glm::vec4(1.f));
+    // Transforms, camera, culling and the draws. No GL, safe to call from the simulation thread
+    // as long as nothing adds or removes entities meanwhile.
+    void BuildSnapshot(camera3D const& camera, render_snapshot& snapshot);
 
-    void DrawBoundingBox(u32 id, u32 vao, glm::mat4 const& view, glm::vec4 const& colour = glm::vec4(1.f));
+    void DrawEntities(render_snapshot const& snapshot);
 
-    void DrawBoundingBoxWithoutModel(u32 id, u32 vao, glm::mat4 const& view, glm::vec4 const& colour = glm::vec4(1.f));
+    void DrawLines(u32 id, u32 vao, u32 count, glm::mat4 const& view, glm::vec4 const& colour = glm::vec4(1.f));
 
     glm::mat4 GetCurrentProjectionMatrix();
 
+    // How many meshes were tested against the camera's frustum for the last snapshot drawn.
+    culling::cull_stats GetCullStats();
+
+    void SetOcclusionCulling(bool enabled);
+
+    bool IsOcclusionCullingEnabled();
+
+    // Triangles drawn for the last snapshot drawn.
+    lod_stats GetLodStats();
+
+    // Off draws everything at full detail.
+    void SetLod(bool enabled);
+
+    bool IsLodEnabled();
+
+    // How many clusters were tested for the last snapshot drawn.
+    culling::cull_stats GetClusterStats();
+
+    // Off draws meshes at level 0 whole.
+    void SetClusterCulling(bool enabled);
+
+    bool IsClusterCullingEnabled();
+
     void AddEntity(render_component&& r);
 
     void SetEntity(entity_id id, render_component&& r);
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "glad/glad.h"
+#include "glm/ext/vector_float3.hpp"
 #include "l_entity_system.h"
 #include "l_model.h"
+#include "l_pool.h"
+#include "l_texture_cache.h"
 #include "l_types.h"
 
 #include <filesystem>
@@ -10,15 +13,60 @@
 
 namespace lain
 {
-  class shader;
-  class texture;
+  struct shader;
+  struct texture;
 
   namespace resource_manager
   {
+    using shader_handle = handle<shader>;
+    using texture_handle = handle<texture>;
+    using model_handle = handle<model>;
+    using mesh_handle = handle<mesh>;
+
+    struct loading_progress final
+    {
+      u32 _done;
+      u32 _total; // grows while loading, textures are only found once their model is parsed
+    };
+
+    // Runs on the main thread every time a loaded asset has been uploaded.
+    using progress_callback = void (*)(loading_progress const& progress);
+
     // ---------------------------------------------------------------------------
     // Loads and compiles every shader needed by the game, loads audio files, etc.
+    // Models are only registered (see model_registry) and loaded when something
+    // places them. Models and images are parsed on the thread pool, only the GL
+    // uploads run on the main thread, so the thread pool has to be up first.
     // ---------------------------------------------------------------------------
-    void Initialise();
+    void Initialise(progress_callback onProgress = nullptr);
+
+    // Any thread.
+    loading_progress GetLoadingProgress();
+
+    // ---------------------------------------------------------------------------
+    // Streaming. When it's on (before `Initialise`), models aren't waited for:
+    // they show a placeholder cube (and textures a checkerboard) until
+    // `UpdateStreaming` has uploaded their data. Main thread only.
+    // ---------------------------------------------------------------------------
+    void SetStreaming(bool streaming);
+
+    bool IsStreaming();
+
+    // Returns right away. `position` is where the model is needed, the closest ones load first.
+    model_handle StreamModel(model_id const id, glm::vec3 const& position);
+
+    bool IsModelResident(model_id const id);
+
+    // Once per frame: hands pending requests to the workers, closest to `viewer` first,
+    // and spends about `budgetMs` on GL uploads (always at least one if any is ready).
+    void UpdateStreaming(glm::vec3 const& viewer, f32 const budgetMs);
+
+    // Textures are baked on first load (see texture_cache) and uploaded with all their mips from
+    // then on. Set before `Initialise`.
+    void SetTextureCompression(texture_cache::compression compression);
+
+    // Meshes are uploaded packed by default, see vertex_packing. Set before `Initialise`.
+    void SetVertexFormat(vertex_format format);
 
     bool LoadTextureFromFile(std::filesystem::path const& file,
 			     bool const flip,
@@ -28,12 +76,24 @@ namespace lain
 
     u32 LoadTextureFromFile(std::filesystem::path const& file);
 
+    // Hash lookup, keep the handle around instead of calling these every frame.
+    shader_handle GetShaderHandle(i32 const id);
+
+    texture_handle GetTextureHandle(i32 const id);
+
+    // nullptr when the handle is stale.
+    shader const* GetShader(shader_handle const handle);
+
+    texture const* GetTexture(texture_handle const handle);
+
+    mesh const* GetMesh(mesh_handle const handle);
+
     shader const* GetShader(i32 const id);
 
     texture const* GetTexture(i32 const id);
 
     // TODO: don't know about these, maybe they just don't belong here
-    void AddEntityModelRelationship(entity_id const id, model_type const type);
+    void AddEntityModelRelationship(entity_id const id, model_id const model);
 
     model const* GetModelDataFromEntity(entity_id const id);
 
@@ -45,8 +105,11 @@ namespace lain
 			 GLenum const usage,
 			 std::vector<u32> const& indices);
 
-    void LoadModel(model_type const type);
+    // Blocks until the model is resident, loading it first if nothing asked for it yet,
+    // streamed or not. For whatever can't live with the placeholder.
+    void LoadModel(model_id const id);
 
-    model_type GetModelType(entity_id const id);
+    // kNoModel if the entity hasn't got one.
+    model_id GetModelId(entity_id const id);
   };
 };
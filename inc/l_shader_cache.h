@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string_view>
+
+#include "l_types.h"
+
+namespace lain
+{
+  // ---------------------------------------------------------------------------
+  // Linked program binaries (glGetProgramBinary) kept on disk so the next start
+  // skips compiling and linking. A binary is only good for the driver that
+  // produced it, so the driver strings are part of the key along with the
+  // sources. Anything that doesn't load just means compiling again.
+  // ---------------------------------------------------------------------------
+  namespace shader_cache
+  {
+    u64 Hash(std::string_view vertexSource, std::string_view fragmentSource);
+
+    // Returns a linked program, or 0 when there's no usable binary for `hash`.
+    u32 Load(u64 hash);
+
+    // `program` has to be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+    void Save(u32 program, u64 hash);
+  };
+};
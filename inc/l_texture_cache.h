@@ -0,0 +1,114 @@
+#pragma once
+
+#include "l_mapped_file.h"
+#include "l_types.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <vector>
+
+namespace lain
+{
+  // ---------------------------------------------------------------------------
+  // Baked textures. The first time an image is loaded it's decoded, its whole
+  // mip chain is built and, optionally, block compressed, then written out in
+  // the layout the GPU wants. Later launches map that file and hand every
+  // level straight from the mapping to GL, no decoding and no
+  // glGenerateMipmap. Like the mesh cache, a file is rebaked when the format
+  // version or the hash of its source don't match. No GL in here.
+  // ---------------------------------------------------------------------------
+  namespace texture_cache
+  {
+    // Bump whenever the file layout, the mip filter or the encoders change.
+    u32 constexpr kVersion{1};
+
+    // 32768 x 32768, more than enough.
+    u32 constexpr kMaxLevels{16};
+
+    enum class texture_format : u32
+    {
+      rgba8, // uncompressed, 4 bytes per pixel
+      bc1,   // opaque RGB, 8 bytes per 4x4 block
+      bc3,   // RGB like BC1 plus 8 bytes of alpha, 16 bytes per block
+      bc7    // RGBA (mode 6 only), 16 bytes per block
+    };
+
+    // What the resource manager bakes into. `bc` is BC1 for opaque images and BC3 for ones
+    // with alpha, or BC7 if the driver has no S3TC.
+    enum class compression
+    {
+      none,
+      bc,
+      bc7
+    };
+
+    struct texture_level final
+    {
+      u32 _width;
+      u32 _height;
+      u64 _offset; // from the start of the file
+      u64 _size;
+    };
+
+    // ---------------------------------------------------------------------------
+    // A baked texture, either mapped from the cache (or the asset pack) or just
+    // baked in memory. Levels are offsets rather than pointers so it can be
+    // moved around freely, e.g. into an upload job. Give it back with `Release`.
+    // ---------------------------------------------------------------------------
+    struct baked_texture final
+    {
+      mapped_file _file{nullptr, 0};
+      std::vector<std::byte> _memory;
+      texture_format _format{texture_format::rgba8};
+      u32 _width{0};
+      u32 _height{0};
+      i32 _channels{0}; // of the source image, before it was expanded to RGBA
+      u32 _levelCount{0};
+      texture_level _levels[kMaxLevels];
+
+      std::byte const* GetLevelData(u32 level) const
+      {
+	return (_file._data != nullptr ? _file._data : _memory.data()) + _levels[level]._offset;
+      }
+    };
+
+    // Hash of the image file and whether it's flipped. The format isn't part of it, callers check
+    // `_format` after reading to see if it's still what they want.
+    u64 HashSource(std::filesystem::path const& source, bool flip);
+
+    // ./res/cache/textures/<path>.ltex, the source's path under res/ with its extension kept
+    std::filesystem::path GetCachePath(std::filesystem::path const& source, bool flip);
+
+    // Builds the mip chain of an RGBA8 image and encodes every level into `texture._memory`.
+    bool Bake(u8 const* rgba, u32 width, u32 height, i32 channels, texture_format format, u64 sourceHash,
+	      baked_texture& texture);
+
+    bool Write(std::filesystem::path const& file, baked_texture const& texture);
+
+    // Returns false if the file is missing, broken, from another version or baked from a
+    // different source.
+    bool Read(std::filesystem::path const& file, u64 sourceHash, baked_texture& texture);
+
+    void Release(baked_texture& texture);
+
+    u64 GetLevelSize(texture_format format, u32 width, u32 height);
+
+    // ---------------------------------------------------------------------------
+    // Whole levels. Blocks running over the edge repeat the last row and column.
+    // Decoding is only for tests and tools, the GPU does it at runtime.
+    // ---------------------------------------------------------------------------
+    void EncodeLevel(texture_format format, u8 const* rgba, u32 width, u32 height, std::byte* out);
+
+    void DecodeLevel(texture_format format, std::byte const* data, u32 width, u32 height, u8* rgba);
+
+    // Single 4x4 blocks, `rgba` is 16 pixels row by row.
+    void EncodeBC1(u8 const* rgba, std::byte* block);
+    void EncodeBC3(u8 const* rgba, std::byte* block);
+    void EncodeBC7(u8 const* rgba, std::byte* block);
+
+    void DecodeBC1(std::byte const* block, u8* rgba);
+    void DecodeBC3(std::byte const* block, u8* rgba);
+    // Blocks in modes other than 6 come out magenta.
+    void DecodeBC7(std::byte const* block, u8* rgba);
+  };
+};
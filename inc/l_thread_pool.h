@@ -0,0 +1,29 @@
+#pragma once
+
+#include <functional>
+
+#include "l_types.h"
+
+namespace lain
+{
+  // ---------------------------------------------------------------------------
+  // Worker threads for work that doesn't touch GL, mostly loading. Jobs run in
+  // the order they were submitted, as soon as a worker is free, and can submit
+  // more jobs themselves. Not meant for per frame work: submitting allocates.
+  // ---------------------------------------------------------------------------
+  namespace thread_pool
+  {
+    // 0 starts one worker per core, leaving one for the main thread, at least one.
+    void Initialise(u32 threadCount = 0);
+
+    // Finishes whatever is queued first.
+    void Shutdown();
+
+    void Submit(std::function<void()> job);
+
+    // Blocks until the queue is empty and no job is running.
+    void Wait();
+
+    u32 GetThreadCount();
+  };
+};
@@ -22,8 +22,8 @@ namespace lain
 
     void SetEntity(entity_id id, transform_component&& t);
 
-    // OPTIMISE: maybe returning a copy is expensive.
-    transform_component GetTransform(entity_id id);
+    // Invalidated by adding or removing entities.
+    transform_component const& GetTransform(entity_id id);
 
     void RemoveAllEntities();
 
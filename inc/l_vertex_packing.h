@@ -0,0 +1,52 @@
+#pragma once
+
+#include "l_mesh.h"
+#include "l_types.h"
+
+#include <vector>
+
+namespace lain
+{
+  // ---------------------------------------------------------------------------
+  // The packed vertex format, half the size of vertex_data. Positions are
+  // quantised to 16 bits per axis across the mesh's bounds and scaled back in
+  // the vertex shader, normals are octahedral encoded into two snorm16s and
+  // texture coordinates are half floats. GL unpacks all of it in the fetch,
+  // see SetupMesh. The CPU side is here so it can be tested without GL.
+  // ---------------------------------------------------------------------------
+  namespace vertex_packing
+  {
+    struct packed_vertex final
+    {
+      u16 _position[3]; // unorm16, across the quantisation's bounds
+      u16 _padding;
+      i16 _normal[2]; // snorm16, octahedral
+      u16 _texCoords[2]; // half floats
+    };
+
+    static_assert(sizeof(packed_vertex) == 16);
+
+    // position = _offset + unorm * _scale, what the shaders get as positionOffset and positionScale.
+    struct quantisation final
+    {
+      glm::vec3 _offset;
+      glm::vec3 _scale;
+    };
+
+    // Tightest bounds of the vertices, so every bit is spent on the mesh.
+    quantisation GetQuantisation(std::vector<vertex_data> const& vertices);
+
+    packed_vertex Pack(vertex_data const& vertex, quantisation const& quantisation);
+    vertex_data Unpack(packed_vertex const& vertex, quantisation const& quantisation);
+
+    std::vector<packed_vertex> Pack(std::vector<vertex_data> const& vertices, quantisation const& quantisation);
+
+    // Round to nearest even, out of range goes to infinity.
+    u16 FloatToHalf(f32 value);
+    f32 HalfToFloat(u16 half);
+
+    // Zero length normals come back as +z.
+    void EncodeOctahedral(glm::vec3 const& normal, i16 encoded[2]);
+    glm::vec3 DecodeOctahedral(i16 const encoded[2]);
+  };
+};
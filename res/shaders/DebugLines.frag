@@ -0,0 +1,9 @@
+#version 450 core
+
+out vec4 FragColour;
+
+in vec4 colour;
+
+void main() {
+  FragColour = colour;
+}
@@ -0,0 +1,13 @@
+#version 450 core
+
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec4 aColour;
+
+uniform mat4 viewProjection;
+
+out vec4 colour;
+
+void main() {
+  gl_Position = viewProjection * vec4(aPos, 1.f);
+  colour = aColour;
+}
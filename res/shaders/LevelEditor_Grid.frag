@@ -0,0 +1,68 @@
+#version 450 core
+
+out vec4 FragColour;
+
+in vec3 nearPoint;
+in vec3 farPoint;
+
+uniform mat4 viewProjection;
+uniform vec3 cameraPosition;
+uniform float gridSpacing;
+uniform float fadeDistance;
+uniform vec4 gridColour;
+uniform vec4 axisXColour;
+uniform vec4 axisZColour;
+
+// How much of this fragment is covered by lines `spacing` units apart, anti-aliased
+// using the screen space derivatives so lines are ~1 pixel wide at any distance.
+float GridCoverage(vec2 coord, float spacing) {
+  vec2 scaled = coord / spacing;
+  vec2 derivative = fwidth(scaled);
+  vec2 distanceToLine = abs(fract(scaled - 0.5f) - 0.5f) / derivative;
+  return 1.f - min(min(distanceToLine.x, distanceToLine.y), 1.f);
+}
+
+void main() {
+  // Intersect the view ray with the y = 0 plane.
+  float t = -nearPoint.y / (farPoint.y - nearPoint.y);
+
+  if (t <= 0.f) {
+    discard;
+  }
+
+  vec3 position = nearPoint + t * (farPoint - nearPoint);
+
+  // LOD: every time the camera goes 10x higher the grid becomes 10x coarser,
+  // the finer level fades out in between so there's no popping.
+  float height = max(abs(cameraPosition.y), 1.f);
+  float lod = max(log(height / 10.f) / log(10.f), 0.f);
+  float fineSpacing = gridSpacing * pow(10.f, floor(lod));
+  float blend = fract(lod);
+
+  float coverage = max(GridCoverage(position.xz, fineSpacing) * (1.f - blend),
+                       GridCoverage(position.xz, fineSpacing * 10.f));
+
+  vec4 colour = gridColour;
+  vec2 axisWidth = fwidth(position.xz);
+
+  if (abs(position.z) < axisWidth.y) {
+    colour = axisXColour;
+    coverage = 1.f;
+  } else if (abs(position.x) < axisWidth.x) {
+    colour = axisZColour;
+    coverage = 1.f;
+  }
+
+  float radius = fadeDistance * max(1.f, height / 10.f);
+  float fade = 1.f - smoothstep(radius * 0.25f, radius, distance(position.xz, cameraPosition.xz));
+  float alpha = colour.a * coverage * fade;
+
+  if (alpha < 0.01f) {
+    discard;
+  }
+
+  vec4 clip = viewProjection * vec4(position, 1.f);
+  gl_FragDepth = (clip.z / clip.w) * 0.5f + 0.5f;
+
+  FragColour = vec4(colour.rgb, alpha);
+}
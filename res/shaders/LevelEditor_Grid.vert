@@ -0,0 +1,21 @@
+#version 450 core
+
+// No vertex buffer, a single triangle that covers the whole screen.
+const vec2 positions[3] = vec2[](vec2(-1.f, -1.f), vec2(3.f, -1.f), vec2(-1.f, 3.f));
+
+uniform mat4 inverseViewProjection;
+
+out vec3 nearPoint;
+out vec3 farPoint;
+
+vec3 Unproject(vec2 position, float depth) {
+  vec4 world = inverseViewProjection * vec4(position, depth, 1.f);
+  return world.xyz / world.w;
+}
+
+void main() {
+  vec2 position = positions[gl_VertexID];
+  nearPoint = Unproject(position, -1.f);
+  farPoint = Unproject(position, 1.f);
+  gl_Position = vec4(position, 0.f, 1.f);
+}
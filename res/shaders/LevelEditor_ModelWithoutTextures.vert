@@ -1,16 +1,19 @@
-#version 460 core
+#version 450 core
 
 layout(location = 0) in vec3 aPos;
-layout(location = 1) in vec3 aNormal;
+layout(location = 1) in vec3 aNormal; // octahedral in xy when the mesh is packed
 layout(location = 2) in vec2 aTexCoord;
 
 uniform mat4 projection;
 uniform mat4 model;
 uniform mat4 view;
+// Packed meshes have their positions quantised across their bounds.
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
 
 out vec2 texCoord;
 
 void main() {
-  gl_Position = projection *  view * model * vec4(aPos, 1.f);
+  gl_Position = projection *  view * model * vec4(positionOffset + aPos * positionScale, 1.f);
   texCoord = aTexCoord;
 }
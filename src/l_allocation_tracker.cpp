@@ -0,0 +1,144 @@
+#include "l_allocation_tracker.h"
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+namespace lain
+{
+  namespace allocation_tracker
+  {
+    static char const* const kTagNames[kTagCount] = {
+      "other", "input", "update", "simulation", "render", "imgui", "resources"
+    };
+
+    // Atomic because the simulation and loader threads allocate too.
+    static std::atomic<u32> _allocations[kTagCount];
+    static std::atomic<u64> _bytes[kTagCount];
+    static thread_local tag _currentTag{tag::other};
+    static allocation_stats _lastFrame;
+    static bool _strict;
+    static u32 _warmupFrames;
+
+    static void Record(std::size_t size)
+    {
+      u32 const index{static_cast<u32>(_currentTag)};
+
+      _allocations[index].fetch_add(1, std::memory_order_relaxed);
+      _bytes[index].fetch_add(size, std::memory_order_relaxed);
+    }
+
+    scoped_tag::scoped_tag(tag t)
+      : _previous{_currentTag}
+    {
+      _currentTag = t;
+    }
+
+    scoped_tag::~scoped_tag()
+    {
+      _currentTag = _previous;
+    }
+
+    void BeginFrame()
+    {
+      u32 total{0};
+
+      for (u32 i{0}; i < kTagCount; ++i) {
+	_lastFrame._allocations[i] = _allocations[i].exchange(0, std::memory_order_relaxed);
+	_lastFrame._bytes[i] = _bytes[i].exchange(0, std::memory_order_relaxed);
+
+	// Streaming allocates whenever a model comes in, mostly on the workers, it isn't part of the frame.
+	if (i != static_cast<u32>(tag::resources)) {
+	  total += _lastFrame._allocations[i];
+	}
+      }
+
+      if (!_strict) {
+	return;
+      }
+
+      if (_warmupFrames > 0) {
+	--_warmupFrames;
+	return;
+      }
+
+      if (total > 0) {
+	std::cerr << __FUNCTION__ << ": steady state frame allocated " << total << " times:";
+
+	for (u32 i{0}; i < kTagCount; ++i) {
+	  if (_lastFrame._allocations[i] > 0 && i != static_cast<u32>(tag::resources)) {
+	    std::cerr << ' ' << kTagNames[i] << '=' << _lastFrame._allocations[i]
+		      << " (" << _lastFrame._bytes[i] << " bytes)";
+	  }
+	}
+
+	std::cerr << '\n';
+	assert(false && "steady state frame allocated");
+      }
+    }
+
+    allocation_stats const& GetLastFrameStats()
+    {
+      return _lastFrame;
+    }
+
+    void SetStrict(bool strict, u32 warmupFrames)
+    {
+      _strict = strict;
+      _warmupFrames = warmupFrames;
+    }
+
+    char const* GetTagName(tag t)
+    {
+      return kTagNames[static_cast<u32>(t)];
+    }
+
+    static void* Allocate(std::size_t size)
+    {
+      Record(size);
+
+      // Built without exceptions, so there's nothing to throw.
+      void* p{std::malloc(size > 0 ? size : 1)};
+
+      if (p == nullptr) {
+	std::abort();
+      }
+
+      return p;
+    }
+
+    static void* AllocateAligned(std::size_t size, std::align_val_t alignment)
+    {
+      Record(size);
+
+      std::size_t const align{static_cast<std::size_t>(alignment)};
+      // aligned_alloc wants the size to be a multiple of the alignment.
+      void* p{std::aligned_alloc(align, (size + align - 1) / align * align)};
+
+      if (p == nullptr) {
+	std::abort();
+      }
+
+      return p;
+    }
+  };
+};
+
+using namespace lain;
+
+void* operator new(std::size_t size) { return allocation_tracker::Allocate(size); }
+void* operator new[](std::size_t size) { return allocation_tracker::Allocate(size); }
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept { return allocation_tracker::Allocate(size); }
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept { return allocation_tracker::Allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocation_tracker::AllocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return allocation_tracker::AllocateAligned(size, alignment); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
@@ -1,19 +1,44 @@
 #include "l_application.h"
+#include "l_allocation_tracker.h"
+#include "l_asset_pack.h"
 #include "SDL2/SDL.h"
 #include "SDL_video.h"
 #include "glad/glad.h"
 #include "imgui.h"
 #include "imgui_impl_opengl3.h"
 #include "imgui_impl_sdl2.h"
+#include "l_debug_draw.h"
+#include "l_event_manager.h"
+#include "l_frame_arena.h"
+#include "l_frame_stats.h"
 #include "l_game.h"
+#include "l_gl_state.h"
+#include "l_gpu_timer.h"
 #include "l_input_manager.h"
+#include "l_level_editor.h"
 #include "l_platform.h"
+#include "l_profiler.h"
 #include "l_render_system.h"
 #include "l_resource_manager.h"
 #include "l_physics_system.h"
+#include "l_thread_pool.h"
 #include "l_transform_system.h"
+#include <algorithm>
 #include <chrono>
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef LAIN_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+#endif
 
 namespace lain
 {
@@ -32,8 +57,61 @@ namespace lain
     static i32 _SDLWindowFlags{SDL_WINDOW_OPENGL | SDL_WINDOW_INPUT_FOCUS | SDL_WINDOW_INPUT_GRABBED};
     static SDL_GLContext _context;
 
-    static f32 Time();
+    static std::string _frameStatsFile;
+
+    static std::size_t constexpr kFrameArenaSize{4 * 1024 * 1024};
+    static char const* const kAssetPack{"./res.pak"};
+    // GL uploads for streamed assets per frame.
+    static f32 constexpr kStreamingBudgetMs{2.f};
+
+    // Frame pacing
+    static f32 constexpr kFixedDeltaTime{1.f / 60.f};
+    static f32 constexpr kMaxFrameDelta{0.25f};
+    // sleep_for overshoots by up to a millisecond or so, the last stretch is spun.
+    static u64 constexpr kSpinNanoseconds{1'500'000};
+    static vsync_mode _vsync{vsync_mode::on};
+    static f32 _frameRateLimit{0.f}; // 0 is unlimited
+    static u64 _nextFrameDeadline;
+
+    // Simulation. When pipelined, the simulation thread builds the snapshot for
+    // the next frame while the main thread draws `_snapshots[_front]`.
+    static render_snapshot _snapshots[2];
+    static u32 _front{0};
+    static f32 _accumulator{0.f};
+    static bool _pipelined{true};
+    static std::thread _simulationThread;
+    static std::mutex _simulationMutex;
+    static std::condition_variable _simulationCondition;
+    static bool _simulationKicked{false};  // work is waiting for the thread
+    static bool _simulationBusy{false};    // kicked and not finished yet
+    static bool _simulationQuit{false};
+    static bool _simulationPending{false}; // main thread only, kicked since the last wait
+    static f32 _simulationDeltaTime{0.f};
+
+    // Headless
+    static bool _isHeadless{false};
+    static u32 _headlessFrames{0};
+    static u32 _framebuffer{0};
+    static u32 _colourRenderbuffer{0};
+    static u32 _depthRenderbuffer{0};
+#ifdef LAIN_HAS_EGL
+    static EGLDisplay _eglDisplay{EGL_NO_DISPLAY};
+    static EGLContext _eglContext{EGL_NO_CONTEXT};
+#endif
+
+    static bool InitialiseEngine(GLADloadproc loader);
     static void InitialiseImGui();
+    static void PollEvents();
+    static void LimitFrameRate();
+    static void Simulate(f32 deltaTime, render_snapshot& snapshot);
+    static void SimulationThread();
+    static void StartSimulationThread();
+    static void StopSimulationThread();
+    static void KickSimulation(f32 deltaTime);
+    static bool WaitForSimulation();
+    static bool CreateSurfacelessContext();
+    static bool CreateOffscreenFramebuffer();
+    static void PrintTimingReport(std::vector<f32>& frameTimes);
     static input_manager::key SDLKeyToEngine(i32 key);
     static input_manager::mouse_button SDLMouseButtonToEngine(i32 mouseButton);
 
@@ -100,36 +178,47 @@ namespace lain
 
       SDL_GL_MakeCurrent(_window, _context);
 
-      SDL_GL_SetSwapInterval(1);
+      SetVsync(_vsync);
 
-      if (!gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress)) {
-	std::cerr << __FUNCTION__ << ": failed to initialise GLAD\n";
+      return InitialiseEngine((GLADloadproc)SDL_GL_GetProcAddress);
+    }
+
+    bool InitialiseHeadless(headless_options const& options)
+    {
+      _isHeadless = true;
+      _width = options._width;
+      _height = options._height;
+      _headlessFrames = options._frames;
+
+      if (!CreateSurfacelessContext()) {
 	return false;
       }
 
-      // -----
-      // ImGui
-      // -----
-      InitialiseImGui();
+#ifdef LAIN_HAS_EGL
+      if (!InitialiseEngine((GLADloadproc)eglGetProcAddress)) {
+	return false;
+      }
+#endif
 
-      // -------------
-      // OpenGL stuff
-      // -------------
-      glEnable(GL_CULL_FACE);
-      glEnable(GL_DEPTH_TEST);
+      // Everything renders into this, nothing else binds framebuffers.
+      if (!CreateOffscreenFramebuffer()) {
+	return false;
+      }
 
-      // --------------------------
-      // Game stuff initialisation
-      // --------------------------
-      game::Initialise();
-      resource_manager::Initialise();
-      render_system::Initialise(_width, _height);
+      if (!options._level.empty()) {
+	event_manager::Post(event(event_type::main_menu_click_level_editor));
+	level_editor::LoadLevel(options._level.c_str());
+      }
 
       return true;
     }
 
     void ToggleFullScreen()
     {
+      if (_isHeadless) {
+	return;
+      }
+
       _isInFullScreen = !_isInFullScreen;
       i32 const flags{_isInFullScreen ? SDL_WINDOW_FULLSCREEN_DESKTOP : 0};
       SDL_SetWindowFullscreen(_window, flags);
@@ -137,9 +226,51 @@ namespace lain
 
     void Shutdown()
     {
-      ImGui_ImplOpenGL3_Shutdown();
-      ImGui_ImplSDL2_Shutdown();
-      ImGui::DestroyContext();
+      StopSimulationThread();
+
+      if (!_frameStatsFile.empty()) {
+	frame_stats::Export(_frameStatsFile);
+      }
+
+      gpu_timer::Shutdown();
+
+      frame_arena::Shutdown();
+
+      thread_pool::Shutdown();
+
+      asset_pack::Unmount();
+
+      if (ImGui::GetCurrentContext() != nullptr) {
+	ImGui_ImplOpenGL3_Shutdown();
+
+	if (!_isHeadless) {
+	  ImGui_ImplSDL2_Shutdown();
+	}
+
+	ImGui::DestroyContext();
+      }
+
+      if (_isHeadless) {
+	if (_framebuffer != 0) {
+	  glDeleteFramebuffers(1, &_framebuffer);
+	  glDeleteRenderbuffers(1, &_colourRenderbuffer);
+	  glDeleteRenderbuffers(1, &_depthRenderbuffer);
+	}
+
+#ifdef LAIN_HAS_EGL
+	if (_eglDisplay != EGL_NO_DISPLAY) {
+	  eglMakeCurrent(_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+	  if (_eglContext != EGL_NO_CONTEXT) {
+	    eglDestroyContext(_eglDisplay, _eglContext);
+	  }
+
+	  eglTerminate(_eglDisplay);
+	}
+#endif
+
+	return;
+      }
 
       SDL_GL_DeleteContext(_context);
 
@@ -152,61 +283,228 @@ namespace lain
 
     void Run()
     {
-      f32 lastFrame{0.f};
+      std::vector<f32> frameTimes;
+
+      frameTimes.reserve(_headlessFrames);
+
+      u64 lastFrame{profiler::Now()};
+
+      _nextFrameDeadline = lastFrame;
+      _accumulator = 0.f;
+
+      // So the first frame has something to draw.
+      Simulate(0.f, _snapshots[_front]);
 
       while (!game::IsShuttingDown()) {
-	f32 const currFrame{Time()};
-	f32 const deltaTime{currFrame - lastFrame};
-	lastFrame = currFrame;
+	u64 const frameStart{profiler::Now()};
+	// Clamped so a long stall (breakpoint, window drag) doesn't turn into hundreds of fixed updates.
+	f32 const deltaTime{std::min((frameStart - lastFrame) / 1e9f, kMaxFrameDelta)};
+	lastFrame = frameStart;
+
+	u64 phaseStart{frameStart};
+	frame_stats::frame_timings timings{};
+
+	// Milliseconds since the previous call (or the start of the frame).
+	auto const phase = [&phaseStart]() {
+	  u64 const now{profiler::Now()};
+	  f32 const ms{(now - phaseStart) / 1e6f};
+	  phaseStart = now;
+	  return ms;
+	};
+
+	profiler::BeginFrame();
+
+	// The snapshot the simulation thread built last frame is the one we draw now.
+	if (WaitForSimulation()) {
+	  _front = 1 - _front;
+	}
+
+	// Only switch while the simulation thread is idle.
+	if (_pipelined != _simulationThread.joinable()) {
+	  _pipelined ? StartSimulationThread() : StopSimulationThread();
+	}
+
+	// After the wait, so the simulation's allocations count towards the frame they belong to.
+	allocation_tracker::BeginFrame();
+
+	phase();
+
+	frame_arena::BeginFrame();
 
 	input_manager::BeginFrame();
 
+	gl_state::BeginFrame();
+
+	gpu_timer::BeginFrame();
+
+	debug_draw::BeginFrame();
+
 	glViewport(0, 0, _width, _height);
 
-	SDL_Event event;
+	{
+	  allocation_tracker::scoped_tag const tag{allocation_tracker::tag::input};
 
-	while (SDL_PollEvent(&event)) {
-	  ImGui_ImplSDL2_ProcessEvent(&event);
+	  if (!_isHeadless) {
+	    LAIN_PROFILE_ZONE("PollEvents");
 
-	  if (event.type == SDL_QUIT) {
-	    game::ForceShutdown();
+	    PollEvents();
 	  }
 
-	  bool const userForcesShutdown{event.type == SDL_WINDOWEVENT &&
-					event.window.event == SDL_WINDOWEVENT_CLOSE &&
-					event.window.windowID == SDL_GetWindowID(_window)};
+	  game::ProcessInput();
+	}
 
-	  if (userForcesShutdown) {
-	    game::ForceShutdown();
-	  }
+	timings._input = phase();
 
-	  if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {
-	    auto const key = SDLKeyToEngine(event.key.keysym.sym);
-	    bool const isPressed{event.type == SDL_KEYDOWN};
-	    input_manager::UpdateKey(key, isPressed);
-	  }
+	{
+	  allocation_tracker::scoped_tag const tag{allocation_tracker::tag::update};
 
-	  if (event.type == SDL_MOUSEMOTION) {
-	    input_manager::UpdateCursorPosition(glm::vec2(event.motion.xrel, -event.motion.yrel));
-	    input_manager::SetCursorIsMoving();
+	  // Everything that adds or removes entities happens in here, never while simulating.
+	  game::Update(deltaTime);
+
+	  // Swaps streamed meshes in, so it has to happen while the simulation is idle as well.
+	  resource_manager::UpdateStreaming(_snapshots[_front]._cameraPosition, kStreamingBudgetMs);
+
+	  if (_simulationThread.joinable()) {
+	    KickSimulation(deltaTime);
+	  } else {
+	    Simulate(deltaTime, _snapshots[_front]);
 	  }
+	}
+
+	timings._update = phase();
 
-	  if (event.type == SDL_MOUSEBUTTONDOWN || event.type == SDL_MOUSEBUTTONUP) {
-	    input_manager::mouse_button const button{SDLMouseButtonToEngine(event.button.button)};
-	    input_manager::UpdateMouseButton(button, event.type == SDL_MOUSEBUTTONDOWN);
+	{
+	  allocation_tracker::scoped_tag const tag{allocation_tracker::tag::render};
+
+	  game::Render(_snapshots[_front]);
+	}
+
+	timings._render = phase();
+
+	if (_isHeadless) {
+	  LAIN_PROFILE_ZONE("glFinish");
+
+	  // Nothing to swap, wait for the GPU so the frame time includes its work.
+	  glFinish();
+	} else {
+	  LAIN_PROFILE_ZONE("SDL_GL_SwapWindow");
+
+	  SDL_GL_SwapWindow(_window);
+	}
+
+	timings._swap = phase();
+	timings._total = (phaseStart - frameStart) / 1e6f;
+
+	frame_stats::Record(timings);
+
+	if (_isHeadless) {
+	  frameTimes.push_back(timings._total);
+
+	  if (frameTimes.size() == _headlessFrames) {
+	    game::ForceShutdown();
 	  }
 	}
 
-	game::ProcessInput();
+	if (_frameRateLimit > 0.f) {
+	  LAIN_PROFILE_ZONE("LimitFrameRate");
+
+	  LimitFrameRate();
+	}
+      }
+
+      if (_isHeadless) {
+	PrintTimingReport(frameTimes);
+      }
+    }
+
+    void SetVsync(vsync_mode mode)
+    {
+      _vsync = mode;
 
-	game::Update(deltaTime);
+      if (_isHeadless || _context == nullptr) {
+	return;
+      }
 
-	game::Render();
+      i32 const interval{mode == vsync_mode::off ? 0 : mode == vsync_mode::on ? 1 : -1};
 
-	SDL_GL_SwapWindow(_window);
+      if (SDL_GL_SetSwapInterval(interval) != 0) {
+	std::cerr << __FUNCTION__ << ": swap interval " << interval << " not supported, using vsync on: "
+		  << SDL_GetError() << '\n';
+
+	_vsync = vsync_mode::on;
+	SDL_GL_SetSwapInterval(1);
       }
     }
 
+    vsync_mode GetVsync()
+    {
+      return _vsync;
+    }
+
+    void SetFrameRateLimit(f32 framesPerSecond)
+    {
+      _frameRateLimit = std::max(framesPerSecond, 0.f);
+      _nextFrameDeadline = profiler::Now();
+    }
+
+    f32 GetFrameRateLimit()
+    {
+      return _frameRateLimit;
+    }
+
+    void SetPipelined(bool pipelined)
+    {
+      _pipelined = pipelined;
+    }
+
+    bool IsPipelined()
+    {
+      return _pipelined;
+    }
+
+    void SetStrictAllocations(bool strict)
+    {
+      allocation_tracker::SetStrict(strict);
+    }
+
+    void SetStreamAssets(bool stream)
+    {
+      resource_manager::SetStreaming(stream);
+    }
+
+    void SetTextureCompression(texture_cache::compression compression)
+    {
+      resource_manager::SetTextureCompression(compression);
+    }
+
+    void SetVertexFormat(vertex_format format)
+    {
+      resource_manager::SetVertexFormat(format);
+    }
+
+    void SetFrameStatsFile(std::string&& file)
+    {
+      _frameStatsFile = std::move(file);
+    }
+
+    void NewImGuiFrame()
+    {
+      LAIN_PROFILE_ZONE("ImGui::NewFrame");
+      allocation_tracker::scoped_tag const tag{allocation_tracker::tag::imgui};
+
+      ImGui_ImplOpenGL3_NewFrame();
+
+      if (_isHeadless) {
+	ImGuiIO& io = ImGui::GetIO();
+	io.DisplaySize = ImVec2(static_cast<f32>(_width), static_cast<f32>(_height));
+	io.DeltaTime = 1.f / 60.f;
+      } else {
+	ImGui_ImplSDL2_NewFrame();
+      }
+
+      ImGui::NewFrame();
+    }
+
     f32 GetWindowWidth()
     {
       return static_cast<f32>(_width);
@@ -219,14 +517,54 @@ namespace lain
 
     void SetWindowTitle(std::string&& newTitle)
     {
+      if (_isHeadless) {
+	return;
+      }
+
       SDL_SetWindowTitle(_window, newTitle.c_str());
     }
 
-    static f32 Time()
+    static bool InitialiseEngine(GLADloadproc loader)
     {
-      using namespace std::chrono;
-      static const auto start = high_resolution_clock::now();
-      return duration<f32>(high_resolution_clock::now() - start).count();
+      if (!gladLoadGLLoader(loader)) {
+	std::cerr << __FUNCTION__ << ": failed to initialise GLAD\n";
+	return false;
+      }
+
+      gl_state::Initialise();
+
+      gpu_timer::Initialise();
+
+      frame_arena::Initialise(kFrameArenaSize);
+
+      // Loading runs on it, see resource_manager::Initialise.
+      thread_pool::Initialise();
+
+      // Optional, built by the pack_assets tool. Loose files are used for whatever isn't in there.
+      if (asset_pack::Mount(kAssetPack)) {
+	std::cout << __FUNCTION__ << ": using " << kAssetPack << '\n';
+      }
+
+      // -----
+      // ImGui
+      // -----
+      InitialiseImGui();
+
+      // -------------
+      // OpenGL stuff
+      // -------------
+      glEnable(GL_CULL_FACE);
+      glEnable(GL_DEPTH_TEST);
+
+      // --------------------------
+      // Game stuff initialisation
+      // --------------------------
+      game::Initialise();
+      resource_manager::Initialise();
+      render_system::Initialise(_width, _height);
+      debug_draw::Initialise();
+
+      return true;
     }
 
     static void InitialiseImGui()
@@ -236,10 +574,274 @@ namespace lain
       ImGuiIO& io = ImGui::GetIO();
       io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
       io.ConfigFlags |= ImGuiConfigFlags_NavEnableSetMousePos;
-      ImGui_ImplSDL2_InitForOpenGL(_window, _context);
+
+      if (_isHeadless) {
+	// Don't write imgui.ini from benchmark runs.
+	io.IniFilename = nullptr;
+      } else {
+	ImGui_ImplSDL2_InitForOpenGL(_window, _context);
+      }
+
       ImGui_ImplOpenGL3_Init();
     }
 
+    static void PollEvents()
+    {
+      SDL_Event event;
+
+      while (SDL_PollEvent(&event)) {
+	ImGui_ImplSDL2_ProcessEvent(&event);
+
+	if (event.type == SDL_QUIT) {
+	  game::ForceShutdown();
+	}
+
+	bool const userForcesShutdown{event.type == SDL_WINDOWEVENT &&
+				      event.window.event == SDL_WINDOWEVENT_CLOSE &&
+				      event.window.windowID == SDL_GetWindowID(_window)};
+
+	if (userForcesShutdown) {
+	  game::ForceShutdown();
+	}
+
+	if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {
+	  auto const key = SDLKeyToEngine(event.key.keysym.sym);
+	  bool const isPressed{event.type == SDL_KEYDOWN};
+	  input_manager::UpdateKey(key, isPressed);
+	}
+
+	if (event.type == SDL_MOUSEMOTION) {
+	  input_manager::UpdateCursorPosition(glm::vec2(event.motion.xrel, -event.motion.yrel));
+	  input_manager::SetCursorIsMoving();
+	}
+
+	if (event.type == SDL_MOUSEBUTTONDOWN || event.type == SDL_MOUSEBUTTONUP) {
+	  input_manager::mouse_button const button{SDLMouseButtonToEngine(event.button.button)};
+	  input_manager::UpdateMouseButton(button, event.type == SDL_MOUSEBUTTONDOWN);
+	}
+      }
+    }
+
+    static void LimitFrameRate()
+    {
+      u64 const period{static_cast<u64>(1e9f / _frameRateLimit)};
+      u64 now{profiler::Now()};
+
+      _nextFrameDeadline += period;
+
+      // Too far behind (e.g. the limit is higher than what we can do), don't try to catch up.
+      if (_nextFrameDeadline + period < now) {
+	_nextFrameDeadline = now;
+	return;
+      }
+
+      while (now < _nextFrameDeadline) {
+	u64 const remaining{_nextFrameDeadline - now};
+
+	if (remaining > kSpinNanoseconds) {
+	  std::this_thread::sleep_for(std::chrono::nanoseconds(remaining - kSpinNanoseconds));
+	}
+
+	now = profiler::Now();
+      }
+    }
+
+    static void Simulate(f32 deltaTime, render_snapshot& snapshot)
+    {
+      LAIN_PROFILE_ZONE("Simulate");
+      allocation_tracker::scoped_tag const tag{allocation_tracker::tag::simulation};
+
+      _accumulator += deltaTime;
+
+      while (_accumulator >= kFixedDeltaTime) {
+	game::FixedUpdate(kFixedDeltaTime);
+	_accumulator -= kFixedDeltaTime;
+      }
+
+      game::BuildSnapshot(_accumulator / kFixedDeltaTime, snapshot);
+    }
+
+    static void SimulationThread()
+    {
+      std::unique_lock lock{_simulationMutex};
+
+      while (true) {
+	_simulationCondition.wait(lock, [] { return _simulationKicked || _simulationQuit; });
+
+	if (_simulationQuit) {
+	  return;
+	}
+
+	_simulationKicked = false;
+	lock.unlock();
+
+	// The main thread is drawing `_front` and won't touch `_front` until we're done.
+	Simulate(_simulationDeltaTime, _snapshots[1 - _front]);
+
+	lock.lock();
+	_simulationBusy = false;
+	_simulationCondition.notify_all();
+      }
+    }
+
+    static void StartSimulationThread()
+    {
+      _simulationQuit = false;
+      _simulationThread = std::thread(SimulationThread);
+    }
+
+    static void StopSimulationThread()
+    {
+      if (!_simulationThread.joinable()) {
+	return;
+      }
+
+      WaitForSimulation();
+
+      {
+	std::lock_guard lock{_simulationMutex};
+	_simulationQuit = true;
+      }
+
+      _simulationCondition.notify_all();
+      _simulationThread.join();
+    }
+
+    static void KickSimulation(f32 deltaTime)
+    {
+      {
+	std::lock_guard lock{_simulationMutex};
+	_simulationDeltaTime = deltaTime;
+	_simulationKicked = true;
+	_simulationBusy = true;
+      }
+
+      _simulationPending = true;
+      _simulationCondition.notify_all();
+    }
+
+    static bool WaitForSimulation()
+    {
+      if (!_simulationPending) {
+	return false;
+      }
+
+      LAIN_PROFILE_ZONE("WaitForSimulation");
+
+      std::unique_lock lock{_simulationMutex};
+      _simulationCondition.wait(lock, [] { return !_simulationBusy; });
+      _simulationPending = false;
+
+      return true;
+    }
+
+    static bool CreateSurfacelessContext()
+    {
+#ifdef LAIN_HAS_EGL
+      auto const getPlatformDisplay{
+	reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"))};
+
+      if (getPlatformDisplay != nullptr) {
+	_eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+      }
+
+      if (_eglDisplay == EGL_NO_DISPLAY) {
+	_eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+      }
+
+      EGLint major, minor;
+
+      if (_eglDisplay == EGL_NO_DISPLAY || eglInitialize(_eglDisplay, &major, &minor) != EGL_TRUE) {
+	std::cerr << __FUNCTION__ << ": couldn't initialise EGL display\n";
+	return false;
+      }
+
+      if (eglBindAPI(EGL_OPENGL_API) != EGL_TRUE) {
+	std::cerr << __FUNCTION__ << ": EGL doesn't support desktop OpenGL\n";
+	return false;
+      }
+
+      EGLint const configAttributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+      EGLConfig config{nullptr};
+      EGLint configCount{0};
+
+      // Surfaceless displays may not have any config at all, that's fine, we never create a surface.
+      eglChooseConfig(_eglDisplay, configAttributes, &config, 1, &configCount);
+
+      // Software drivers (llvmpipe) stop at 4.5, none of our shaders need more.
+      for (i32 const minorVersion : {kOpenGLMinorVersion, 5}) {
+	EGLint const contextAttributes[] = {
+	  EGL_CONTEXT_MAJOR_VERSION, kOpenGLMajorVersion,
+	  EGL_CONTEXT_MINOR_VERSION, minorVersion,
+	  EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+	  EGL_NONE
+	};
+
+	_eglContext = eglCreateContext(_eglDisplay, configCount > 0 ? config : nullptr, EGL_NO_CONTEXT, contextAttributes);
+
+	if (_eglContext != EGL_NO_CONTEXT) {
+	  break;
+	}
+      }
+
+      if (_eglContext == EGL_NO_CONTEXT) {
+	std::cerr << __FUNCTION__ << ": couldn't create an OpenGL " << kOpenGLMajorVersion << ".5+ context\n";
+	return false;
+      }
+
+      if (eglMakeCurrent(_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, _eglContext) != EGL_TRUE) {
+	std::cerr << __FUNCTION__ << ": couldn't make the surfaceless context current\n";
+	return false;
+      }
+
+      return true;
+#else
+      std::cerr << __FUNCTION__ << ": built without EGL, headless mode isn't available\n";
+      return false;
+#endif
+    }
+
+    static bool CreateOffscreenFramebuffer()
+    {
+      glGenFramebuffers(1, &_framebuffer);
+      glGenRenderbuffers(1, &_colourRenderbuffer);
+      glGenRenderbuffers(1, &_depthRenderbuffer);
+
+      glBindRenderbuffer(GL_RENDERBUFFER, _colourRenderbuffer);
+      glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, _width, _height);
+
+      glBindRenderbuffer(GL_RENDERBUFFER, _depthRenderbuffer);
+      glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, _width, _height);
+
+      glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+      glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _colourRenderbuffer);
+      glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthRenderbuffer);
+
+      if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+	std::cerr << __FUNCTION__ << ": offscreen framebuffer is incomplete\n";
+	return false;
+      }
+
+      return true;
+    }
+
+    static void PrintTimingReport(std::vector<f32>& frameTimes)
+    {
+      if (frameTimes.empty()) {
+	return;
+      }
+
+      auto const summary = frame_stats::Summarise(frameTimes.data(), static_cast<u32>(frameTimes.size()));
+
+      std::cout << "headless: " << summary._count << " frames at " << _width << 'x' << _height
+		<< " (" << reinterpret_cast<char const*>(glGetString(GL_RENDERER)) << ")\n"
+		<< "  total " << summary._average * summary._count / 1000.f << " s, avg " << summary._average
+		<< " ms (" << 1000.f / summary._average << " fps)\n"
+		<< "  min " << summary._min << " ms, p50 " << summary._p50 << " ms, p95 " << summary._p95
+		<< " ms, p99 " << summary._p99 << " ms, max " << summary._max << " ms, "
+		<< summary._stutters << " stutters\n";
+    }
+
     static input_manager::key SDLKeyToEngine(i32 key) {
       switch (key) {
       case SDLK_w:
@@ -282,11 +884,19 @@ namespace lain
 
   void ConstrainCursorInWindow()
   {
+    if (application::_isHeadless) {
+      return;
+    }
+
     SDL_SetRelativeMouseMode(SDL_TRUE);
   }
 
   void ReleaseCursorFromWindow()
   {
+    if (application::_isHeadless) {
+      return;
+    }
+
     SDL_SetRelativeMouseMode(SDL_FALSE);
   }
 };
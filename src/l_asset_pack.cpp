@@ -0,0 +1,259 @@
+#include "l_asset_pack.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+
+namespace lain
+{
+  namespace asset_pack
+  {
+    static u32 constexpr kMagic{0x4b41504c}; // "LPAK"
+    static u32 constexpr kVersion{1};
+
+    struct pack_header final
+    {
+      u32 _magic;
+      u32 _version;
+      u32 _entryCount;
+      u32 _padding;
+      u64 _tocOffset;   // pack_entry[_entryCount]
+      u64 _namesOffset; // names back to back, no terminators
+    };
+
+    struct pack_entry final
+    {
+      u64 _offset;
+      u64 _size;
+      u32 _nameOffset; // from `_namesOffset`
+      u32 _nameLength;
+    };
+
+    static mapped_file _pack;
+    static pack_entry const* _entries;
+    static char const* _names;
+    static u32 _entryCount;
+
+    static std::string_view GetName(pack_entry const& entry);
+
+    bool Write(std::filesystem::path const& pack, std::vector<pack_input> inputs)
+    {
+      std::sort(inputs.begin(), inputs.end(),
+		[](pack_input const& a, pack_input const& b) { return a.first < b.first; });
+
+      std::ofstream out(pack, std::ios::binary | std::ios::trunc);
+
+      if (!out) {
+	std::cerr << __FUNCTION__ << ": couldn't open " << pack << '\n';
+	return false;
+      }
+
+      pack_header header{kMagic, kVersion, static_cast<u32>(inputs.size()), 0, 0, 0};
+      std::vector<pack_entry> entries;
+      std::string names;
+      u64 offset{sizeof(header)};
+
+      // Written once with zeroes, once more at the end with the offsets.
+      out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+
+      for (auto const& [name, source] : inputs) {
+	mapped_file file;
+
+	if (!MapFile(source, file)) {
+	  std::cerr << __FUNCTION__ << ": couldn't read " << source << '\n';
+	  return false;
+	}
+
+	u64 const aligned{(offset + kAlignment - 1) / kAlignment * kAlignment};
+	char const zeroes[kAlignment]{};
+
+	out.write(zeroes, aligned - offset);
+	out.write(reinterpret_cast<char const*>(file._data), file._size);
+
+	entries.push_back({aligned, file._size, static_cast<u32>(names.size()), static_cast<u32>(name.size())});
+	names += name;
+	offset = aligned + file._size;
+
+	UnmapFile(file);
+      }
+
+      // The table is read in place, so it needs its alignment too.
+      u64 const tocOffset{(offset + alignof(pack_entry) - 1) / alignof(pack_entry) * alignof(pack_entry)};
+      char const zeroes[alignof(pack_entry)]{};
+
+      out.write(zeroes, tocOffset - offset);
+
+      header._tocOffset = tocOffset;
+      header._namesOffset = tocOffset + entries.size() * sizeof(pack_entry);
+
+      out.write(reinterpret_cast<char const*>(entries.data()), entries.size() * sizeof(pack_entry));
+      out.write(names.data(), names.size());
+
+      out.seekp(0);
+      out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+      out.close();
+
+      if (!out) {
+	std::cerr << __FUNCTION__ << ": couldn't write " << pack << '\n';
+	return false;
+      }
+
+      return true;
+    }
+
+    bool Mount(std::filesystem::path const& pack)
+    {
+      Unmount();
+
+      if (!MapFile(pack, _pack)) {
+	return false;
+      }
+
+      pack_header header;
+
+      bool valid{_pack._size >= sizeof(header)};
+
+      if (valid) {
+	std::memcpy(&header, _pack._data, sizeof(header));
+
+	valid = header._magic == kMagic &&
+	  header._version == kVersion &&
+	  header._tocOffset % alignof(pack_entry) == 0 &&
+	  header._tocOffset + static_cast<u64>(header._entryCount) * sizeof(pack_entry) <= header._namesOffset &&
+	  header._namesOffset <= _pack._size;
+      }
+
+      if (!valid) {
+	std::cerr << __FUNCTION__ << ": " << pack << " isn't a pack this version can read\n";
+	Unmount();
+	return false;
+      }
+
+      _entries = reinterpret_cast<pack_entry const*>(_pack._data + header._tocOffset);
+      _names = reinterpret_cast<char const*>(_pack._data + header._namesOffset);
+      _entryCount = header._entryCount;
+
+      // Every blob and name inside the file and the names in order, lookups trust all of that.
+      u64 const namesSize{_pack._size - header._namesOffset};
+
+      for (u32 i{0}; i < _entryCount && valid; ++i) {
+	pack_entry const& entry{_entries[i]};
+
+	valid = entry._offset <= _pack._size &&
+	  entry._size <= _pack._size - entry._offset &&
+	  entry._nameOffset <= namesSize &&
+	  entry._nameLength <= namesSize - entry._nameOffset &&
+	  (i == 0 || GetName(_entries[i - 1]) < GetName(entry));
+      }
+
+      if (!valid) {
+	std::cerr << __FUNCTION__ << ": " << pack << " is corrupt or truncated\n";
+	Unmount();
+	return false;
+      }
+
+      return true;
+    }
+
+    void Unmount()
+    {
+      UnmapFile(_pack);
+
+      _entries = nullptr;
+      _names = nullptr;
+      _entryCount = 0;
+    }
+
+    bool IsMounted()
+    {
+      return _entries != nullptr;
+    }
+
+    bool Open(std::filesystem::path const& path, mapped_file& file)
+    {
+      if (IsMounted()) {
+	std::string const name{NormaliseName(path)};
+
+	pack_entry const* end{_entries + _entryCount};
+	pack_entry const* entry{std::lower_bound(_entries, end, name, [](pack_entry const& e, std::string const& n) {
+	  return GetName(e) < n;
+	})};
+
+	if (entry != end && GetName(*entry) == name) {
+	  file = {_pack._data + entry->_offset, entry->_size};
+	  return true;
+	}
+      }
+
+      return MapFile(path, file);
+    }
+
+    void Close(mapped_file& file)
+    {
+      bool const inPack{IsMounted() && file._data >= _pack._data && file._data < _pack._data + _pack._size};
+
+      if (inPack) {
+	file = {nullptr, 0};
+      } else {
+	UnmapFile(file);
+      }
+    }
+
+    std::vector<std::string> List(std::filesystem::path const& directory)
+    {
+      std::vector<std::string> names;
+
+      if (!IsMounted()) {
+	return names;
+      }
+
+      std::string prefix{NormaliseName(directory)};
+
+      if (!prefix.ends_with('/')) {
+	prefix += '/';
+      }
+
+      // Sorted by name, so everything under the directory is one run.
+      pack_entry const* end{_entries + _entryCount};
+      pack_entry const* entry{std::lower_bound(_entries, end, prefix, [](pack_entry const& e, std::string const& n) {
+	return GetName(e) < n;
+      })};
+
+      for (; entry != end && GetName(*entry).starts_with(prefix); ++entry) {
+	names.emplace_back(GetName(*entry));
+      }
+
+      return names;
+    }
+
+    std::string NormaliseName(std::filesystem::path const& path)
+    {
+      return path.lexically_normal().generic_string();
+    }
+
+    std::filesystem::path GetCachePath(std::filesystem::path const& directory, std::filesystem::path const& source)
+    {
+      std::filesystem::path const name{source.lexically_normal().relative_path()};
+      std::filesystem::path path{directory};
+      bool first{true};
+
+      for (auto const& part : name) {
+	bool const isRes{first && part == "res"};
+
+	first = false;
+
+	if (!isRes && part != ".." && part != "." && !part.empty()) {
+	  path /= part;
+	}
+      }
+
+      return path;
+    }
+
+    static std::string_view GetName(pack_entry const& entry)
+    {
+      return {_names + entry._nameOffset, entry._nameLength};
+    }
+  };
+};
@@ -2,6 +2,7 @@
 
 #include "glm/ext/matrix_transform.hpp"
 #include "glm/geometric.hpp"
+#include <cmath>
 
 namespace lain
 {
@@ -68,8 +69,21 @@ namespace lain
     return glm::lookAt(_position, _position + _front, _up);
   }
 
-  void camera3D::Update([[maybe_unused]]f32 deltaTime)
+  void camera3D::Update(f32 deltaTime)
   {
-    _position += (_targetPosition - _position) * float(_lerp);
+    // `_lerp` is tuned for 60 updates per second, scale it so the camera moves
+    // the same regardless of the update rate.
+    f32 const t{1.f - std::pow(1.f - _lerp, deltaTime * 60.f)};
+
+    _previousPosition = _position;
+    _position += (_targetPosition - _position) * t;
+  }
+
+  camera3D camera3D::Interpolated(f32 alpha) const
+  {
+    camera3D camera{*this};
+    camera._position = _previousPosition + (_position - _previousPosition) * alpha;
+
+    return camera;
   }
 };
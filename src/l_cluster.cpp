@@ -0,0 +1,290 @@
+#include "l_cluster.h"
+#include "glm/geometric.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+
+namespace lain
+{
+  namespace cluster
+  {
+    // How much a triangle's normal straying from the cluster's counts against it, next to its distance.
+    static f32 constexpr kConeWeight{0.5f};
+    // A triangle turned further than 60 degrees from the cluster's normals starts another one
+    // instead, it would open the cone too wide to ever cull. The ball's grooves need that.
+    static f32 constexpr kMinNormalDot{0.5f};
+    // Normals spread wider than that (about 84 degrees off the axis) are never all back facing.
+    static f32 constexpr kMinConeDot{0.1f};
+    static u32 constexpr kNone{~0u};
+
+    static void SetBounds(mesh_data const& mesh,
+			  std::vector<glm::vec3> const& normals,
+			  std::vector<u32> const& triangles,
+			  mesh_cluster& cluster);
+
+    void Build(mesh_data& mesh)
+    {
+      mesh._clusters.clear();
+
+      u32 const vertexCount{static_cast<u32>(mesh._vertices.size())};
+      u32 const indexCount{mesh._lods.empty() ? static_cast<u32>(mesh._indices.size()) : mesh._lods[0]._indexCount};
+      u32 const triangleCount{indexCount / 3};
+
+      if (triangleCount == 0) {
+	return;
+      }
+
+      std::vector<u32> const& indices{mesh._indices};
+
+      // Neighbours across hard edges and seams are still neighbours, so vertices at the same
+      // position share one entry of the adjacency.
+      std::vector<u32> order(vertexCount);
+      std::vector<u32> representatives(vertexCount);
+
+      std::iota(order.begin(), order.end(), 0);
+      std::sort(order.begin(), order.end(), [&](u32 a, u32 b) {
+	glm::vec3 const& p{mesh._vertices[a]._position};
+	glm::vec3 const& q{mesh._vertices[b]._position};
+
+	return p.x != q.x ? p.x < q.x : p.y != q.y ? p.y < q.y : p.z < q.z;
+      });
+
+      for (u32 i{0}; i < vertexCount; ++i) {
+	bool const same{i > 0 && mesh._vertices[order[i]]._position == mesh._vertices[order[i - 1]]._position};
+
+	representatives[order[i]] = same ? representatives[order[i - 1]] : order[i];
+      }
+
+      // Triangles around every position.
+      std::vector<u32> offsets(vertexCount + 1, 0);
+      std::vector<u32> adjacency(triangleCount * 3);
+
+      for (u32 i{0}; i < triangleCount * 3; ++i) {
+	++offsets[representatives[indices[i]] + 1];
+      }
+
+      std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+      {
+	std::vector<u32> cursor(offsets.begin(), offsets.end() - 1);
+
+	for (u32 i{0}; i < triangleCount * 3; ++i) {
+	  adjacency[cursor[representatives[indices[i]]]++] = i / 3;
+	}
+      }
+
+      std::vector<glm::vec3> normals(triangleCount);
+      std::vector<glm::vec3> centroids(triangleCount);
+
+      for (u32 t{0}; t < triangleCount; ++t) {
+	glm::vec3 const& a{mesh._vertices[indices[t * 3]]._position};
+	glm::vec3 const& b{mesh._vertices[indices[t * 3 + 1]]._position};
+	glm::vec3 const& c{mesh._vertices[indices[t * 3 + 2]]._position};
+	glm::vec3 const normal{glm::cross(b - a, c - a)};
+	f32 const length{glm::length(normal)};
+
+	// Degenerate ones don't face anywhere.
+	normals[t] = length > 0.f ? normal / length : glm::vec3(0.f);
+	centroids[t] = (a + b + c) / 3.f;
+      }
+
+      std::vector<u8> used(triangleCount, 0);
+      std::vector<u32> vertexCluster(vertexCount, kNone); // the cluster a vertex was last counted for
+      std::vector<u32> reordered;
+      std::vector<u32> triangles;
+      std::vector<u32> candidates;
+
+      reordered.reserve(indexCount);
+
+      // Seeds go in index order, which the vertex cache order already keeps local.
+      for (u32 seed{0}; seed < triangleCount; ++seed) {
+	if (used[seed]) {
+	  continue;
+	}
+
+	u32 const id{static_cast<u32>(mesh._clusters.size())};
+	u32 clusterVertices{0};
+	glm::vec3 centroidSum{0.f};
+	glm::vec3 normalSum{0.f};
+
+	triangles.clear();
+	candidates.clear();
+
+	for (u32 next{seed}; next != kNone;) {
+	  used[next] = 1;
+	  triangles.push_back(next);
+	  centroidSum += centroids[next];
+	  normalSum += normals[next];
+
+	  for (u32 corner{0}; corner < 3; ++corner) {
+	    u32 const vertex{indices[next * 3 + corner]};
+
+	    if (vertexCluster[vertex] != id) {
+	      vertexCluster[vertex] = id;
+	      ++clusterVertices;
+	    }
+
+	    u32 const representative{representatives[vertex]};
+
+	    for (u32 i{offsets[representative]}; i < offsets[representative + 1]; ++i) {
+	      if (!used[adjacency[i]]) {
+		candidates.push_back(adjacency[i]);
+	      }
+	    }
+	  }
+
+	  if (triangles.size() == kMaxTriangles) {
+	    break;
+	  }
+
+	  // The neighbour adding the fewest vertices, then the closest one facing the same way.
+	  glm::vec3 const centre{centroidSum / static_cast<f32>(triangles.size())};
+	  f32 const normalLength{glm::length(normalSum)};
+	  glm::vec3 const axis{normalLength > 0.f ? normalSum / normalLength : glm::vec3(0.f)};
+	  u32 bestNewVertices{kNone};
+	  f32 bestScore{FLT_MAX};
+	  u32 kept{0};
+
+	  next = kNone;
+
+	  for (u32 const candidate : candidates) {
+	    if (used[candidate]) {
+	      continue;
+	    }
+
+	    candidates[kept++] = candidate;
+
+	    u32 newVertices{0};
+
+	    for (u32 corner{0}; corner < 3; ++corner) {
+	      newVertices += vertexCluster[indices[candidate * 3 + corner]] != id;
+	    }
+
+	    bool const turned{axis != glm::vec3(0.f) && normals[candidate] != glm::vec3(0.f) &&
+			      glm::dot(normals[candidate], axis) < kMinNormalDot};
+
+	    if (clusterVertices + newVertices > kMaxVertices || turned) {
+	      continue;
+	    }
+
+	    f32 const spread{1.f - glm::dot(normals[candidate], axis)};
+	    f32 const score{glm::length(centroids[candidate] - centre) * (1.f + kConeWeight * spread)};
+
+	    if (newVertices < bestNewVertices || (newVertices == bestNewVertices && score < bestScore)) {
+	      next = candidate;
+	      bestNewVertices = newVertices;
+	      bestScore = score;
+	    }
+	  }
+
+	  candidates.resize(kept);
+	}
+
+	std::sort(triangles.begin(), triangles.end());
+
+	mesh_cluster cluster{static_cast<u32>(reordered.size()), static_cast<u32>(triangles.size() * 3), {}, 0.f, {}, 1.f};
+
+	for (u32 const t : triangles) {
+	  reordered.insert(reordered.end(), indices.begin() + t * 3, indices.begin() + t * 3 + 3);
+	}
+
+	SetBounds(mesh, normals, triangles, cluster);
+	mesh._clusters.push_back(cluster);
+      }
+
+      std::copy(reordered.begin(), reordered.end(), mesh._indices.begin());
+    }
+
+    bool IsBackFacing(mesh_cluster const& cluster, glm::vec3 const& cameraPosition)
+    {
+      if (cluster._coneCutoff >= 1.f) {
+	return false;
+      }
+
+      // The whole sphere has to be inside the cone of directions every triangle faces away from.
+      glm::vec3 const toCluster{cluster._centre - cameraPosition};
+
+      return glm::dot(toCluster, cluster._coneAxis) >= cluster._coneCutoff * glm::length(toCluster) + cluster._radius;
+    }
+
+    culling::cull_stats Cull(culling::frustum const& frustum,
+			     glm::vec3 const& cameraPosition,
+			     mesh_cluster const* clusters,
+			     u32 clusterCount,
+			     std::vector<u32>& visible)
+    {
+      visible.clear();
+
+      for (u32 i{0}; i < clusterCount; ++i) {
+	mesh_cluster const& cluster{clusters[i]};
+	bool inside{true};
+
+	for (auto const& plane : frustum._planes) {
+	  if (glm::dot(glm::vec3(plane), cluster._centre) + plane.w < -cluster._radius) {
+	    inside = false;
+	    break;
+	  }
+	}
+
+	if (inside && !IsBackFacing(cluster, cameraPosition)) {
+	  visible.push_back(i);
+	}
+      }
+
+      u32 const visibleCount{static_cast<u32>(visible.size())};
+
+      return {clusterCount, visibleCount, clusterCount - visibleCount};
+    }
+
+    static void SetBounds(mesh_data const& mesh,
+			  std::vector<glm::vec3> const& normals,
+			  std::vector<u32> const& triangles,
+			  mesh_cluster& cluster)
+    {
+      glm::vec3 min{FLT_MAX};
+      glm::vec3 max{-FLT_MAX};
+      glm::vec3 normalSum{0.f};
+
+      for (u32 const t : triangles) {
+	for (u32 corner{0}; corner < 3; ++corner) {
+	  glm::vec3 const& p{mesh._vertices[mesh._indices[t * 3 + corner]]._position};
+
+	  min = glm::min(min, p);
+	  max = glm::max(max, p);
+	}
+
+	normalSum += normals[t];
+      }
+
+      cluster._centre = (min + max) * 0.5f;
+      cluster._radius = 0.f;
+
+      for (u32 const t : triangles) {
+	for (u32 corner{0}; corner < 3; ++corner) {
+	  cluster._radius = std::max(cluster._radius, glm::length(mesh._vertices[mesh._indices[t * 3 + corner]]._position - cluster._centre));
+	}
+      }
+
+      f32 const normalLength{glm::length(normalSum)};
+
+      if (normalLength == 0.f) {
+	cluster._coneAxis = glm::vec3(0.f, 0.f, 1.f);
+	cluster._coneCutoff = 1.f;
+	return;
+      }
+
+      cluster._coneAxis = normalSum / normalLength;
+
+      f32 minDot{1.f};
+
+      for (u32 const t : triangles) {
+	if (normals[t] != glm::vec3(0.f)) {
+	  minDot = std::min(minDot, glm::dot(normals[t], cluster._coneAxis));
+	}
+      }
+
+      cluster._coneCutoff = minDot <= kMinConeDot ? 1.f : std::sqrt(1.f - minDot * minDot);
+    }
+  };
+};
@@ -0,0 +1,70 @@
+#include "l_collision_mesh.h"
+#include "l_common.h"
+#include "l_mesh.h"
+#include <cstring>
+#include <unordered_map>
+
+namespace lain
+{
+  namespace collision_mesh
+  {
+    static std::vector<glm::vec3> _positions;
+    static std::vector<u32> _indices;
+
+    struct position_hash final
+    {
+      std::size_t operator()(glm::vec3 const& p) const
+      {
+	return fnv1a64(&p, sizeof(p));
+      }
+    };
+
+    struct position_equal final
+    {
+      bool operator()(glm::vec3 const& a, glm::vec3 const& b) const
+      {
+	return std::memcmp(&a, &b, sizeof(glm::vec3)) == 0;
+      }
+    };
+
+    collision_mesh_ref Add(std::vector<vertex_data> const& vertices, std::span<u32 const> indices)
+    {
+      collision_mesh_ref ref{static_cast<u32>(_positions.size()), 0, static_cast<u32>(_indices.size()), 0};
+
+      // Vertices split for normals and texture coordinates are the same point to collide with.
+      std::unordered_map<glm::vec3, u32, position_hash, position_equal> unique;
+      std::vector<u32> remap(vertices.size());
+
+      unique.reserve(vertices.size());
+
+      for (u32 i{0}; i < vertices.size(); ++i) {
+	auto const [it, inserted] = unique.try_emplace(vertices[i]._position, ref._positionCount);
+
+	if (inserted) {
+	  _positions.push_back(vertices[i]._position);
+	  ++ref._positionCount;
+	}
+
+	remap[i] = it->second;
+      }
+
+      for (u32 const index : indices) {
+	_indices.push_back(remap[index]);
+      }
+
+      ref._indexCount = static_cast<u32>(indices.size());
+
+      return ref;
+    }
+
+    collision_mesh_view Get(collision_mesh_ref ref)
+    {
+      return {{_positions.data() + ref._firstPosition, ref._positionCount}, {_indices.data() + ref._firstIndex, ref._indexCount}};
+    }
+
+    u64 GetResidentBytes()
+    {
+      return _positions.size() * sizeof(glm::vec3) + _indices.size() * sizeof(u32);
+    }
+  };
+};
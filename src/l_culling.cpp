@@ -0,0 +1,172 @@
+#include "l_culling.h"
+#include "glm/geometric.hpp"
+#include <cmath>
+#include <xmmintrin.h>
+
+namespace lain
+{
+  namespace culling
+  {
+    static glm::vec4 GetRow(glm::mat4 const& m, i32 row);
+    static bool IsBoxVisible(frustum const& frustum, bounds_soa const& bounds, u32 i);
+
+    frustum ExtractFrustum(glm::mat4 const& viewProjection)
+    {
+      glm::vec4 const r0{GetRow(viewProjection, 0)};
+      glm::vec4 const r1{GetRow(viewProjection, 1)};
+      glm::vec4 const r2{GetRow(viewProjection, 2)};
+      glm::vec4 const r3{GetRow(viewProjection, 3)};
+
+      frustum result{{
+	  r3 + r0, // left
+	  r3 - r0, // right
+	  r3 + r1, // bottom
+	  r3 - r1, // top
+	  r3 + r2, // near
+	  r3 - r2, // far
+	}};
+
+      for (auto& plane : result._planes) {
+	plane /= glm::length(glm::vec3(plane));
+      }
+
+      return result;
+    }
+
+    void ClearBounds(bounds_soa& bounds)
+    {
+      bounds._centreX.clear();
+      bounds._centreY.clear();
+      bounds._centreZ.clear();
+      bounds._extentX.clear();
+      bounds._extentY.clear();
+      bounds._extentZ.clear();
+    }
+
+    void AddBounds(bounds_soa& bounds, aabb const& box)
+    {
+      glm::vec3 const centre{(box._min + box._max) * 0.5f};
+      glm::vec3 const extent{(box._max - box._min) * 0.5f};
+
+      bounds._centreX.push_back(centre.x);
+      bounds._centreY.push_back(centre.y);
+      bounds._centreZ.push_back(centre.z);
+      bounds._extentX.push_back(extent.x);
+      bounds._extentY.push_back(extent.y);
+      bounds._extentZ.push_back(extent.z);
+    }
+
+    u32 GetBoundsCount(bounds_soa const& bounds)
+    {
+      return static_cast<u32>(bounds._centreX.size());
+    }
+
+    cull_stats CullBounds(frustum const& frustum, bounds_soa const& bounds, std::vector<u32>& visible)
+    {
+      visible.clear();
+
+      u32 const count{GetBoundsCount(bounds)};
+      u32 const batches{count / 4};
+
+      // Broadcast every plane once, |n| is needed for the extent term.
+      __m128 nx[6], ny[6], nz[6], nw[6], ax[6], ay[6], az[6];
+      __m128 const signMask{_mm_set1_ps(-0.f)};
+
+      for (i32 p{0}; p < 6; ++p) {
+	nx[p] = _mm_set1_ps(frustum._planes[p].x);
+	ny[p] = _mm_set1_ps(frustum._planes[p].y);
+	nz[p] = _mm_set1_ps(frustum._planes[p].z);
+	nw[p] = _mm_set1_ps(frustum._planes[p].w);
+	ax[p] = _mm_andnot_ps(signMask, nx[p]);
+	ay[p] = _mm_andnot_ps(signMask, ny[p]);
+	az[p] = _mm_andnot_ps(signMask, nz[p]);
+      }
+
+      __m128 const zero{_mm_setzero_ps()};
+
+      for (u32 b{0}; b < batches; ++b) {
+	u32 const i{b * 4};
+
+	__m128 const cx{_mm_loadu_ps(&bounds._centreX[i])};
+	__m128 const cy{_mm_loadu_ps(&bounds._centreY[i])};
+	__m128 const cz{_mm_loadu_ps(&bounds._centreZ[i])};
+	__m128 const ex{_mm_loadu_ps(&bounds._extentX[i])};
+	__m128 const ey{_mm_loadu_ps(&bounds._extentY[i])};
+	__m128 const ez{_mm_loadu_ps(&bounds._extentZ[i])};
+
+	__m128 outside{_mm_setzero_ps()};
+
+	for (i32 p{0}; p < 6; ++p) {
+	  // Signed distance of the centre plus the box's projected radius on the plane normal.
+	  __m128 d{_mm_add_ps(_mm_mul_ps(nx[p], cx), nw[p])};
+	  d = _mm_add_ps(d, _mm_mul_ps(ny[p], cy));
+	  d = _mm_add_ps(d, _mm_mul_ps(nz[p], cz));
+	  d = _mm_add_ps(d, _mm_mul_ps(ax[p], ex));
+	  d = _mm_add_ps(d, _mm_mul_ps(ay[p], ey));
+	  d = _mm_add_ps(d, _mm_mul_ps(az[p], ez));
+
+	  outside = _mm_or_ps(outside, _mm_cmplt_ps(d, zero));
+	}
+
+	i32 const insideMask{~_mm_movemask_ps(outside) & 0xf};
+
+	for (u32 lane{0}; lane < 4; ++lane) {
+	  if (insideMask & (1 << lane)) {
+	    visible.push_back(i + lane);
+	  }
+	}
+      }
+
+      for (u32 i{batches * 4}; i < count; ++i) {
+	if (IsBoxVisible(frustum, bounds, i)) {
+	  visible.push_back(i);
+	}
+      }
+
+      u32 const visibleCount{static_cast<u32>(visible.size())};
+
+      return {count, visibleCount, count - visibleCount};
+    }
+
+    cull_stats CullBoundsScalar(frustum const& frustum, bounds_soa const& bounds, std::vector<u32>& visible)
+    {
+      visible.clear();
+
+      u32 const count{GetBoundsCount(bounds)};
+
+      for (u32 i{0}; i < count; ++i) {
+	if (IsBoxVisible(frustum, bounds, i)) {
+	  visible.push_back(i);
+	}
+      }
+
+      u32 const visibleCount{static_cast<u32>(visible.size())};
+
+      return {count, visibleCount, count - visibleCount};
+    }
+
+    static glm::vec4 GetRow(glm::mat4 const& m, i32 row)
+    {
+      return glm::vec4(m[0][row], m[1][row], m[2][row], m[3][row]);
+    }
+
+    static bool IsBoxVisible(frustum const& frustum, bounds_soa const& bounds, u32 i)
+    {
+      for (auto const& plane : frustum._planes) {
+	// Same order of operations as the SSE path so both agree on boxes touching a plane.
+	f32 d{plane.x * bounds._centreX[i] + plane.w};
+	d += plane.y * bounds._centreY[i];
+	d += plane.z * bounds._centreZ[i];
+	d += std::abs(plane.x) * bounds._extentX[i];
+	d += std::abs(plane.y) * bounds._extentY[i];
+	d += std::abs(plane.z) * bounds._extentZ[i];
+
+	if (d < 0.f) {
+	  return false;
+	}
+      }
+
+      return true;
+    }
+  };
+};
@@ -0,0 +1,232 @@
+#include "l_debug_draw.h"
+#include "glad/glad.h"
+#include "glm/common.hpp"
+#include "l_common.h"
+#include "l_gl_state.h"
+#include "l_render_system.h"
+#include "l_resource_manager.h"
+#include "l_shader.h"
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <numbers>
+
+namespace lain
+{
+  namespace debug_draw
+  {
+    struct debug_vertex final
+    {
+      glm::vec3 _position;
+      u32 _colour; // RGBA8
+    };
+
+    // The GPU can be a couple of frames behind, every frame writes to its own region.
+    static u32 constexpr kRegionCount{3};
+    // 50k boxes (24 vertices each) plus some room.
+    static u32 constexpr kMaxVerticesPerFrame{1'280'000};
+    static GLuint64 constexpr kFenceTimeout{1'000'000}; // ns
+
+    static u32 _vao;
+    static u32 _vbo;
+    static debug_vertex* _mapped;
+    static GLsync _fences[kRegionCount];
+    static u32 _region;
+    static u32 _count;       // vertices written this frame
+    static u32 _flushed;     // vertices already drawn this frame
+    static u32 _dropped;
+    static debug_draw_stats _lastStats;
+    static shader const* _shader;
+
+    static debug_vertex* Reserve(u32 count);
+    static u32 PackColour(glm::vec4 const& colour);
+
+    void Initialise()
+    {
+      GLsizeiptr const size{static_cast<GLsizeiptr>(sizeof(debug_vertex)) * kMaxVerticesPerFrame * kRegionCount};
+      GLbitfield const flags{GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT};
+
+      glGenVertexArrays(1, &_vao);
+      glGenBuffers(1, &_vbo);
+
+      gl_state::BindVertexArray(_vao);
+      gl_state::BindBuffer(GL_ARRAY_BUFFER, _vbo);
+
+      glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+      _mapped = static_cast<debug_vertex*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+
+      assert(_mapped != nullptr && "couldn't map debug draw buffer");
+
+      glEnableVertexAttribArray(0);
+      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(debug_vertex),
+			    reinterpret_cast<void*>(offsetof(debug_vertex, _position)));
+
+      glEnableVertexAttribArray(1);
+      glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(debug_vertex),
+			    reinterpret_cast<void*>(offsetof(debug_vertex, _colour)));
+
+      _shader = resource_manager::GetShader(kDebugLinesShaderId);
+
+      _region = 0;
+      _count = 0;
+      _flushed = 0;
+      _dropped = 0;
+    }
+
+    void BeginFrame()
+    {
+      _region = (_region + 1) % kRegionCount;
+
+      if (_fences[_region] != nullptr) {
+	GLenum result;
+
+	do {
+	  result = glClientWaitSync(_fences[_region], GL_SYNC_FLUSH_COMMANDS_BIT, kFenceTimeout);
+	} while (result == GL_TIMEOUT_EXPIRED);
+
+	glDeleteSync(_fences[_region]);
+	_fences[_region] = nullptr;
+      }
+
+      _count = 0;
+      _flushed = 0;
+      _dropped = 0;
+    }
+
+    void Line(glm::vec3 const& from, glm::vec3 const& to, glm::vec4 const& colour)
+    {
+      debug_vertex* v{Reserve(2)};
+
+      if (v == nullptr) {
+	return;
+      }
+
+      u32 const c{PackColour(colour)};
+
+      v[0] = {from, c};
+      v[1] = {to, c};
+    }
+
+    void Box(aabb const& box, glm::vec4 const& colour)
+    {
+      debug_vertex* v{Reserve(24)};
+
+      if (v == nullptr) {
+	return;
+      }
+
+      u32 const c{PackColour(colour)};
+
+      glm::vec3 const corners[] = {
+	{box._min.x, box._min.y, box._min.z},
+	{box._max.x, box._min.y, box._min.z},
+	{box._max.x, box._max.y, box._min.z},
+	{box._min.x, box._max.y, box._min.z},
+	{box._min.x, box._min.y, box._max.z},
+	{box._max.x, box._min.y, box._max.z},
+	{box._max.x, box._max.y, box._max.z},
+	{box._min.x, box._max.y, box._max.z},
+      };
+
+      static u32 constexpr kEdges[] = {
+	0, 1, 1, 2, 2, 3, 3, 0, // Bottom face
+	4, 5, 5, 6, 6, 7, 7, 4, // Top face
+	0, 4, 1, 5, 2, 6, 3, 7  // Vertical lines
+      };
+
+      for (u32 i{0}; i < 24; ++i) {
+	v[i] = {corners[kEdges[i]], c};
+      }
+    }
+
+    void Sphere(glm::vec3 const& centre, f32 radius, glm::vec4 const& colour, u32 segments)
+    {
+      // One circle around each axis.
+      debug_vertex* v{Reserve(segments * 2 * 3)};
+
+      if (v == nullptr) {
+	return;
+      }
+
+      u32 const c{PackColour(colour)};
+      f32 const step{2.f * std::numbers::pi_v<f32> / segments};
+
+      for (u32 i{0}; i < segments; ++i) {
+	f32 const s0{std::sin(step * i) * radius}, c0{std::cos(step * i) * radius};
+	f32 const s1{std::sin(step * (i + 1)) * radius}, c1{std::cos(step * (i + 1)) * radius};
+
+	*v++ = {centre + glm::vec3(c0, s0, 0.f), c};
+	*v++ = {centre + glm::vec3(c1, s1, 0.f), c};
+	*v++ = {centre + glm::vec3(c0, 0.f, s0), c};
+	*v++ = {centre + glm::vec3(c1, 0.f, s1), c};
+	*v++ = {centre + glm::vec3(0.f, c0, s0), c};
+	*v++ = {centre + glm::vec3(0.f, c1, s1), c};
+      }
+    }
+
+    void Ray(ray const& ray, f32 length, glm::vec4 const& colour)
+    {
+      Line(ray._position, ray._position + ray._direction * length, colour);
+    }
+
+    void Grid(glm::vec3 const& centre, f32 halfExtent, f32 spacing, glm::vec4 const& colour)
+    {
+      i32 const lines{static_cast<i32>(halfExtent / spacing)};
+
+      for (i32 i{-lines}; i <= lines; ++i) {
+	f32 const offset{i * spacing};
+
+	Line(centre + glm::vec3(-halfExtent, 0.f, offset), centre + glm::vec3(halfExtent, 0.f, offset), colour);
+	Line(centre + glm::vec3(offset, 0.f, -halfExtent), centre + glm::vec3(offset, 0.f, halfExtent), colour);
+      }
+    }
+
+    void Flush(glm::mat4 const& viewProjection)
+    {
+      if (_count > _flushed) {
+	gl_state::UseProgram(_shader->_id);
+	render_system::SetUniformMat4(_shader->_id, "viewProjection", viewProjection);
+	gl_state::BindVertexArray(_vao);
+
+	glDrawArrays(GL_LINES, _region * kMaxVerticesPerFrame + _flushed, _count - _flushed);
+
+	if (_fences[_region] != nullptr) {
+	  glDeleteSync(_fences[_region]);
+	}
+
+	_fences[_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	_flushed = _count;
+      }
+
+      _lastStats = {_count, _dropped};
+    }
+
+    debug_draw_stats GetStats()
+    {
+      return _lastStats;
+    }
+
+    static debug_vertex* Reserve(u32 count)
+    {
+      if (_count + count > kMaxVerticesPerFrame) {
+	_dropped += count;
+	return nullptr;
+      }
+
+      debug_vertex* v{_mapped + _region * kMaxVerticesPerFrame + _count};
+      _count += count;
+
+      return v;
+    }
+
+    static u32 PackColour(glm::vec4 const& colour)
+    {
+      glm::vec4 const c{glm::clamp(colour, 0.f, 1.f) * 255.f + 0.5f};
+
+      return static_cast<u32>(c.x) |
+	static_cast<u32>(c.y) << 8 |
+	static_cast<u32>(c.z) << 16 |
+	static_cast<u32>(c.w) << 24;
+    }
+  };
+};
@@ -13,9 +13,14 @@ namespace lain
 
     void Post(event const event)
     {
-      auto& listeners = _listeners[event._type];
+      // Not operator[], it would allocate an empty list for events nobody listens to.
+      auto const it = _listeners.find(event._type);
 
-      for (auto const& f : listeners) {
+      if (it == _listeners.end()) {
+	return;
+      }
+
+      for (auto const& f : it->second) {
 	f(event);
       }
     }
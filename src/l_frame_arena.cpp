@@ -0,0 +1,71 @@
+#include "l_frame_arena.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+
+namespace lain
+{
+  namespace frame_arena
+  {
+    static std::byte* _memory;
+    static std::size_t _capacity;
+    static std::size_t _offset;
+    static std::size_t _highWaterMark;
+
+    void Initialise(std::size_t capacity)
+    {
+      _memory = static_cast<std::byte*>(std::malloc(capacity));
+      _capacity = _memory != nullptr ? capacity : 0;
+      _offset = 0;
+      _highWaterMark = 0;
+
+      assert(_memory != nullptr && "couldn't allocate the frame arena");
+    }
+
+    void Shutdown()
+    {
+      std::free(_memory);
+
+      _memory = nullptr;
+      _capacity = 0;
+    }
+
+    void BeginFrame()
+    {
+      _highWaterMark = std::max(_highWaterMark, _offset);
+      _offset = 0;
+    }
+
+    void* Allocate(std::size_t size, std::size_t alignment)
+    {
+      std::size_t const start{(_offset + alignment - 1) & ~(alignment - 1)};
+
+      if (start + size > _capacity) {
+	std::cerr << __FUNCTION__ << ": out of memory, " << size << " bytes requested, "
+		  << _capacity - _offset << " left\n";
+	assert(false && "frame arena is full");
+	return nullptr;
+      }
+
+      _offset = start + size;
+
+      return _memory + start;
+    }
+
+    std::size_t GetBytesUsed()
+    {
+      return _offset;
+    }
+
+    std::size_t GetHighWaterMark()
+    {
+      return std::max(_highWaterMark, _offset);
+    }
+
+    std::size_t GetCapacity()
+    {
+      return _capacity;
+    }
+  };
+};
@@ -0,0 +1,143 @@
+#include "l_frame_stats.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <fstream>
+#include <iostream>
+
+namespace lain
+{
+  namespace frame_stats
+  {
+    static std::array<frame_timings, kCapacity> _frames;
+    static u32 _next;  // slot the next frame goes into
+    static u32 _count;
+
+    void Record(frame_timings const& timings)
+    {
+      _frames[_next] = timings;
+      _next = (_next + 1) % kCapacity;
+      _count = std::min(_count + 1, kCapacity);
+    }
+
+    void Clear()
+    {
+      _next = 0;
+      _count = 0;
+    }
+
+    u32 GetFrameCount()
+    {
+      return _count;
+    }
+
+    frame_timings const& GetFrame(u32 index)
+    {
+      assert(index < _count && "frame index out of range");
+
+      return _frames[(_next + kCapacity - _count + index) % kCapacity];
+    }
+
+    frame_summary Summarise()
+    {
+      std::array<f32, kCapacity> totals;
+
+      for (u32 i{0}; i < _count; ++i) {
+	totals[i] = GetFrame(i)._total;
+      }
+
+      return Summarise(totals.data(), _count);
+    }
+
+    frame_summary Summarise(f32* frameTimes, u32 count)
+    {
+      if (count == 0) {
+	return {};
+      }
+
+      f32 sum{0.f};
+
+      for (u32 i{0}; i < count; ++i) {
+	sum += frameTimes[i];
+      }
+
+      std::sort(frameTimes, frameTimes + count);
+
+      // Nearest rank.
+      auto const percentile = [&](f32 p) {
+	return frameTimes[static_cast<u32>(p * (count - 1) + 0.5f)];
+      };
+
+      frame_summary summary{};
+      summary._count = count;
+      summary._average = sum / count;
+      summary._min = frameTimes[0];
+      summary._p50 = percentile(0.5f);
+      summary._p95 = percentile(0.95f);
+      summary._p99 = percentile(0.99f);
+      summary._max = frameTimes[count - 1];
+
+      // Sorted, so every frame past the first slow one is a stutter.
+      f32 const* const firstStutter{std::upper_bound(frameTimes, frameTimes + count, 2.f * summary._p50)};
+      summary._stutters = static_cast<u32>(frameTimes + count - firstStutter);
+
+      return summary;
+    }
+
+    bool ExportCSV(std::filesystem::path const& file)
+    {
+      std::ofstream out(file);
+
+      if (!out.is_open()) {
+	std::cerr << __FUNCTION__ << ": couldn't open " << file << '\n';
+	return false;
+      }
+
+      out << "frame,input_ms,update_ms,render_ms,swap_ms,total_ms\n";
+
+      for (u32 i{0}; i < _count; ++i) {
+	auto const& f = GetFrame(i);
+	out << i << ',' << f._input << ',' << f._update << ',' << f._render << ',' << f._swap << ',' << f._total << '\n';
+      }
+
+      return out.good();
+    }
+
+    bool ExportJSON(std::filesystem::path const& file)
+    {
+      std::ofstream out(file);
+
+      if (!out.is_open()) {
+	std::cerr << __FUNCTION__ << ": couldn't open " << file << '\n';
+	return false;
+      }
+
+      auto const summary = Summarise();
+
+      out << "{\n  \"summary\": {\"frames\": " << summary._count
+	  << ", \"average_ms\": " << summary._average
+	  << ", \"min_ms\": " << summary._min
+	  << ", \"p50_ms\": " << summary._p50
+	  << ", \"p95_ms\": " << summary._p95
+	  << ", \"p99_ms\": " << summary._p99
+	  << ", \"max_ms\": " << summary._max
+	  << ", \"stutters\": " << summary._stutters << "},\n  \"frames\": [\n";
+
+      for (u32 i{0}; i < _count; ++i) {
+	auto const& f = GetFrame(i);
+	out << "    {\"input_ms\": " << f._input << ", \"update_ms\": " << f._update
+	    << ", \"render_ms\": " << f._render << ", \"swap_ms\": " << f._swap
+	    << ", \"total_ms\": " << f._total << '}' << (i + 1 < _count ? ",\n" : "\n");
+      }
+
+      out << "  ]\n}\n";
+
+      return out.good();
+    }
+
+    bool Export(std::filesystem::path const& file)
+    {
+      return file.extension() == ".json" ? ExportJSON(file) : ExportCSV(file);
+    }
+  };
+};
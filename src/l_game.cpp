@@ -3,6 +3,8 @@
 #include "l_input_manager.h"
 #include "l_level_editor.h"
 #include "l_main_menu.h"
+#include "l_profiler.h"
+#include "l_render_system.h"
 #include <stack>
 
 namespace lain
@@ -57,6 +59,8 @@ namespace lain
 
     void ProcessInput()
     {
+      LAIN_PROFILE_ZONE("game::ProcessInput");
+
       if (input_manager::IsKeyPressed(input_manager::key::esc)) {
 	ForceShutdown();
 	return;
@@ -78,6 +82,8 @@ namespace lain
 
     void Update(f32 deltaTime)
     {
+      LAIN_PROFILE_ZONE("game::Update");
+
       switch (_state.top()) {
       case game_state::mainMenu:
 	main_menu::Update();
@@ -92,8 +98,36 @@ namespace lain
       }
     }
 
-    void Render()
+    void FixedUpdate(f32 deltaTime)
     {
+      LAIN_PROFILE_ZONE("game::FixedUpdate");
+
+      switch (_state.top()) {
+      case game_state::mainMenu:
+	break;
+      case game_state::play:
+	break;
+      case game_state::levelEditor:
+	level_editor::FixedUpdate(deltaTime);
+	break;
+      case game_state::options:
+	break;
+      }
+    }
+
+    void BuildSnapshot(f32 alpha, render_snapshot& snapshot)
+    {
+      if (_state.top() == game_state::levelEditor) {
+	level_editor::BuildSnapshot(alpha, snapshot);
+      } else {
+	snapshot._valid = false;
+      }
+    }
+
+    void Render(render_snapshot const& snapshot)
+    {
+      LAIN_PROFILE_ZONE("game::Render");
+
       switch (_state.top()) {
       case game_state::mainMenu:
 	main_menu::Render();
@@ -101,7 +135,7 @@ namespace lain
       case game_state::play:
 	break;
       case game_state::levelEditor:
-	level_editor::Render();
+	level_editor::Render(snapshot);
 	break;
       case game_state::options:
 	break;
@@ -0,0 +1,218 @@
+#include "l_gl_state.h"
+#include <cassert>
+#include <iostream>
+#include <limits>
+
+namespace lain
+{
+  namespace gl_state
+  {
+    // Binding we know nothing about, the next call for it always reaches GL.
+    static u32 constexpr kUnknown{std::numeric_limits<u32>::max()};
+    static u32 constexpr kMaxTextureUnits{32};
+
+    static u32 _program;
+    static u32 _vertexArray;
+    static u32 _arrayBuffer;
+    static u32 _elementArrayBuffer; // belongs to the bound VAO
+    static u32 _activeTexture;      // unit index, not GL_TEXTURE0 + i
+    static u32 _textures2D[kMaxTextureUnits];
+    static gl_state_stats _frameStats;
+    static gl_state_stats _lastFrameStats;
+
+#ifdef LAIN_DEBUG_GL_STATE
+    static bool _validate{true};
+#else
+    static bool _validate{false};
+#endif
+
+    static bool Skip(u32& shadow, u32 id);
+    static void Validate(char const* caller);
+
+    void Initialise()
+    {
+      Invalidate();
+
+      _frameStats = {};
+      _lastFrameStats = {};
+    }
+
+    void BeginFrame()
+    {
+      _lastFrameStats = _frameStats;
+      _frameStats = {};
+    }
+
+    void UseProgram(u32 id)
+    {
+      if (!Skip(_program, id)) {
+	glUseProgram(id);
+      }
+
+      Validate(__FUNCTION__);
+    }
+
+    void BindVertexArray(u32 id)
+    {
+      if (!Skip(_vertexArray, id)) {
+	glBindVertexArray(id);
+	// The element array binding is part of the VAO, so whatever we had is meaningless now.
+	_elementArrayBuffer = kUnknown;
+      }
+
+      Validate(__FUNCTION__);
+    }
+
+    void BindBuffer(GLenum target, u32 id)
+    {
+      switch (target) {
+      case GL_ARRAY_BUFFER:
+	if (!Skip(_arrayBuffer, id)) {
+	  glBindBuffer(target, id);
+	}
+	break;
+      case GL_ELEMENT_ARRAY_BUFFER:
+	if (!Skip(_elementArrayBuffer, id)) {
+	  glBindBuffer(target, id);
+	}
+	break;
+      default:
+	// Not tracked, just forward it.
+	++_frameStats._calls;
+	glBindBuffer(target, id);
+	break;
+      }
+
+      Validate(__FUNCTION__);
+    }
+
+    void ActiveTexture(GLenum texture)
+    {
+      u32 const unit{texture - GL_TEXTURE0};
+
+      assert(unit < kMaxTextureUnits && "texture unit out of range");
+
+      if (!Skip(_activeTexture, unit)) {
+	glActiveTexture(texture);
+      }
+
+      Validate(__FUNCTION__);
+    }
+
+    void BindTexture(GLenum target, u32 id)
+    {
+      if (target == GL_TEXTURE_2D && _activeTexture != kUnknown) {
+	if (!Skip(_textures2D[_activeTexture], id)) {
+	  glBindTexture(target, id);
+	}
+      } else {
+	++_frameStats._calls;
+	glBindTexture(target, id);
+
+	// We don't know which unit got it, so no unit can be trusted anymore.
+	if (target == GL_TEXTURE_2D) {
+	  for (u32 i{0}; i < kMaxTextureUnits; ++i) {
+	    _textures2D[i] = kUnknown;
+	  }
+	}
+      }
+
+      Validate(__FUNCTION__);
+    }
+
+    void ForgetTexture(u32 id)
+    {
+      for (u32 i{0}; i < kMaxTextureUnits; ++i) {
+	if (_textures2D[i] == id) {
+	  _textures2D[i] = kUnknown;
+	}
+      }
+    }
+
+    void ForgetProgram(u32 id)
+    {
+      if (_program == id) {
+	_program = kUnknown;
+      }
+    }
+
+    void Invalidate()
+    {
+      _program = kUnknown;
+      _vertexArray = kUnknown;
+      _arrayBuffer = kUnknown;
+      _elementArrayBuffer = kUnknown;
+      _activeTexture = kUnknown;
+
+      for (u32 i{0}; i < kMaxTextureUnits; ++i) {
+	_textures2D[i] = kUnknown;
+      }
+    }
+
+    void SetValidation(bool enabled)
+    {
+      _validate = enabled;
+    }
+
+    bool IsValidating()
+    {
+      return _validate;
+    }
+
+    gl_state_stats GetLastFrameStats()
+    {
+      return _lastFrameStats;
+    }
+
+    static bool Skip(u32& shadow, u32 id)
+    {
+      ++_frameStats._calls;
+
+      if (shadow == id) {
+	++_frameStats._skipped;
+	return true;
+      }
+
+      shadow = id;
+
+      return false;
+    }
+
+    static void Validate(char const* caller)
+    {
+      if (!_validate) {
+	return;
+      }
+
+      GLint actual{0};
+      bool ok{true};
+
+      auto const check = [&](GLenum pname, u32 shadow, char const* name) {
+	if (shadow == kUnknown) {
+	  return;
+	}
+
+	glGetIntegerv(pname, &actual);
+
+	if (static_cast<u32>(actual) != shadow) {
+	  std::cerr << caller << ": shadow " << name << " is " << shadow << " but GL has " << actual << '\n';
+	  ok = false;
+	}
+      };
+
+      check(GL_CURRENT_PROGRAM, _program, "program");
+      check(GL_VERTEX_ARRAY_BINDING, _vertexArray, "vertex array");
+      check(GL_ARRAY_BUFFER_BINDING, _arrayBuffer, "array buffer");
+      check(GL_ELEMENT_ARRAY_BUFFER_BINDING, _elementArrayBuffer, "element array buffer");
+
+      if (_activeTexture != kUnknown) {
+	check(GL_ACTIVE_TEXTURE, GL_TEXTURE0 + _activeTexture, "active texture");
+	check(GL_TEXTURE_BINDING_2D, _textures2D[_activeTexture], "texture 2D");
+      }
+
+      if (!ok) {
+	assert(false && "GL shadow state is out of sync, something bypassed gl_state");
+      }
+    }
+  };
+};
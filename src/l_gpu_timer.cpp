@@ -0,0 +1,169 @@
+#include "l_gpu_timer.h"
+#include "glad/glad.h"
+#include <cassert>
+#include <iostream>
+
+namespace lain
+{
+  namespace gpu_timer
+  {
+    // Frames between issuing a query and reading it back.
+    static u32 constexpr kLatency{4};
+    static u32 constexpr kMaxPasses{32};
+    static u32 constexpr kMaxDepth{8};
+
+    struct frame_queries final
+    {
+      GLuint _begin[kMaxPasses];
+      GLuint _end[kMaxPasses];
+      char const* _names[kMaxPasses];
+      u32 _depths[kMaxPasses];
+      u32 _count;
+    };
+
+    static bool _supported;
+    static frame_queries _frames[kLatency];
+    static u32 _frame;     // slot being recorded
+    static u32 _issued;    // frames recorded so far, capped at kLatency
+    static u32 _open[kMaxDepth];
+    static u32 _depth;
+    static std::vector<pass_time> _lastResults;
+
+    static void ReadBack(frame_queries const& frame);
+
+    void Initialise()
+    {
+      GLint bits{0};
+      glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+
+      _supported = bits > 0;
+
+      if (!_supported) {
+	std::clog << __FUNCTION__ << ": no timer queries, GPU pass timings disabled\n";
+	return;
+      }
+
+      for (auto& frame : _frames) {
+	glGenQueries(kMaxPasses, frame._begin);
+	glGenQueries(kMaxPasses, frame._end);
+	frame._count = 0;
+      }
+
+      _frame = 0;
+      _issued = 0;
+      _depth = 0;
+    }
+
+    void Shutdown()
+    {
+      if (!_supported) {
+	return;
+      }
+
+      for (auto& frame : _frames) {
+	glDeleteQueries(kMaxPasses, frame._begin);
+	glDeleteQueries(kMaxPasses, frame._end);
+      }
+
+      _supported = false;
+    }
+
+    bool IsSupported()
+    {
+      return _supported;
+    }
+
+    void BeginFrame()
+    {
+      if (!_supported) {
+	return;
+      }
+
+      assert(_depth == 0 && "gpu_timer::Begin without End");
+
+      _frame = (_frame + 1) % kLatency;
+
+      // The slot we're about to reuse is the oldest one in flight.
+      if (_issued == kLatency) {
+	ReadBack(_frames[_frame]);
+      } else {
+	++_issued;
+      }
+
+      _frames[_frame]._count = 0;
+      _depth = 0;
+    }
+
+    void Begin(char const* name)
+    {
+      if (!_supported) {
+	return;
+      }
+
+      frame_queries& frame{_frames[_frame]};
+
+      // Passes past the limits are silently ignored, End has to know about them though.
+      if (frame._count < kMaxPasses && _depth < kMaxDepth) {
+	u32 const index{frame._count++};
+
+	frame._names[index] = name;
+	frame._depths[index] = _depth;
+	_open[_depth] = index;
+
+	glQueryCounter(frame._begin[index], GL_TIMESTAMP);
+      } else if (_depth < kMaxDepth) {
+	_open[_depth] = kMaxPasses;
+      }
+
+      ++_depth;
+    }
+
+    void End()
+    {
+      if (!_supported) {
+	return;
+      }
+
+      assert(_depth > 0 && "gpu_timer::End without Begin");
+
+      --_depth;
+
+      if (_depth < kMaxDepth && _open[_depth] < kMaxPasses) {
+	glQueryCounter(_frames[_frame]._end[_open[_depth]], GL_TIMESTAMP);
+      }
+    }
+
+    std::vector<pass_time> const& GetLastResults()
+    {
+      return _lastResults;
+    }
+
+    static void ReadBack(frame_queries const& frame)
+    {
+      if (frame._count == 0) {
+	return;
+      }
+
+      // Keep showing the previous results rather than waiting for the GPU.
+      for (u32 i{0}; i < frame._count; ++i) {
+	GLint available{GL_FALSE};
+	glGetQueryObjectiv(frame._end[i], GL_QUERY_RESULT_AVAILABLE, &available);
+
+	if (available == GL_FALSE) {
+	  return;
+	}
+      }
+
+      _lastResults.clear();
+
+      for (u32 i{0}; i < frame._count; ++i) {
+	GLuint64 begin{0}, end{0};
+
+	glGetQueryObjectui64v(frame._begin[i], GL_QUERY_RESULT, &begin);
+	glGetQueryObjectui64v(frame._end[i], GL_QUERY_RESULT, &end);
+
+	_lastResults.push_back({frame._names[i], (end - begin) / 1e6f, frame._depths[i]});
+      }
+    }
+  };
+};
@@ -1,25 +1,34 @@
 #include "glm/ext/quaternion_float.hpp"
+#include "glm/matrix.hpp"
 #include "imgui.h"
 #include "imgui_impl_opengl3.h"
-#include "imgui_impl_sdl2.h"
+#include "l_allocation_tracker.h"
 #include "l_application.h"
 #include "l_camera.h"
 #include "l_common.h"
+#include "l_debug_draw.h"
 #include "l_entity_system.h"
+#include "l_frame_arena.h"
+#include "l_frame_stats.h"
+#include "l_gl_state.h"
+#include "l_gpu_timer.h"
 #include "l_input_manager.h"
 #include "l_level_editor.h"
 #include "l_math.h"
+#include "l_model_registry.h"
 #include "l_platform.h"
 #include "l_render_system.h"
 #include "l_resource_manager.h"
 #include "l_shader.h"
 #include "l_transform_system.h"
 #include "l_physics_system.h"
+#include "l_profiler.h"
 
 #include <vector>
 #include <fstream>
 #include <iostream>
 #include <algorithm>
+#include <cstring>
 
 namespace lain
 {
@@ -32,7 +41,7 @@ namespace lain
       };
 
     static f32 constexpr kGridSquareSize{0.5f};
-    static f32 constexpr kHalfGridExtent{20.f};
+    static f32 constexpr kGridFadeDistance{60.f};
     static glm::vec4 constexpr kGreyColour{0.5f, 0.5f, 0.5f, 1.f};
     static glm::vec4 constexpr kRedColour{1.f, 0.0f, 0.0f, 1.f};
     static glm::vec4 constexpr kGreenColour{0.f, 1.0f, 0.0f, 1.f};
@@ -41,33 +50,41 @@ namespace lain
 
     static level_editor_mode _mode;
     static camera3D _camera;
-    static shader _grid;
-    static shader _axisX;
-    static shader _axisZ;
+    static u32 _gridVao;
     static shader _ray;
-    static shader _boundingBox;
     static glm::vec3 _currentCameraDirection;
     static entity_id _selectedEntity;
     static glm::vec3 _imGuiEntityPosition;
     static bool _debugDrawEntityAABB;
     static ray _cameraToCursorRay;
 
-    static i32 GetSquaresToDraw();
+    // Collision shapes come from the model's bounds, these wait for theirs to be streamed in.
+    struct pending_collision final
+    {
+      entity_id _entity;
+      model_id _model;
+    };
+
+    static std::vector<pending_collision> _pendingCollision;
+
     static void ProcessInputInEditMode();
     static void ProcessInputInMoveMode();
-    static void UpdateInMoveMode(f32 deltaTime);
-    static void AddEntityToLevel(i32 selection);
+    static void UpdateInMoveMode();
+    static void AddEntityToLevel(model_id id);
+    static bool AttachModel(entity_id entity, model_id id, glm::vec3 const& position);
+    static void AddPendingCollisionShapes();
     static void UpdateCursorInEditMode();
     static void RemoveEntities();
     static void RemoveSelectedEntity();
     static void UpdateInEditMode();
     static void RenderInEditMode();
     static void RenderInMoveMode();
-    static void DrawGrid();
-    static void DrawWorldAxis();
-    static void DrawEntities();
+    static void DrawGrid(render_snapshot const& snapshot);
+    static void DrawEntities(render_snapshot const& snapshot);
     static void SaveLevel(char const* filename);
-    static void LoadLevel(char const* filename);
+    static void ShowRenderStats();
+    static void ShowFrameStats();
+    static void ShowProfiler();
 
     void Initialise()
     {
@@ -76,6 +93,7 @@ namespace lain
       _debugDrawEntityAABB = false;
 
       _camera._position = glm::vec3(0.f);
+      _camera._previousPosition = glm::vec3(0.f);
       _camera._targetPosition = glm::vec3(0.f);
       _camera._worldUp = glm::vec3(0.f, 1.f, 0.f);
       _camera._speed = 20.f;
@@ -83,67 +101,16 @@ namespace lain
       _camera._lerp = 0.1f;
       _camera._yaw = 0.f;
       _camera._pitch = 0.f;
+      // Computes the basis vectors, otherwise they stay zero until the cursor moves.
+      _camera.ProcessCursor(glm::vec2(0.f));
 
-      // ---------------------------------------------
-      // Create grid vertices and the corresponding vao, math here is terribly
-      // wrong but it does what you want fn
-      // ---------------------------------------------
-      i32 const squares{ level_editor::GetSquaresToDraw() };
-
-      std::vector<f32> vertices;
-
-      for (i32 i{ -squares }; i <= squares; ++i) {
-	// lines along the X axis
-	vertices.push_back(-level_editor::kHalfGridExtent * 2);
-	vertices.push_back(0.f);
-	vertices.push_back(i * level_editor::kGridSquareSize);
-
-	vertices.push_back(level_editor::kHalfGridExtent * 2);
-	vertices.push_back(0.f);
-	vertices.push_back(i * level_editor::kGridSquareSize);
-
-	// lines along the Z axis
-	vertices.push_back(i * level_editor::kGridSquareSize);
-	vertices.push_back(0.f);
-	vertices.push_back(-level_editor::kHalfGridExtent * 2);
-
-	vertices.push_back(i * level_editor::kGridSquareSize);
-	vertices.push_back(0.f);
-	vertices.push_back(level_editor::kHalfGridExtent * 2);
-      }
-
-      _grid = resource_manager::CreatePrimitiveVAO(vertices, GL_STATIC_DRAW);
-
-      // ---------------------------------------------
-      // Create vertices for the X-Z axis
-      // ---------------------------------------------
-      vertices = {
-	0.f,    0.01f, 0.f, // origin
-	1000.f, 0.01f, 0.f, // X
-      };
+      // The grid is generated in the fragment shader, but core profile doesn't
+      // let you draw without a VAO bound, so give it an empty one.
+      glGenVertexArrays(1, &_gridVao);
 
-      _axisX = resource_manager::CreatePrimitiveVAO(vertices, GL_STATIC_DRAW);
-
-      vertices = {
-	0.f, 0.01f, 0.f,    // origin
-	0.f, 0.01f, 1000.f, // Z
-      };
-
-      _axisZ = resource_manager::CreatePrimitiveVAO(vertices, GL_STATIC_DRAW);
-
-      vertices.assign(6, 0.f);
+      std::vector<f32> const vertices(6, 0.f);
 
       _ray = resource_manager::CreatePrimitiveVAO(vertices, GL_DYNAMIC_DRAW);
-
-      std::vector<u32> const indices = {
-	0, 1, 1, 2, 2, 3, 3, 0, // Bottom face
-	4, 5, 5, 6, 6, 7, 7, 4, // Top face
-	0, 4, 1, 5, 2, 6, 3, 7  // Vertical lines
-      };
-
-      vertices.assign(24, 0.f);
-
-      _boundingBox = resource_manager::CreateCubeVAO(vertices, GL_DYNAMIC_DRAW, indices);
     }
 
     void ProcessInput()
@@ -168,8 +135,12 @@ namespace lain
       }
     }
 
-    void Update(f32 const deltaTime)
+    void Update([[maybe_unused]] f32 const deltaTime)
     {
+      LAIN_PROFILE_ZONE("level_editor::Update");
+
+      AddPendingCollisionShapes();
+
       ImGuiIO& io = ImGui::GetIO();
 
       switch (_mode) {
@@ -181,21 +152,47 @@ namespace lain
       case level_editor_mode::move:
 	ConstrainCursorInWindow();
 	io.MouseDrawCursor = false;
-	UpdateInMoveMode(deltaTime);
+	UpdateInMoveMode();
 	break;
       }
     }
 
-    void Render()
+    void FixedUpdate(f32 const deltaTime)
     {
-      glClearColor(0.f, 0.f, 0.f, 1.f);
-      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      if (_mode == level_editor_mode::move) {
+	_camera.SetTargetPosition(deltaTime);
+	_camera.Update(deltaTime);
+      } else {
+	// Nothing to interpolate from when the camera sits still.
+	_camera._previousPosition = _camera._position;
+      }
+    }
 
-      DrawWorldAxis();
+    void BuildSnapshot(f32 const alpha, render_snapshot& snapshot)
+    {
+      render_system::BuildSnapshot(_camera.Interpolated(alpha), snapshot);
+      snapshot._valid = true;
+    }
 
-      DrawGrid();
+    void Render(render_snapshot const& snapshot)
+    {
+      {
+	gpu_timer::scoped_pass const pass{"Clear"};
+
+	glClearColor(0.f, 0.f, 0.f, 1.f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      }
+
+      // Right after switching to the editor the snapshot may still be from the menu.
+      if (snapshot._valid) {
+	DrawEntities(snapshot);
+
+	// After the entities, it's blended.
+	gpu_timer::scoped_pass const pass{"Grid"};
+	DrawGrid(snapshot);
+      }
 
-      DrawEntities();
+      gpu_timer::scoped_pass const pass{"ImGui"};
 
       switch (_mode) {
       case level_editor_mode::edit:
@@ -207,11 +204,6 @@ namespace lain
       }
     }
 
-    static i32 GetSquaresToDraw()
-    {
-      return static_cast<i32>((2 * kHalfGridExtent) / kGridSquareSize);
-    }
-
     static void ProcessInputInEditMode()
     {
       bool const shouldProcessClick{
@@ -278,14 +270,9 @@ namespace lain
       }
     }
 
-    static void UpdateInMoveMode(f32 deltaTime)
+    static void UpdateInMoveMode()
     {
-      _camera.SetTargetPosition(deltaTime);
-      _camera.Update(deltaTime);
-
-      ImGui_ImplOpenGL3_NewFrame();
-      ImGui_ImplSDL2_NewFrame();
-      ImGui::NewFrame();
+      application::NewImGuiFrame();
 
       ImGui::Begin("Options", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
       ImGui::Text("Move mode");
@@ -293,19 +280,12 @@ namespace lain
 		  _camera._position.x,
 		  _camera._position.y,
 		  _camera._position.z);
+      ShowRenderStats();
       ImGui::End();
     }
 
-    static void AddEntityToLevel(i32 selection)
+    static void AddEntityToLevel(model_id id)
     {
-      model_type type;
-
-      if (selection == 0) {
-	type = model_type::maze;
-      } else {
-	type = model_type::ball;
-      }
-
       // ----------------------------
       // Add entity in every system
       // ----------------------------
@@ -316,19 +296,63 @@ namespace lain
 					   glm::vec3(0.f),
 					   glm::vec3(1.f));
 
+      glm::vec3 const position{transform._position};
+
       transform_system::AddEntity(_selectedEntity, std::move(transform));
 
-      resource_manager::AddEntityModelRelationship(_selectedEntity, type);
+      physics_system::AddEntity(_selectedEntity, physics_component{});
 
-      auto const* model = resource_manager::GetModelDataFromEntity(_selectedEntity);
+      // Never got as far as the renderer.
+      if (!AttachModel(_selectedEntity, id, position)) {
+	entity_system::RemoveEntity(_selectedEntity);
+	transform_system::RemoveEntity(_selectedEntity);
+	physics_system::RemoveEntity(_selectedEntity);
 
-      render_system::AddEntity(render_component(model));
+	_selectedEntity = no_entity;
+      }
+    }
 
-      physics_system::AddEntity(_selectedEntity, physics_component{});
+    // Streamed from `position` out when streaming, waited for otherwise. False if the model
+    // couldn't be created (the pool is full, already reported), nothing's added to the renderer then.
+    static bool AttachModel(entity_id entity, model_id id, glm::vec3 const& position)
+    {
+      resource_manager::AddEntityModelRelationship(entity, id);
 
-      for (auto const& mesh : model->_meshes) {
-	physics_system::AddCollisionShapeForEntity(_selectedEntity, mesh._boundingBox);
+      if (resource_manager::IsStreaming()) {
+	resource_manager::StreamModel(id, position);
+      } else {
+	resource_manager::LoadModel(id);
       }
+
+      auto const* model = resource_manager::GetModelDataFromEntity(entity);
+
+      if (model == nullptr) {
+	resource_manager::RemoveEntityModelRelationship(entity);
+	return false;
+      }
+
+      render_system::AddEntity(render_component(model));
+
+      // Collision shapes need the real bounds, not the streaming placeholder's.
+      _pendingCollision.push_back({entity, id});
+      AddPendingCollisionShapes();
+
+      return true;
+    }
+
+    static void AddPendingCollisionShapes()
+    {
+      std::erase_if(_pendingCollision, [](pending_collision const& pending) {
+	if (!resource_manager::IsModelResident(pending._model)) {
+	  return false;
+	}
+
+	for (auto const mesh : resource_manager::GetModelDataFromEntity(pending._entity)->_meshes) {
+	  physics_system::AddCollisionShapeForEntity(pending._entity, resource_manager::GetMesh(mesh)->_boundingBox);
+	}
+
+	return true;
+      });
     }
 
     static void UpdateCursorInEditMode()
@@ -360,6 +384,7 @@ namespace lain
       render_system::RemoveAllEntities();
       physics_system::RemoveAllEntities();
 
+      _pendingCollision.clear();
       _selectedEntity = no_entity;
     }
 
@@ -370,15 +395,14 @@ namespace lain
       render_system::RemoveEntity(_selectedEntity);
       physics_system::RemoveEntity(_selectedEntity);
 
+      std::erase_if(_pendingCollision, [](pending_collision const& pending) { return pending._entity == _selectedEntity; });
       _selectedEntity = no_entity;
     }
 
     static void UpdateInEditMode()
     {
       // TODO: refactor the shit outta this
-      ImGui_ImplOpenGL3_NewFrame();
-      ImGui_ImplSDL2_NewFrame();
-      ImGui::NewFrame();
+      application::NewImGuiFrame();
 
       ImGui::Begin("Options", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
       ImGui::Text("Edit mode");
@@ -388,13 +412,15 @@ namespace lain
 
       static i32 selection{ 0 };
 
-      ImGui::RadioButton("Maze", &selection, 0);
-      ImGui::RadioButton("Ball", &selection, 1);
+      // Whatever model_registry found under res/models.
+      for (u32 i{0}; i < model_registry::GetCount(); ++i) {
+	ImGui::RadioButton(model_registry::Get(i)._name.c_str(), &selection, static_cast<i32>(i));
+      }
 
       ImGui::NewLine();
 
-      if (ImGui::Button("Add")) {
-	AddEntityToLevel(selection);
+      if (ImGui::Button("Add") && static_cast<u32>(selection) < model_registry::GetCount()) {
+	AddEntityToLevel(model_registry::Get(static_cast<u32>(selection))._id);
       }
 
       if (entity_system::GetEntityCount() > 0) {
@@ -425,6 +451,8 @@ namespace lain
 	}
       }
 
+      ShowRenderStats();
+
       ImGui::End();
 
       if (_selectedEntity != no_entity) {
@@ -471,60 +499,62 @@ namespace lain
 
     static void RenderInEditMode()
     {
+      LAIN_PROFILE_ZONE("ImGui::Render");
+      allocation_tracker::scoped_tag const tag{allocation_tracker::tag::imgui};
+
       ImGui::Render();
       ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
     }
 
     static void RenderInMoveMode()
     {
+      LAIN_PROFILE_ZONE("ImGui::Render");
+      allocation_tracker::scoped_tag const tag{allocation_tracker::tag::imgui};
+
       ImGui::Render();
       ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
     }
 
-    static void DrawGrid()
+    static void DrawGrid(render_snapshot const& snapshot)
     {
-      static u32 id{resource_manager::GetShader(kPrimitiveShaderId)->_id};
+      LAIN_PROFILE_ZONE("level_editor::DrawGrid");
 
-      render_system::DrawLines(id, _grid._vao, 1000, _camera.GetViewMatrix(), kGreyColour);
-    }
+      static u32 id{resource_manager::GetShader(kLevelEditorGridShaderId)->_id};
 
-    static void DrawWorldAxis()
-    {
-      static u32 id{resource_manager::GetShader(kPrimitiveShaderId)->_id};
+      render_system::UseShader(id);
+      render_system::SetUniformMat4(id, "viewProjection", snapshot._viewProjection);
+      render_system::SetUniformMat4(id, "inverseViewProjection", glm::inverse(snapshot._viewProjection));
+      render_system::SetUniformVec3(id, "cameraPosition", snapshot._cameraPosition);
+      render_system::SetUniformFloat(id, "gridSpacing", kGridSquareSize);
+      render_system::SetUniformFloat(id, "fadeDistance", kGridFadeDistance);
+      render_system::SetUniformVec4(id, "gridColour", kGreyColour);
+      render_system::SetUniformVec4(id, "axisXColour", kRedColour);
+      render_system::SetUniformVec4(id, "axisZColour", kGreenColour);
 
-      render_system::DrawLines(id, _axisX._vao, 2, _camera.GetViewMatrix(), kRedColour);
+      glEnable(GL_BLEND);
+      glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-      render_system::DrawLines(id, _axisZ._vao, 2, _camera.GetViewMatrix(), kGreenColour);
+      gl_state::BindVertexArray(_gridVao);
+      glDrawArrays(GL_TRIANGLES, 0, 3);
+
+      glDisable(GL_BLEND);
     }
 
-    static void DrawEntities()
+    static void DrawEntities(render_snapshot const& snapshot)
     {
-      static u32 id{resource_manager::GetShader(kPrimitiveShaderId)->_id};
-
       if (_debugDrawEntityAABB) {
 	for (std::size_t i{0}; i < entity_system::GetEntityCount(); ++i) {
 	  for (auto const& aabb : physics_system::GetCollisionShapes(i)) {
-	    f32 vertices[] = {
-	      aabb._min.x, aabb._min.y, aabb._min.z,
-	      aabb._max.x, aabb._min.y, aabb._min.z,
-	      aabb._max.x, aabb._max.y, aabb._min.z,
-	      aabb._min.x, aabb._max.y, aabb._min.z,
-	      aabb._min.x, aabb._min.y, aabb._max.z,
-	      aabb._max.x, aabb._min.y, aabb._max.z,
-	      aabb._max.x, aabb._max.y, aabb._max.z,
-	      aabb._min.x, aabb._max.y, aabb._max.z,
-	    };
-
-	    glBindVertexArray(_boundingBox._vao);
-	    glBindBuffer(GL_ARRAY_BUFFER, _boundingBox._vbo);
-	    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-
-	    render_system::DrawBoundingBox(id, _boundingBox._vao, _camera.GetViewMatrix(), kYellowColour);
+	    debug_draw::Box(aabb, kYellowColour);
 	  }
 	}
       }
 
-      render_system::DrawEntities(_camera);
+      render_system::DrawEntities(snapshot);
+
+      gpu_timer::scoped_pass const pass{"Debug lines"};
+
+      debug_draw::Flush(snapshot._viewProjection);
     }
 
     static void SaveLevel(char const* filename)
@@ -563,10 +593,10 @@ namespace lain
 	}
 
 	// Get transform.
-	auto const transform = transform_system::GetTransform(i);
+	auto const& transform = transform_system::GetTransform(i);
 
 	// Get physics data.
-	auto const physicsData = physics_system::GetPhysicsComponent(i);
+	auto const& physicsData = physics_system::GetPhysicsComponent(i);
 
 	//
 	// TODO: don't know how to do this yet. stupidddddddddddddddddd
@@ -576,7 +606,7 @@ namespace lain
 	// allocating any memory or potentially make you wait until it loads, which looks and feels
 	// horrible.
 	//
-	auto const modelType = resource_manager::GetModelType(i);
+	auto const modelId = resource_manager::GetModelId(i);
 
 	//
 	// Serialise the fuck out of them.
@@ -597,12 +627,12 @@ namespace lain
 	levelStreamFile.write(reinterpret_cast<char const*>(physicsData._collisionShape.data()), size * sizeof(aabb));
 	levelStreamFile.write(reinterpret_cast<char const*>(physicsData._collisionShapeStart.data()), size * sizeof(aabb));
 
-	// This one's also easy.
-	levelStreamFile.write(reinterpret_cast<char const*>(&modelType), sizeof(model_type));
+	// This one's also easy, ids are hashes of the model's path so they stay the same.
+	levelStreamFile.write(reinterpret_cast<char const*>(&modelId), sizeof(model_id));
       }
     }
 
-    static void LoadLevel(char const* filename)
+    void LoadLevel(char const* filename)
     {
       std::stringstream ss;
       ss << "levels/" << filename << ".level";
@@ -616,7 +646,7 @@ namespace lain
 
       transform_component transform;
       physics_component physicsData;
-      model_type modelType;
+      model_id modelId;
       u32 entityCount;
 
       levelFileStream.read(reinterpret_cast<char*>(&entityCount), sizeof(entityCount));
@@ -633,23 +663,253 @@ namespace lain
 	levelFileStream.read(reinterpret_cast<char*>(physicsData._collisionShape.data()), size * sizeof(aabb));
 	levelFileStream.read(reinterpret_cast<char*>(physicsData._collisionShapeStart.data()), size * sizeof(aabb));
 
-	levelFileStream.read(reinterpret_cast<char*>(&modelType), sizeof(model_type));
+	levelFileStream.read(reinterpret_cast<char*>(&modelId), sizeof(model_id));
+
+	// Renamed or deleted since the level was saved.
+	if (model_registry::Find(modelId) == nullptr) {
+	  std::cerr << __FUNCTION__ << ": entity " << i << " uses a model that isn't there anymore (id " << modelId
+		    << "), skipping it\n";
+	  continue;
+	}
 
 	// TODO: clear the whole scene first
 
 	// TODO: do this per entity!
 
-	// TODO: this crap is repeated twice somewhere
 	auto entityId = entity_system::AddEntity();
+	glm::vec3 const position{transform._position};
 	transform_system::AddEntity(entityId, std::move(transform));
-	resource_manager::AddEntityModelRelationship(entityId, modelType);
-	auto const* model = resource_manager::GetModelDataFromEntity(entityId);
-	render_system::AddEntity(render_component(model));
 	physics_system::AddEntity(entityId, std::move(physicsData));
-	for (auto const& mesh : model->_meshes) {
-	  physics_system::AddCollisionShapeForEntity(entityId, mesh._boundingBox);
+
+	// Doesn't wait when streaming, the closest entities' models come in first.
+	if (!AttachModel(entityId, modelId, position)) {
+	  entity_system::RemoveEntity(entityId);
+	  transform_system::RemoveEntity(entityId);
+	  physics_system::RemoveEntity(entityId);
 	}
       }
     }
+
+    static void ShowRenderStats()
+    {
+      auto const stats = gl_state::GetLastFrameStats();
+      auto const cullStats = render_system::GetCullStats();
+
+      ImGui::NewLine();
+      ImGui::Text("GL binds: %u (%u skipped)", stats._calls, stats._skipped);
+      ImGui::Text("Meshes: %u visible, %u culled", cullStats._visible, cullStats._culled);
+
+      auto const clusterStats = render_system::GetClusterStats();
+
+      ImGui::Text("Clusters: %u visible, %u culled", clusterStats._visible, clusterStats._culled);
+
+      auto const lodStats = render_system::GetLodStats();
+
+      ImGui::Text("Triangles: %u drawn, %u at full detail", lodStats._triangles, lodStats._fullDetailTriangles);
+
+      auto const debugDrawStats = debug_draw::GetStats();
+
+      ImGui::Text("Debug lines: %u vertices (%u dropped)", debugDrawStats._vertices, debugDrawStats._dropped);
+
+      bool occlusionCulling{render_system::IsOcclusionCullingEnabled()};
+
+      if (ImGui::Checkbox("Occlusion culling", &occlusionCulling)) {
+	render_system::SetOcclusionCulling(occlusionCulling);
+      }
+
+      bool lod{render_system::IsLodEnabled()};
+
+      if (ImGui::Checkbox("Levels of detail", &lod)) {
+	render_system::SetLod(lod);
+      }
+
+      bool clusterCulling{render_system::IsClusterCullingEnabled()};
+
+      if (ImGui::Checkbox("Cluster culling", &clusterCulling)) {
+	render_system::SetClusterCulling(clusterCulling);
+      }
+
+      if (occlusionCulling) {
+	auto const occlusionStats = occlusion::GetStats();
+	f32 const percentage{occlusionStats._tested > 0 ? 100.f * occlusionStats._culled / occlusionStats._tested : 0.f};
+
+	ImGui::Text("Occluded: %.1f%% of %u, raster %.3f ms", percentage, occlusionStats._tested, occlusionStats._rasterMs);
+      }
+
+      if (gpu_timer::IsSupported()) {
+	f32 total{0.f};
+
+	for (auto const& pass : gpu_timer::GetLastResults()) {
+	  // Nested passes are already counted in their parent.
+	  if (pass._depth == 0) {
+	    total += pass._ms;
+	  }
+
+	  ImGui::Text("%*sGPU %s: %.3f ms", static_cast<i32>(2 * pass._depth), "", pass._name, pass._ms);
+	}
+
+	ImGui::Text("GPU total: %.3f ms", total);
+      } else {
+	ImGui::Text("GPU timings: unsupported by the driver");
+      }
+
+      auto const& allocations = allocation_tracker::GetLastFrameStats();
+      u32 allocationCount{0};
+      u64 allocationBytes{0};
+
+      for (u32 i{0}; i < allocation_tracker::kTagCount; ++i) {
+	allocationCount += allocations._allocations[i];
+	allocationBytes += allocations._bytes[i];
+      }
+
+      ImGui::Text("Allocations: %u (%llu bytes), frame arena %zu / %zu KiB", allocationCount,
+		  static_cast<unsigned long long>(allocationBytes),
+		  frame_arena::GetHighWaterMark() / 1024, frame_arena::GetCapacity() / 1024);
+
+      for (u32 i{0}; i < allocation_tracker::kTagCount; ++i) {
+	if (allocations._allocations[i] > 0) {
+	  ImGui::Text("  %s: %u (%llu bytes)", allocation_tracker::GetTagName(static_cast<allocation_tracker::tag>(i)),
+		      allocations._allocations[i], static_cast<unsigned long long>(allocations._bytes[i]));
+	}
+      }
+
+      ShowFrameStats();
+      ShowProfiler();
+    }
+
+    static void ShowFrameStats()
+    {
+      if (!ImGui::CollapsingHeader("Frame times")) {
+	return;
+      }
+
+      i32 vsync{static_cast<i32>(application::GetVsync())};
+
+      ImGui::Text("Vsync");
+      ImGui::SameLine();
+      bool vsyncChanged{ImGui::RadioButton("Off", &vsync, static_cast<i32>(application::vsync_mode::off))};
+      ImGui::SameLine();
+      vsyncChanged |= ImGui::RadioButton("On", &vsync, static_cast<i32>(application::vsync_mode::on));
+      ImGui::SameLine();
+      vsyncChanged |= ImGui::RadioButton("Adaptive", &vsync, static_cast<i32>(application::vsync_mode::adaptive));
+
+      if (vsyncChanged) {
+	application::SetVsync(static_cast<application::vsync_mode>(vsync));
+      }
+
+      bool pipelined{application::IsPipelined()};
+
+      if (ImGui::Checkbox("Simulate on a separate thread", &pipelined)) {
+	application::SetPipelined(pipelined);
+      }
+
+      f32 limit{application::GetFrameRateLimit()};
+
+      if (ImGui::SliderFloat("FPS limit (0 = off)", &limit, 0.f, 360.f, "%.0f")) {
+	application::SetFrameRateLimit(limit);
+      }
+
+      u32 const count{frame_stats::GetFrameCount()};
+
+      if (count == 0) {
+	return;
+      }
+
+      auto const summary = frame_stats::Summarise();
+      auto const& latest = frame_stats::GetFrame(count - 1);
+
+      // The ring's storage isn't in order, copy the totals out for the graph.
+      f32* const totals{frame_arena::AllocateArray<f32>(count)};
+
+      for (u32 i{0}; i < count; ++i) {
+	totals[i] = frame_stats::GetFrame(i)._total;
+      }
+
+      ImGui::PlotLines("##frame_times", totals, static_cast<i32>(count), 0, nullptr, 0.f, summary._max, ImVec2(600.f, 80.f));
+
+      ImGui::Text("Last %u frames: avg %.2f ms, p50 %.2f, p95 %.2f, p99 %.2f, max %.2f",
+		  summary._count, summary._average, summary._p50, summary._p95, summary._p99, summary._max);
+      ImGui::Text("Stutters (> 2x median): %u", summary._stutters);
+      ImGui::Text("Input %.2f ms, update %.2f ms, render %.2f ms, swap %.2f ms",
+		  latest._input, latest._update, latest._render, latest._swap);
+
+      if (ImGui::Button("Export CSV")) {
+	frame_stats::ExportCSV("./frame_stats.csv");
+      }
+
+      ImGui::SameLine();
+
+      if (ImGui::Button("Export JSON")) {
+	frame_stats::ExportJSON("./frame_stats.json");
+      }
+    }
+
+    static void ShowProfiler()
+    {
+      if (!ImGui::CollapsingHeader("Profiler")) {
+	return;
+      }
+
+#ifndef LAIN_PROFILER
+      ImGui::Text("Built without LAIN_PROFILER");
+#else
+      if (ImGui::Button("Export Chrome trace")) {
+	profiler::ExportChromeTrace("./profile.json");
+      }
+
+      auto const& zones = profiler::GetLastFrame();
+      u64 const frameStart{profiler::GetLastFrameStart()};
+      u64 const frameEnd{profiler::GetLastFrameEnd()};
+
+      if (zones.empty() || frameEnd <= frameStart) {
+	return;
+      }
+
+      ImGui::Text("Frame: %.3f ms", (frameEnd - frameStart) / 1e6f);
+
+      // Flame graph, one row per nesting level, the whole width is one frame.
+      f32 constexpr kRowHeight{18.f};
+      f32 constexpr kWidth{600.f};
+
+      u32 maxDepth{0};
+
+      for (auto const& z : zones) {
+	maxDepth = std::max(maxDepth, z._depth);
+      }
+
+      ImDrawList* drawList{ImGui::GetWindowDrawList()};
+      ImVec2 const origin{ImGui::GetCursorScreenPos()};
+      f32 const scale{kWidth / (frameEnd - frameStart)};
+      ImVec2 const mouse{ImGui::GetMousePos()};
+      profiler::zone const* hovered{nullptr};
+
+      // Only the main thread, other threads show up in the exported trace.
+      for (auto const& z : zones) {
+	if (z._thread != zones.front()._thread) {
+	  continue;
+	}
+
+	ImVec2 const min{origin.x + (z._start - frameStart) * scale, origin.y + z._depth * kRowHeight};
+	ImVec2 const max{std::max(min.x + 1.f, origin.x + (z._end - frameStart) * scale), min.y + kRowHeight - 1.f};
+	u32 const hash{static_cast<u32>(fnv1a(z._name, static_cast<u32>(std::strlen(z._name))))};
+
+	drawList->AddRectFilled(min, max, IM_COL32(96 + (hash & 0x7f), 96 + (hash >> 8 & 0x7f), 160, 255));
+
+	if (max.x - min.x > ImGui::CalcTextSize(z._name).x + 4.f) {
+	  drawList->AddText(ImVec2(min.x + 2.f, min.y + 2.f), IM_COL32(0, 0, 0, 255), z._name);
+	}
+
+	if (mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y && mouse.y < max.y) {
+	  hovered = &z;
+	}
+      }
+
+      ImGui::Dummy(ImVec2(kWidth, (maxDepth + 1) * kRowHeight));
+
+      if (hovered != nullptr) {
+	ImGui::SetTooltip("%s: %.3f ms", hovered->_name, (hovered->_end - hovered->_start) / 1e6f);
+      }
+#endif
+    }
   };
 };
@@ -0,0 +1,426 @@
+#include "l_lod.h"
+#include "glm/geometric.hpp"
+#include "l_common.h"
+#include "l_mesh_optimiser.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+namespace lain
+{
+  namespace lod
+  {
+    // How far the coarsest level may stray, relative to the mesh's largest extent.
+    static f32 constexpr kMaxError{0.1f};
+    // Not worth a level below that many triangles.
+    static u32 constexpr kMinTriangles{64};
+    // A level has to drop at least a quarter of the triangles of the one before to be kept.
+    static f32 constexpr kMinReduction{0.75f};
+    // How far past the error of the collapses needed a pass goes (squared, so 1.5x the distance).
+    static f32 constexpr kPassErrorScale{2.25f};
+
+    // Symmetric 4x4 matrix of summed planes (xx xy xz xw yy yz yw zz zw ww), area weighted.
+    struct quadric final
+    {
+      double _a[10];
+      double _weight;
+    };
+
+    struct collapse final
+    {
+      u32 _from;
+      u32 _to;
+      f32 _error; // squared
+    };
+
+    struct position_hash final
+    {
+      std::size_t operator()(glm::vec3 const& p) const
+      {
+	return fnv1a64(&p, sizeof(p));
+      }
+    };
+
+    struct position_equal final
+    {
+      bool operator()(glm::vec3 const& a, glm::vec3 const& b) const
+      {
+	return std::memcmp(&a, &b, sizeof(glm::vec3)) == 0;
+      }
+    };
+
+    static void AddPlane(quadric& q, glm::vec3 const& normal, f32 distance, f32 weight);
+    static void AddQuadric(quadric& q, quadric const& other);
+    static f32 GetError(quadric const& q, glm::vec3 const& p);
+    static bool Flips(std::vector<vertex_data> const& vertices,
+		      std::vector<u32> const& indices,
+		      u32 const* triangles,
+		      u32 triangleCount,
+		      u32 from,
+		      u32 to);
+
+    std::vector<u32> Simplify(std::vector<vertex_data> const& vertices,
+			      std::vector<u32> const& indices,
+			      u32 targetIndexCount,
+			      f32 targetError,
+			      f32& resultError)
+    {
+      u32 const vertexCount{static_cast<u32>(vertices.size())};
+      std::vector<u32> result{indices};
+
+      resultError = 0.f;
+
+      if (result.size() <= targetIndexCount) {
+	return result;
+      }
+
+      // Vertices split for normals or texture coordinates are one point of the surface: they
+      // share a quadric, and they're left alone so the split doesn't tear.
+      std::vector<u32> position(vertexCount);
+      std::vector<u32> wedges(vertexCount, 0);
+      {
+	std::unordered_map<glm::vec3, u32, position_hash, position_equal> unique;
+	unique.reserve(vertexCount);
+
+	for (u32 v{0}; v < vertexCount; ++v) {
+	  position[v] = unique.try_emplace(vertices[v]._position, v).first->second;
+	  ++wedges[position[v]];
+	}
+      }
+
+      std::vector<bool> locked(vertexCount, false);
+
+      for (u32 v{0}; v < vertexCount; ++v) {
+	if (wedges[position[v]] > 1) {
+	  locked[position[v]] = true;
+	}
+      }
+
+      // Edges used once each way are inside the surface, anything else is an open border or
+      // non-manifold and keeps both its ends.
+      {
+	std::unordered_map<u64, u32> edges;
+	edges.reserve(result.size());
+
+	auto const key = [](u32 a, u32 b) { return static_cast<u64>(a) << 32 | b; };
+
+	for (u32 i{0}; i < result.size(); i += 3) {
+	  for (u32 j{0}; j < 3; ++j) {
+	    u32 const a{position[result[i + j]]};
+	    u32 const b{position[result[i + (j + 1) % 3]]};
+
+	    if (a != b) {
+	      ++edges[key(a, b)];
+	    }
+	  }
+	}
+
+	for (auto const& [edge, count] : edges) {
+	  u32 const a{static_cast<u32>(edge >> 32)};
+	  u32 const b{static_cast<u32>(edge)};
+	  auto const twin = edges.find(key(b, a));
+
+	  if (count != 1 || twin == edges.end() || twin->second != 1) {
+	    locked[a] = locked[b] = true;
+	  }
+	}
+      }
+
+      std::vector<quadric> quadrics(vertexCount, quadric{});
+
+      for (u32 i{0}; i < result.size(); i += 3) {
+	glm::vec3 const& a{vertices[result[i]]._position};
+	glm::vec3 const& b{vertices[result[i + 1]]._position};
+	glm::vec3 const& c{vertices[result[i + 2]]._position};
+	glm::vec3 const n{glm::cross(b - a, c - a)};
+	f32 const length{glm::length(n)};
+
+	if (length == 0.f) {
+	  continue;
+	}
+
+	glm::vec3 const normal{n / length};
+
+	for (u32 j{0}; j < 3; ++j) {
+	  AddPlane(quadrics[position[result[i + j]]], normal, -glm::dot(normal, a), length * 0.5f);
+	}
+      }
+
+      f32 const errorLimit{targetError * targetError};
+      std::vector<u32> remap(vertexCount);
+      std::vector<bool> touched(vertexCount);
+      std::vector<u32> offsets(vertexCount + 1);
+      std::vector<u32> adjacency;
+      std::vector<collapse> collapses;
+
+      // Passes of independent collapses, cheapest first, until there's nothing left worth doing.
+      while (result.size() > targetIndexCount) {
+	u32 const triangleCount{static_cast<u32>(result.size() / 3)};
+
+	// Triangles around every vertex.
+	std::fill(offsets.begin(), offsets.end(), 0);
+
+	for (u32 const index : result) {
+	  ++offsets[index + 1];
+	}
+
+	std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+	adjacency.resize(result.size());
+
+	{
+	  std::vector<u32> fill(offsets.begin(), offsets.end() - 1);
+
+	  for (u32 i{0}; i < result.size(); ++i) {
+	    adjacency[fill[result[i]]++] = i / 3;
+	  }
+	}
+
+	// Every edge both ways, the same edge shows up once per triangle which doesn't matter.
+	collapses.clear();
+
+	for (u32 i{0}; i < result.size(); i += 3) {
+	  for (u32 j{0}; j < 3; ++j) {
+	    u32 const a{result[i + j]};
+	    u32 const b{result[i + (j + 1) % 3]};
+
+	    for (auto const& [from, to] : {std::pair{a, b}, std::pair{b, a}}) {
+	      if (!locked[position[from]]) {
+		quadric q{quadrics[position[from]]};
+		AddQuadric(q, quadrics[position[to]]);
+
+		collapses.push_back({from, to, GetError(q, vertices[to]._position)});
+	      }
+	    }
+	  }
+	}
+
+	std::sort(collapses.begin(), collapses.end(), [](collapse const& a, collapse const& b) { return a._error < b._error; });
+
+	std::iota(remap.begin(), remap.end(), 0);
+	std::fill(touched.begin(), touched.end(), false);
+
+	u32 const triangleTarget{targetIndexCount / 3};
+	u32 removed{0};
+	u32 applied{0};
+
+	// A collapse takes two triangles with it. The ones about that far down the list set the bar
+	// for this pass, so an expensive one doesn't get in just because the cheap ones around it
+	// are waiting for the next pass.
+	std::size_t const needed{std::min<std::size_t>((triangleCount - triangleTarget) / 2, collapses.size())};
+	f32 const passLimit{needed > 0 ? std::min(collapses[needed - 1]._error * kPassErrorScale, errorLimit) : errorLimit};
+
+	for (auto const& collapse : collapses) {
+	  if (collapse._error > passLimit || triangleCount - removed <= triangleTarget) {
+	    break;
+	  }
+
+	  // Triangles around either end are about to change, the next collapse has to be somewhere else.
+	  if (touched[collapse._from] || touched[collapse._to]) {
+	    continue;
+	  }
+
+	  u32 const* const triangles{&adjacency[offsets[collapse._from]]};
+	  u32 const count{offsets[collapse._from + 1] - offsets[collapse._from]};
+
+	  if (Flips(vertices, result, triangles, count, collapse._from, collapse._to)) {
+	    continue;
+	  }
+
+	  for (u32 i{0}; i < count; ++i) {
+	    u32 const* const triangle{&result[triangles[i] * 3]};
+
+	    if (triangle[0] == collapse._to || triangle[1] == collapse._to || triangle[2] == collapse._to) {
+	      ++removed;
+	    }
+
+	    touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+	  }
+
+	  remap[collapse._from] = collapse._to;
+	  AddQuadric(quadrics[position[collapse._to]], quadrics[position[collapse._from]]);
+	  resultError = std::max(resultError, collapse._error);
+	  ++applied;
+	}
+
+	if (applied == 0) {
+	  break;
+	}
+
+	// Move the collapsed vertices and drop what's left of the triangles between them.
+	u32 write{0};
+
+	for (u32 i{0}; i < result.size(); i += 3) {
+	  u32 const a{remap[result[i]]};
+	  u32 const b{remap[result[i + 1]]};
+	  u32 const c{remap[result[i + 2]]};
+
+	  if (a != b && b != c && a != c) {
+	    result[write++] = a;
+	    result[write++] = b;
+	    result[write++] = c;
+	  }
+	}
+
+	result.resize(write);
+      }
+
+      resultError = std::sqrt(resultError);
+
+      return result;
+    }
+
+    void Generate(mesh_data& mesh)
+    {
+      u32 const vertexCount{static_cast<u32>(mesh._vertices.size())};
+
+      mesh._lods.assign(1, mesh_lod{0, static_cast<u32>(mesh._indices.size()), 0.f});
+
+      if (vertexCount == 0) {
+	return;
+      }
+
+      glm::vec3 min{FLT_MAX};
+      glm::vec3 max{-FLT_MAX};
+
+      for (auto const& vertex : mesh._vertices) {
+	min = glm::min(min, vertex._position);
+	max = glm::max(max, vertex._position);
+      }
+
+      f32 const maxError{kMaxError * std::max({max.x - min.x, max.y - min.y, max.z - min.z})};
+      std::vector<u32> previous{mesh._indices};
+      f32 error{0.f};
+
+      for (u32 level{1}; level < kMaxLods; ++level) {
+	u32 const target{static_cast<u32>(previous.size() / 6 * 3)};
+
+	if (target < kMinTriangles * 3) {
+	  break;
+	}
+
+	// Errors add up from one level to the next, each gets what the ones before left.
+	f32 levelError;
+	std::vector<u32> next{Simplify(mesh._vertices, previous, target, maxError - error, levelError)};
+
+	if (next.size() > previous.size() * kMinReduction) {
+	  break;
+	}
+
+	mesh_optimiser::OptimiseVertexCache(next, vertexCount);
+
+	error += levelError;
+	mesh._lods.push_back(mesh_lod{static_cast<u32>(mesh._indices.size()), static_cast<u32>(next.size()), error});
+	mesh._indices.insert(mesh._indices.end(), next.begin(), next.end());
+
+	previous = std::move(next);
+      }
+    }
+
+    u32 Select(mesh_lod const* lods, u32 lodCount, f32 pixelsPerUnit, u32 current)
+    {
+      if (lodCount == 0) {
+	return 0;
+      }
+
+      current = std::min(current, lodCount - 1);
+
+      // The coarsest that doesn't show, level 0 never does.
+      u32 target{0};
+
+      for (u32 i{lodCount}; i-- > 0;) {
+	if (lods[i]._error * pixelsPerUnit <= kPixelError) {
+	  target = i;
+	  break;
+	}
+      }
+
+      // Finer happens as soon as the current one shows, coarser only once it's well out of sight.
+      while (target > current && lods[target]._error * pixelsPerUnit > kPixelError * kHysteresis) {
+	--target;
+      }
+
+      return target;
+    }
+
+    static void AddPlane(quadric& q, glm::vec3 const& normal, f32 distance, f32 weight)
+    {
+      double const x{normal.x}, y{normal.y}, z{normal.z}, w{distance};
+      double const terms[10] = {x * x, x * y, x * z, x * w, y * y, y * z, y * w, z * z, z * w, w * w};
+
+      for (u32 i{0}; i < 10; ++i) {
+	q._a[i] += terms[i] * weight;
+      }
+
+      q._weight += weight;
+    }
+
+    static void AddQuadric(quadric& q, quadric const& other)
+    {
+      for (u32 i{0}; i < 10; ++i) {
+	q._a[i] += other._a[i];
+      }
+
+      q._weight += other._weight;
+    }
+
+    // Area weighted mean of the squared distances to the planes.
+    static f32 GetError(quadric const& q, glm::vec3 const& p)
+    {
+      if (q._weight <= 0.0) {
+	return 0.f;
+      }
+
+      double const x{p.x}, y{p.y}, z{p.z};
+      double const* a{q._a};
+      double const error{a[0] * x * x + 2.0 * a[1] * x * y + 2.0 * a[2] * x * z + 2.0 * a[3] * x +
+			 a[4] * y * y + 2.0 * a[5] * y * z + 2.0 * a[6] * y +
+			 a[7] * z * z + 2.0 * a[8] * z +
+			 a[9]};
+
+      return static_cast<f32>(std::max(error, 0.0) / q._weight);
+    }
+
+    // Whether moving `from` onto `to` turns any of the triangles around `from` over.
+    static bool Flips(std::vector<vertex_data> const& vertices,
+		      std::vector<u32> const& indices,
+		      u32 const* triangles,
+		      u32 triangleCount,
+		      u32 from,
+		      u32 to)
+    {
+      for (u32 i{0}; i < triangleCount; ++i) {
+	u32 const* const triangle{&indices[triangles[i] * 3]};
+
+	// Those go away.
+	if (triangle[0] == to || triangle[1] == to || triangle[2] == to) {
+	  continue;
+	}
+
+	glm::vec3 corners[3];
+
+	for (u32 j{0}; j < 3; ++j) {
+	  corners[j] = vertices[triangle[j]]._position;
+	}
+
+	glm::vec3 const before{glm::cross(corners[1] - corners[0], corners[2] - corners[0])};
+
+	for (u32 j{0}; j < 3; ++j) {
+	  if (triangle[j] == from) {
+	    corners[j] = vertices[to]._position;
+	  }
+	}
+
+	glm::vec3 const after{glm::cross(corners[1] - corners[0], corners[2] - corners[0])};
+
+	if (glm::dot(before, after) <= 0.f) {
+	  return true;
+	}
+      }
+
+      return false;
+    }
+  };
+};
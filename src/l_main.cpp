@@ -1,13 +1,154 @@
 #include "l_application.h"
+#include <cmath>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <iostream>
 
 using namespace lain;
 
-int main()
+// Whole number above zero, anything else is an error. `option` is for the message.
+static bool ParsePositive(char const* option, char const* value, i32& result)
 {
+  char* end;
+  long const parsed{std::strtol(value, &end, 10)};
+
+  if (end == value || *end != '\0' || parsed <= 0 || parsed > INT32_MAX) {
+    std::cerr << option << ": expected a number above zero, got \"" << value << "\"\n";
+    return false;
+  }
+
+  result = static_cast<i32>(parsed);
+
+  return true;
+}
+
+static bool ParsePositive(char const* option, char const* value, f32& result)
+{
+  char* end;
+  f32 const parsed{std::strtof(value, &end)};
+
+  if (end == value || *end != '\0' || !std::isfinite(parsed) || parsed <= 0.f) {
+    std::cerr << option << ": expected a number above zero, got \"" << value << "\"\n";
+    return false;
+  }
+
+  result = parsed;
+
+  return true;
+}
+
+static void PrintUsage(char const* program)
+{
+  std::cerr << "usage: " << program << " [--headless [--width W] [--height H] [--frames N] [--level FILE]] [--vsync off|on|adaptive] [--fps-limit N] [--serial] [--stream-assets] [--textures none|bc|bc7] [--vertices full|packed] [--strict-allocations] [--frame-stats FILE]\n";
+}
+
+int main(int argc, char* argv[])
+{
+  bool headless{false};
+  application::headless_options options{1280, 720, 1000, ""};
+
+  for (int i{1}; i < argc; ++i) {
+    bool const hasValue{i + 1 < argc};
+
+    if (std::strcmp(argv[i], "--headless") == 0) {
+      headless = true;
+    } else if (std::strcmp(argv[i], "--width") == 0 && hasValue) {
+      if (!ParsePositive(argv[i], argv[i + 1], options._width)) {
+	PrintUsage(argv[0]);
+	return EXIT_FAILURE;
+      }
+
+      ++i;
+    } else if (std::strcmp(argv[i], "--height") == 0 && hasValue) {
+      if (!ParsePositive(argv[i], argv[i + 1], options._height)) {
+	PrintUsage(argv[0]);
+	return EXIT_FAILURE;
+      }
+
+      ++i;
+    } else if (std::strcmp(argv[i], "--frames") == 0 && hasValue) {
+      i32 frames;
+
+      // Zero would never end the run.
+      if (!ParsePositive(argv[i], argv[i + 1], frames)) {
+	PrintUsage(argv[0]);
+	return EXIT_FAILURE;
+      }
+
+      options._frames = static_cast<u32>(frames);
+      ++i;
+    } else if (std::strcmp(argv[i], "--level") == 0 && hasValue) {
+      options._level = argv[++i];
+    } else if (std::strcmp(argv[i], "--vsync") == 0 && hasValue) {
+      char const* mode{argv[++i]};
+
+      if (std::strcmp(mode, "off") == 0) {
+	application::SetVsync(application::vsync_mode::off);
+      } else if (std::strcmp(mode, "on") == 0) {
+	application::SetVsync(application::vsync_mode::on);
+      } else if (std::strcmp(mode, "adaptive") == 0) {
+	application::SetVsync(application::vsync_mode::adaptive);
+      } else {
+	std::cerr << "--vsync: expected off, on or adaptive, got \"" << mode << "\"\n";
+	PrintUsage(argv[0]);
+	return EXIT_FAILURE;
+      }
+    } else if (std::strcmp(argv[i], "--strict-allocations") == 0) {
+      application::SetStrictAllocations(true);
+    } else if (std::strcmp(argv[i], "--stream-assets") == 0) {
+      application::SetStreamAssets(true);
+    } else if (std::strcmp(argv[i], "--textures") == 0 && hasValue) {
+      char const* compression{argv[++i]};
+
+      if (std::strcmp(compression, "none") == 0) {
+	application::SetTextureCompression(texture_cache::compression::none);
+      } else if (std::strcmp(compression, "bc") == 0) {
+	application::SetTextureCompression(texture_cache::compression::bc);
+      } else if (std::strcmp(compression, "bc7") == 0) {
+	application::SetTextureCompression(texture_cache::compression::bc7);
+      } else {
+	std::cerr << "--textures: expected none, bc or bc7, got \"" << compression << "\"\n";
+	PrintUsage(argv[0]);
+	return EXIT_FAILURE;
+      }
+    } else if (std::strcmp(argv[i], "--vertices") == 0 && hasValue) {
+      char const* format{argv[++i]};
+
+      if (std::strcmp(format, "full") == 0) {
+	application::SetVertexFormat(vertex_format::full);
+      } else if (std::strcmp(format, "packed") == 0) {
+	application::SetVertexFormat(vertex_format::packed);
+      } else {
+	std::cerr << "--vertices: expected full or packed, got \"" << format << "\"\n";
+	PrintUsage(argv[0]);
+	return EXIT_FAILURE;
+      }
+    } else if (std::strcmp(argv[i], "--serial") == 0) {
+      application::SetPipelined(false);
+    } else if (std::strcmp(argv[i], "--fps-limit") == 0 && hasValue) {
+      f32 framesPerSecond;
+
+      // Leaving it out is how to run without a limit.
+      if (!ParsePositive(argv[i], argv[i + 1], framesPerSecond)) {
+	PrintUsage(argv[0]);
+	return EXIT_FAILURE;
+      }
+
+      application::SetFrameRateLimit(framesPerSecond);
+      ++i;
+    } else if (std::strcmp(argv[i], "--frame-stats") == 0 && hasValue) {
+      application::SetFrameStatsFile(argv[++i]);
+    } else {
+      PrintUsage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
   bool const fullscreen{true};
+  bool const initialised{headless ? application::InitialiseHeadless(options) : application::Initialise(fullscreen)};
 
-  if (!application::Initialise(fullscreen)) {
+  if (!initialised) {
     application::Shutdown();
     return EXIT_FAILURE;
   }
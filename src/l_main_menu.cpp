@@ -1,8 +1,9 @@
 #include "l_main_menu.h"
 #include "glad/glad.h"
 #include "imgui_impl_opengl3.h"
-#include "imgui_impl_sdl2.h"
+#include "l_application.h"
 #include "l_event_manager.h"
+#include "l_profiler.h"
 
 namespace lain
 {
@@ -14,10 +15,7 @@ namespace lain
 
     void Update()
     {
-      ImGui_ImplOpenGL3_NewFrame();
-      ImGui_ImplSDL2_NewFrame();
-
-      ImGui::NewFrame();
+      application::NewImGuiFrame();
       ImGui::Begin("Menu Options", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
 
       if (ImGui::Button("Play")) {
@@ -41,6 +39,8 @@ namespace lain
 
     void Render()
     {
+      LAIN_PROFILE_ZONE("main_menu::Render");
+
       glClearColor(0.f, 0.f, 0.f, 1.f);
       glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
       ImGui::Render();
@@ -0,0 +1,92 @@
+#include "l_mapped_file.h"
+#include <fstream>
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define LAIN_HAS_MMAP
+#endif
+
+namespace lain
+{
+  bool MapFile(std::filesystem::path const& path, mapped_file& file)
+  {
+    file = {nullptr, 0};
+
+#ifdef LAIN_HAS_MMAP
+    int const fd{open(path.c_str(), O_RDONLY)};
+
+    if (fd < 0) {
+      return false;
+    }
+
+    struct stat info;
+
+    if (fstat(fd, &info) != 0) {
+      close(fd);
+      return false;
+    }
+
+    if (info.st_size == 0) {
+      close(fd);
+      return true;
+    }
+
+    void* data{mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0)};
+
+    // The mapping keeps its own reference to the file.
+    close(fd);
+
+    if (data == MAP_FAILED) {
+      std::cerr << __FUNCTION__ << ": couldn't map " << path << '\n';
+      return false;
+    }
+
+    file = {static_cast<std::byte const*>(data), static_cast<std::size_t>(info.st_size)};
+
+    return true;
+#else
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+
+    if (!stream) {
+      return false;
+    }
+
+    std::size_t const size{static_cast<std::size_t>(stream.tellg())};
+
+    if (size == 0) {
+      return true;
+    }
+
+    auto* data = new std::byte[size];
+
+    stream.seekg(0);
+
+    if (!stream.read(reinterpret_cast<char*>(data), size)) {
+      std::cerr << __FUNCTION__ << ": couldn't read " << path << '\n';
+      delete[] data;
+      return false;
+    }
+
+    file = {data, size};
+
+    return true;
+#endif
+  }
+
+  void UnmapFile(mapped_file& file)
+  {
+    if (file._data != nullptr) {
+#ifdef LAIN_HAS_MMAP
+      munmap(const_cast<std::byte*>(file._data), file._size);
+#else
+      delete[] file._data;
+#endif
+    }
+
+    file = {nullptr, 0};
+  }
+};
@@ -39,6 +39,22 @@ namespace lain
     return tmax >= glm::max(0.f, float(tmin));
   }
 
+  aabb TransformAABB(aabb const& aabb, glm::mat4 const& m)
+  {
+    // Transform the centre as a point and the extent by the absolute value of
+    // the rotation-scale part, no need to transform the 8 corners.
+    glm::vec3 const centre{(aabb._min + aabb._max) * 0.5f};
+    glm::vec3 const extent{(aabb._max - aabb._min) * 0.5f};
+    glm::vec3 const newCentre{m * glm::vec4(centre, 1.f)};
+    glm::vec3 newExtent{0.f};
+
+    for (i32 i{0}; i < 3; ++i) {
+      newExtent += glm::abs(glm::vec3(m[i])) * extent[i];
+    }
+
+    return {newCentre - newExtent, newCentre + newExtent};
+  }
+
   glm::vec4 ScreenSpaceToNormalisedDeviceCoordinates(glm::vec4 const& pos, f32 width, f32 height)
   {
     return glm::vec4{(pos.x * 2.f) / width - 1.f, 1.f - (pos.y * 2.f) / height, 0.f, 0.f};
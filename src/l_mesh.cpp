@@ -1,22 +1,18 @@
 #include "l_mesh.h"
 #include "glad/glad.h"
+#include "l_gl_state.h"
+#include "l_vertex_packing.h"
+#include <algorithm>
+#include <span>
+#include <utility>
 
 namespace lain {
-  static void SetupMesh(mesh& mesh)
+  static void SetupVertices(mesh& mesh, std::vector<vertex_data> const& vertices)
   {
-    glGenVertexArrays(1, &mesh._vao);
-    glGenBuffers(1, &mesh._vbo);
-    glGenBuffers(1, &mesh._ebo);
-
-    glBindVertexArray(mesh._vao);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh._vbo);
-
-    glBufferData(GL_ARRAY_BUFFER, mesh._vertices.size() * sizeof(vertex_data), mesh._vertices.data(),
-		 GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(vertex_data), vertices.data(), GL_STATIC_DRAW);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh._ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh._indices.size() * sizeof(u32),
-		 mesh._indices.data(), GL_STATIC_DRAW);
+    mesh._positionOffset = glm::vec3(0.f);
+    mesh._positionScale = glm::vec3(1.f);
 
     // positions
     glEnableVertexAttribArray(0);
@@ -34,17 +30,101 @@ namespace lain {
 			  reinterpret_cast<void*>(offsetof(vertex_data, _texCoords)));
   }
 
+  static void SetupPackedVertices(mesh& mesh, std::vector<vertex_data> const& vertices)
+  {
+    vertex_packing::quantisation const quantisation{vertex_packing::GetQuantisation(vertices)};
+    std::vector<vertex_packing::packed_vertex> const packed{vertex_packing::Pack(vertices, quantisation)};
+
+    glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(vertex_packing::packed_vertex), packed.data(),
+		 GL_STATIC_DRAW);
+
+    mesh._positionOffset = quantisation._offset;
+    mesh._positionScale = quantisation._scale;
+
+    // positions, 0 to 1 across the bounds
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(vertex_packing::packed_vertex),
+			  reinterpret_cast<void*>(offsetof(vertex_packing::packed_vertex, _position)));
+
+    // normals, octahedral
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(vertex_packing::packed_vertex),
+			  reinterpret_cast<void*>(offsetof(vertex_packing::packed_vertex, _normal)));
+
+    // texcoords
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(vertex_packing::packed_vertex),
+			  reinterpret_cast<void*>(offsetof(vertex_packing::packed_vertex, _texCoords)));
+  }
+
+  static void SetupMesh(mesh& mesh, mesh_data const& data, vertex_format format)
+  {
+    glGenVertexArrays(1, &mesh._vao);
+    glGenBuffers(1, &mesh._vbo);
+    glGenBuffers(1, &mesh._ebo);
+
+    gl_state::BindVertexArray(mesh._vao);
+    gl_state::BindBuffer(GL_ARRAY_BUFFER, mesh._vbo);
+
+    if (format == vertex_format::packed) {
+      SetupPackedVertices(mesh, data._vertices);
+    } else {
+      SetupVertices(mesh, data._vertices);
+    }
+
+    gl_state::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh._ebo);
+
+    // Half the index memory and bandwidth whenever it fits.
+    if (data._vertices.size() <= 65536) {
+      std::vector<u16> const indices(data._indices.begin(), data._indices.end());
+
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(u16), indices.data(), GL_STATIC_DRAW);
+      mesh._indexType = GL_UNSIGNED_SHORT;
+    } else {
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER, data._indices.size() * sizeof(u32),
+		   data._indices.data(), GL_STATIC_DRAW);
+      mesh._indexType = GL_UNSIGNED_INT;
+    }
+
+    mesh._vertexCount = static_cast<u32>(data._vertices.size());
+
+    // Meshes that weren't imported (the placeholder) only have the one level.
+    if (data._lods.empty()) {
+      mesh._lods[0] = mesh_lod{0, static_cast<u32>(data._indices.size()), 0.f};
+      mesh._lodCount = 1;
+    } else {
+      mesh._lodCount = std::min(static_cast<u32>(data._lods.size()), kMaxLods);
+      std::copy(data._lods.begin(), data._lods.begin() + mesh._lodCount, mesh._lods);
+    }
+  }
+
   mesh::mesh(std::vector<vertex_data>&& vertices,
 	     std::vector<unsigned int>&& indices,
 	     std::vector<mesh_texture>&& textures,
 	     glm::vec3 const& diffuseColour,
-	     aabb&& boundingBox)
-    : _vertices{vertices},
-      _indices{indices},
-      _textures{textures},
-      _boundingBox{boundingBox},
-      _diffuseColour{diffuseColour}
+	     aabb&& boundingBox,
+	     vertex_format format,
+	     mesh_residency residency)
+    : mesh(mesh_data{std::move(vertices), std::move(indices), std::move(textures), boundingBox, diffuseColour, {}, {}}, format,
+	   residency)
   {
-    SetupMesh(*this);
+  }
+
+  mesh::mesh(mesh_data&& data, vertex_format format, mesh_residency residency)
+    : _textures{std::move(data._textures)},
+      _boundingBox{data._boundingBox},
+      _diffuseColour{data._diffuseColour},
+      _clusters{std::move(data._clusters)},
+      _collision{0, 0, 0, 0}
+  {
+    // Taken over so they're freed when this returns, whatever the caller does with `data`.
+    mesh_data const uploaded{std::move(data)};
+
+    SetupMesh(*this, uploaded, format);
+
+    if (residency == mesh_residency::collision) {
+      // Collisions go against the full mesh.
+      _collision = collision_mesh::Add(uploaded._vertices, std::span{uploaded._indices}.first(_lods[0]._indexCount));
+    }
   }
 };
@@ -0,0 +1,315 @@
+#include "l_mesh_cache.h"
+#include "l_asset_pack.h"
+#include "l_common.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+
+namespace lain
+{
+  namespace mesh_cache
+  {
+    static u32 constexpr kMagic{0x48534d4c}; // "LMSH"
+
+    // The vertices are copied in and out as a block.
+    static_assert(sizeof(vertex_data) == 8 * sizeof(f32) && std::is_trivially_copyable_v<vertex_data>);
+    static_assert(sizeof(mesh_lod) == 3 * sizeof(u32) && std::is_trivially_copyable_v<mesh_lod>);
+    static_assert(sizeof(mesh_cluster) == 10 * sizeof(u32) && std::is_trivially_copyable_v<mesh_cluster>);
+
+    struct file_header final
+    {
+      u32 _magic;
+      u32 _version;
+      u64 _sourceHash;
+      u32 _meshCount;
+      u32 _padding;
+    };
+
+    struct mesh_header final
+    {
+      u32 _vertexCount;
+      u32 _indexCount;
+      u32 _textureCount;
+      u32 _indexSize; // 2 or 4 bytes
+      u32 _lodCount;
+      u32 _clusterCount;
+      f32 _min[3];
+      f32 _max[3];
+      f32 _diffuseColour[3];
+    };
+
+    // Sequential reads out of the mapped file that fail instead of running off the end.
+    struct reader final
+    {
+      std::byte const* _data;
+      std::size_t _size;
+      std::size_t _offset;
+
+      bool Read(void* destination, std::size_t size)
+      {
+	if (size > _size - _offset) {
+	  return false;
+	}
+
+	std::memcpy(destination, _data + _offset, size);
+	_offset += size;
+
+	return true;
+      }
+
+      bool ReadString(std::string& string)
+      {
+	u32 length;
+
+	if (!Read(&length, sizeof(length))) {
+	  return false;
+	}
+
+	string.resize(length);
+
+	return Read(string.data(), length);
+      }
+    };
+
+    static bool ReadMeshes(reader& in, u32 count, std::vector<mesh_data>& meshes);
+    static void WriteString(std::ofstream& out, std::string const& string);
+
+    u64 HashSource(std::filesystem::path const& source)
+    {
+      u64 hash{fnv1a64(nullptr, 0)}; // just the offset basis
+
+      std::filesystem::path materials{source};
+      materials.replace_extension(".mtl");
+
+      for (auto const& path : {source, materials}) {
+	mapped_file file;
+
+	if (!asset_pack::Open(path, file)) {
+	  continue;
+	}
+
+	hash = fnv1a64(file._data, file._size, hash);
+
+	asset_pack::Close(file);
+      }
+
+      return hash;
+    }
+
+    std::filesystem::path GetCachePath(std::filesystem::path const& source)
+    {
+      std::filesystem::path path{asset_pack::GetCachePath("./res/cache", source)};
+      path.replace_extension(".lmesh");
+
+      return path;
+    }
+
+    bool Write(std::filesystem::path const& file, u64 sourceHash, std::vector<mesh_data> const& meshes)
+    {
+      std::error_code error;
+      std::filesystem::create_directories(file.parent_path(), error);
+
+      // Written next to the real one and renamed, so a crash never leaves half a cache behind.
+      std::filesystem::path temporary{file};
+      temporary += ".tmp";
+
+      std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+
+      if (!out) {
+	std::cerr << __FUNCTION__ << ": couldn't open " << temporary << '\n';
+	return false;
+      }
+
+      file_header const header{kMagic, kVersion, sourceHash, static_cast<u32>(meshes.size()), 0};
+
+      out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+
+      for (auto const& mesh : meshes) {
+	bool const shortIndices{mesh._vertices.size() <= 65536};
+
+	mesh_header const meshHeader{
+	  static_cast<u32>(mesh._vertices.size()),
+	  static_cast<u32>(mesh._indices.size()),
+	  static_cast<u32>(mesh._textures.size()),
+	  shortIndices ? 2u : 4u,
+	  static_cast<u32>(mesh._lods.size()),
+	  static_cast<u32>(mesh._clusters.size()),
+	  {mesh._boundingBox._min.x, mesh._boundingBox._min.y, mesh._boundingBox._min.z},
+	  {mesh._boundingBox._max.x, mesh._boundingBox._max.y, mesh._boundingBox._max.z},
+	  {mesh._diffuseColour.x, mesh._diffuseColour.y, mesh._diffuseColour.z}
+	};
+
+	out.write(reinterpret_cast<char const*>(&meshHeader), sizeof(meshHeader));
+
+	for (auto const& texture : mesh._textures) {
+	  WriteString(out, texture._type);
+	  WriteString(out, texture._path);
+	}
+
+	out.write(reinterpret_cast<char const*>(mesh._lods.data()), mesh._lods.size() * sizeof(mesh_lod));
+	out.write(reinterpret_cast<char const*>(mesh._clusters.data()), mesh._clusters.size() * sizeof(mesh_cluster));
+
+	out.write(reinterpret_cast<char const*>(mesh._vertices.data()), mesh._vertices.size() * sizeof(vertex_data));
+
+	if (shortIndices) {
+	  std::vector<u16> const indices(mesh._indices.begin(), mesh._indices.end());
+	  out.write(reinterpret_cast<char const*>(indices.data()), indices.size() * sizeof(u16));
+	} else {
+	  out.write(reinterpret_cast<char const*>(mesh._indices.data()), mesh._indices.size() * sizeof(u32));
+	}
+      }
+
+      out.close();
+
+      if (!out) {
+	std::cerr << __FUNCTION__ << ": couldn't write " << temporary << '\n';
+	std::filesystem::remove(temporary, error);
+	return false;
+      }
+
+      std::filesystem::rename(temporary, file, error);
+
+      if (error) {
+	std::cerr << __FUNCTION__ << ": couldn't rename " << temporary << " to " << file << '\n';
+	std::filesystem::remove(temporary, error);
+	return false;
+      }
+
+      return true;
+    }
+
+    bool Read(std::filesystem::path const& file, u64 sourceHash, std::vector<mesh_data>& meshes)
+    {
+      meshes.clear();
+
+      mapped_file mapped;
+
+      if (!asset_pack::Open(file, mapped)) {
+	return false;
+      }
+
+      reader in{mapped._data, mapped._size, 0};
+      file_header header;
+
+      bool const valid{in.Read(&header, sizeof(header)) &&
+		       header._magic == kMagic &&
+		       header._version == kVersion &&
+		       header._sourceHash == sourceHash};
+
+      bool const ok{valid && ReadMeshes(in, header._meshCount, meshes)};
+
+      asset_pack::Close(mapped);
+
+      if (valid && !ok) {
+	std::cerr << __FUNCTION__ << ": " << file << " is truncated\n";
+      }
+
+      if (!ok) {
+	meshes.clear();
+      }
+
+      return ok;
+    }
+
+    static bool ReadMeshes(reader& in, u32 count, std::vector<mesh_data>& meshes)
+    {
+      if (static_cast<std::size_t>(count) * sizeof(mesh_header) > in._size - in._offset) {
+	return false;
+      }
+
+      meshes.resize(count);
+
+      for (auto& mesh : meshes) {
+	mesh_header header;
+
+	if (!in.Read(&header, sizeof(header))) {
+	  return false;
+	}
+
+	mesh._boundingBox = aabb{glm::vec3(header._min[0], header._min[1], header._min[2]),
+				 glm::vec3(header._max[0], header._max[1], header._max[2])};
+	mesh._diffuseColour = glm::vec3(header._diffuseColour[0], header._diffuseColour[1], header._diffuseColour[2]);
+
+	mesh._textures.resize(header._textureCount);
+
+	for (auto& texture : mesh._textures) {
+	  texture._id = 0;
+
+	  if (!in.ReadString(texture._type) || !in.ReadString(texture._path)) {
+	    return false;
+	  }
+	}
+
+	if (header._lodCount > kMaxLods) {
+	  return false;
+	}
+
+	mesh._lods.resize(header._lodCount);
+
+	if (!in.Read(mesh._lods.data(), header._lodCount * sizeof(mesh_lod))) {
+	  return false;
+	}
+
+	for (auto const& lod : mesh._lods) {
+	  if (lod._firstIndex > header._indexCount || lod._indexCount > header._indexCount - lod._firstIndex) {
+	    return false;
+	  }
+	}
+
+	// Clusters only cover level 0.
+	u32 const levelZeroCount{mesh._lods.empty() ? header._indexCount : mesh._lods[0]._indexCount};
+
+	if (header._clusterCount > levelZeroCount / 3) {
+	  return false;
+	}
+
+	mesh._clusters.resize(header._clusterCount);
+
+	if (!in.Read(mesh._clusters.data(), header._clusterCount * sizeof(mesh_cluster))) {
+	  return false;
+	}
+
+	for (auto const& cluster : mesh._clusters) {
+	  if (cluster._firstIndex > levelZeroCount || cluster._indexCount > levelZeroCount - cluster._firstIndex) {
+	    return false;
+	  }
+	}
+
+	// Guard the sizes before allocating anything, a broken count could be huge.
+	std::size_t const vertexBytes{static_cast<std::size_t>(header._vertexCount) * sizeof(vertex_data)};
+	std::size_t const indexBytes{static_cast<std::size_t>(header._indexCount) * header._indexSize};
+
+	if ((header._indexSize != 2 && header._indexSize != 4) || vertexBytes + indexBytes > in._size - in._offset) {
+	  return false;
+	}
+
+	mesh._vertices.resize(header._vertexCount);
+	mesh._indices.resize(header._indexCount);
+
+	in.Read(mesh._vertices.data(), vertexBytes);
+
+	if (header._indexSize == 2) {
+	  // Widened back, the CPU side always works with u32.
+	  for (auto& index : mesh._indices) {
+	    u16 shortIndex{0};
+	    in.Read(&shortIndex, sizeof(shortIndex));
+	    index = shortIndex;
+	  }
+	} else {
+	  in.Read(mesh._indices.data(), indexBytes);
+	}
+      }
+
+      return true;
+    }
+
+    static void WriteString(std::ofstream& out, std::string const& string)
+    {
+      u32 const length{static_cast<u32>(string.size())};
+
+      out.write(reinterpret_cast<char const*>(&length), sizeof(length));
+      out.write(string.data(), length);
+    }
+  };
+};
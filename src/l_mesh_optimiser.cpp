@@ -0,0 +1,384 @@
+#include "l_mesh_optimiser.h"
+#include "glm/geometric.hpp"
+#include "l_common.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+namespace lain
+{
+  namespace mesh_optimiser
+  {
+    // Forsyth's scoring, with his constants. The LRU here is only the model the
+    // ordering is built against, the stats are measured with the FIFO above.
+    static u32 constexpr kLruSize{32};
+    static f32 constexpr kCacheDecayPower{1.5f};
+    static f32 constexpr kLastTriangleScore{0.75f};
+    static f32 constexpr kValenceBoostScale{2.f};
+    static f32 constexpr kValenceBoostPower{0.5f};
+
+    static u32 constexpr kNone{~0u};
+
+    // Welding compares whole vertices, they're plain floats without padding.
+    static_assert(sizeof(vertex_data) == 8 * sizeof(f32));
+
+    struct vertex_hash final
+    {
+      std::size_t operator()(vertex_data const& v) const
+      {
+	return fnv1a64(&v, sizeof(v));
+      }
+    };
+
+    struct vertex_equal final
+    {
+      bool operator()(vertex_data const& a, vertex_data const& b) const
+      {
+	return std::memcmp(&a, &b, sizeof(vertex_data)) == 0;
+      }
+    };
+
+    static f32 GetVertexScore(i32 cachePosition, u32 remainingTriangles);
+
+    cache_stats AnalyseVertexCache(std::vector<u32> const& indices, u32 vertexCount, u32 cacheSize)
+    {
+      if (indices.empty() || vertexCount == 0) {
+	return {0.f, 0.f};
+      }
+
+      // A vertex is still in the FIFO if fewer than `cacheSize` misses happened since it went in.
+      std::vector<u32> insertedAt(vertexCount, 0);
+      u32 misses{0};
+      u32 time{cacheSize + 1};
+
+      for (u32 const index : indices) {
+	if (time - insertedAt[index] > cacheSize) {
+	  insertedAt[index] = time++;
+	  ++misses;
+	}
+      }
+
+      return {static_cast<f32>(misses) / (indices.size() / 3), static_cast<f32>(misses) / vertexCount};
+    }
+
+    u32 WeldVertices(mesh_data& mesh)
+    {
+      std::unordered_map<vertex_data, u32, vertex_hash, vertex_equal> unique;
+      std::vector<vertex_data> welded;
+      std::vector<u32> remap(mesh._vertices.size());
+
+      unique.reserve(mesh._vertices.size());
+      welded.reserve(mesh._vertices.size());
+
+      for (u32 i{0}; i < mesh._vertices.size(); ++i) {
+	auto const [it, inserted] = unique.try_emplace(mesh._vertices[i], static_cast<u32>(welded.size()));
+
+	if (inserted) {
+	  welded.push_back(mesh._vertices[i]);
+	}
+
+	remap[i] = it->second;
+      }
+
+      for (auto& index : mesh._indices) {
+	index = remap[index];
+      }
+
+      mesh._vertices = std::move(welded);
+
+      return static_cast<u32>(mesh._vertices.size());
+    }
+
+    void OptimiseVertexCache(std::vector<u32>& indices, u32 vertexCount)
+    {
+      u32 const triangleCount{static_cast<u32>(indices.size() / 3)};
+
+      if (triangleCount == 0) {
+	return;
+      }
+
+      // Triangles using each vertex, packed: vertex v owns [_offsets[v], _offsets[v] + remaining[v]).
+      std::vector<u32> remaining(vertexCount, 0);
+      std::vector<u32> offsets(vertexCount + 1, 0);
+      std::vector<u32> adjacency(indices.size());
+
+      for (u32 const index : indices) {
+	++remaining[index];
+      }
+
+      std::partial_sum(remaining.begin(), remaining.end(), offsets.begin() + 1);
+
+      {
+	std::vector<u32> fill(offsets.begin(), offsets.end() - 1);
+
+	for (u32 i{0}; i < indices.size(); ++i) {
+	  adjacency[fill[indices[i]]++] = i / 3;
+	}
+      }
+
+      std::vector<i32> cachePosition(vertexCount, -1);
+      std::vector<f32> vertexScore(vertexCount);
+      std::vector<f32> triangleScore(triangleCount, 0.f);
+      std::vector<bool> emitted(triangleCount, false);
+
+      for (u32 v{0}; v < vertexCount; ++v) {
+	vertexScore[v] = GetVertexScore(-1, remaining[v]);
+      }
+
+      u32 best{0};
+
+      for (u32 t{0}; t < triangleCount; ++t) {
+	triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+
+	if (triangleScore[t] > triangleScore[best]) {
+	  best = t;
+	}
+      }
+
+      std::vector<u32> ordered;
+      ordered.reserve(indices.size());
+
+      u32 cache[kLruSize + 3];
+      u32 cacheCount{0};
+      u32 cursor{0}; // nothing before it is left to emit
+
+      while (ordered.size() < indices.size()) {
+	// Nothing in the cache is worth anything, start somewhere new.
+	if (best == kNone) {
+	  while (emitted[cursor]) {
+	    ++cursor;
+	  }
+
+	  best = cursor;
+	}
+
+	u32 const* const triangle{&indices[best * 3]};
+
+	emitted[best] = true;
+	ordered.insert(ordered.end(), triangle, triangle + 3);
+
+	// Most recent first, what falls off the end gets its position reset below.
+	u32 next[kLruSize + 3];
+	u32 nextCount{0};
+
+	for (u32 i{0}; i < 3; ++i) {
+	  u32 const v{triangle[i]};
+	  u32* const first{&adjacency[offsets[v]]};
+	  u32* const last{first + remaining[v]};
+
+	  *std::find(first, last, best) = *(last - 1);
+	  --remaining[v];
+
+	  next[nextCount++] = v;
+	}
+
+	for (u32 i{0}; i < cacheCount; ++i) {
+	  if (cache[i] != triangle[0] && cache[i] != triangle[1] && cache[i] != triangle[2]) {
+	    next[nextCount++] = cache[i];
+	  }
+	}
+
+	for (u32 i{0}; i < nextCount; ++i) {
+	  u32 const v{next[i]};
+
+	  cachePosition[v] = i < kLruSize ? static_cast<i32>(i) : -1;
+	  vertexScore[v] = GetVertexScore(cachePosition[v], remaining[v]);
+	}
+
+	best = kNone;
+	f32 bestScore{-1.f};
+
+	for (u32 i{0}; i < nextCount; ++i) {
+	  u32 const v{next[i]};
+
+	  for (u32 j{offsets[v]}; j < offsets[v] + remaining[v]; ++j) {
+	    u32 const t{adjacency[j]};
+
+	    triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+
+	    if (triangleScore[t] > bestScore) {
+	      bestScore = triangleScore[t];
+	      best = t;
+	    }
+	  }
+	}
+
+	cacheCount = std::min(nextCount, kLruSize);
+	std::copy(next, next + cacheCount, cache);
+      }
+
+      indices = std::move(ordered);
+    }
+
+    void OptimiseOverdraw(std::vector<u32>& indices, std::vector<vertex_data> const& vertices, f32 threshold)
+    {
+      u32 const triangleCount{static_cast<u32>(indices.size() / 3)};
+      u32 const vertexCount{static_cast<u32>(vertices.size())};
+
+      if (triangleCount < 2) {
+	return;
+      }
+
+      // Clusters start wherever a triangle misses on all three vertices: the cache starts
+      // over there anyway, so moving clusters around barely changes the ACMR.
+      std::vector<u32> clusters;
+      {
+	std::vector<u32> insertedAt(vertexCount, 0);
+	u32 time{kCacheSize + 1};
+
+	for (u32 t{0}; t < triangleCount; ++t) {
+	  u32 misses{0};
+
+	  for (u32 i{0}; i < 3; ++i) {
+	    u32 const v{indices[t * 3 + i]};
+
+	    if (time - insertedAt[v] > kCacheSize) {
+	      insertedAt[v] = time++;
+	      ++misses;
+	    }
+	  }
+
+	  if (t == 0 || misses == 3) {
+	    clusters.push_back(t);
+	  }
+	}
+      }
+
+      if (clusters.size() < 2) {
+	return;
+      }
+
+      // Area weighted centre of the whole mesh, then of every cluster along with its
+      // average normal. Clusters facing away from the centre are in front of the rest.
+      glm::vec3 meshCentre{0.f};
+      f32 meshArea{0.f};
+      std::vector<f32> keys(clusters.size());
+      std::vector<glm::vec3> clusterCentres(clusters.size());
+      std::vector<glm::vec3> clusterNormals(clusters.size());
+
+      for (u32 c{0}; c < clusters.size(); ++c) {
+	u32 const end{c + 1 < clusters.size() ? clusters[c + 1] : triangleCount};
+	glm::vec3 centre{0.f};
+	glm::vec3 normal{0.f};
+	f32 area{0.f};
+
+	for (u32 t{clusters[c]}; t < end; ++t) {
+	  glm::vec3 const& a{vertices[indices[t * 3]]._position};
+	  glm::vec3 const& b{vertices[indices[t * 3 + 1]]._position};
+	  glm::vec3 const& d{vertices[indices[t * 3 + 2]]._position};
+	  glm::vec3 const n{glm::cross(b - a, d - a)};
+	  f32 const triangleArea{glm::length(n)};
+
+	  centre += (a + b + d) * (triangleArea / 3.f);
+	  normal += n;
+	  area += triangleArea;
+	}
+
+	meshCentre += centre;
+	meshArea += area;
+	clusterCentres[c] = area > 0.f ? centre / area : centre;
+	clusterNormals[c] = normal;
+      }
+
+      if (meshArea > 0.f) {
+	meshCentre /= meshArea;
+      }
+
+      for (u32 c{0}; c < clusters.size(); ++c) {
+	f32 const length{glm::length(clusterNormals[c])};
+
+	keys[c] = length > 0.f ? glm::dot(clusterNormals[c] / length, clusterCentres[c] - meshCentre) : 0.f;
+      }
+
+      std::vector<u32> order(clusters.size());
+      std::iota(order.begin(), order.end(), 0);
+      std::stable_sort(order.begin(), order.end(), [&keys](u32 a, u32 b) { return keys[a] > keys[b]; });
+
+      std::vector<u32> sorted;
+      sorted.reserve(indices.size());
+
+      for (u32 const c : order) {
+	u32 const end{c + 1 < clusters.size() ? clusters[c + 1] : triangleCount};
+
+	sorted.insert(sorted.end(), indices.begin() + clusters[c] * 3, indices.begin() + end * 3);
+      }
+
+      if (AnalyseVertexCache(sorted, vertexCount)._acmr <= AnalyseVertexCache(indices, vertexCount)._acmr * threshold) {
+	indices = std::move(sorted);
+      }
+    }
+
+    void OptimiseVertexFetch(mesh_data& mesh)
+    {
+      std::vector<u32> remap(mesh._vertices.size(), kNone);
+      std::vector<vertex_data> ordered;
+
+      ordered.reserve(mesh._vertices.size());
+
+      // Vertices nothing points to are dropped on the way.
+      for (auto& index : mesh._indices) {
+	if (remap[index] == kNone) {
+	  remap[index] = static_cast<u32>(ordered.size());
+	  ordered.push_back(mesh._vertices[index]);
+	}
+
+	index = remap[index];
+      }
+
+      mesh._vertices = std::move(ordered);
+    }
+
+    void Optimise(mesh_data& mesh)
+    {
+      WeldVertices(mesh);
+
+      u32 const vertexCount{static_cast<u32>(mesh._vertices.size())};
+
+      if (mesh._clusters.empty()) {
+	OptimiseVertexCache(mesh._indices, vertexCount);
+	OptimiseOverdraw(mesh._indices, mesh._vertices);
+      } else {
+	// Triangles stay in their cluster, each one is drawn (or culled) on its own.
+	std::vector<u32> range;
+
+	for (auto const& cluster : mesh._clusters) {
+	  auto const first = mesh._indices.begin() + cluster._firstIndex;
+
+	  range.assign(first, first + cluster._indexCount);
+	  OptimiseVertexCache(range, vertexCount);
+	  OptimiseOverdraw(range, mesh._vertices);
+	  std::copy(range.begin(), range.end(), first);
+	}
+      }
+
+      OptimiseVertexFetch(mesh);
+    }
+
+    static f32 GetVertexScore(i32 cachePosition, u32 remainingTriangles)
+    {
+      // Nothing left to draw with it.
+      if (remainingTriangles == 0) {
+	return -1.f;
+      }
+
+      f32 score{0.f};
+
+      if (cachePosition >= 0) {
+	// The last triangle's vertices get a fixed score, so it isn't reused right away
+	// just because it's the freshest.
+	if (cachePosition < 3) {
+	  score = kLastTriangleScore;
+	} else {
+	  f32 const scale{1.f / (kLruSize - 3)};
+	  score = std::pow(1.f - (cachePosition - 3) * scale, kCacheDecayPower);
+	}
+      }
+
+      // Vertices with few triangles left get a boost, to finish them off and not leave lone
+      // triangles behind.
+      return score + kValenceBoostScale * std::pow(static_cast<f32>(remainingTriangles), -kValenceBoostPower);
+    }
+  };
+};
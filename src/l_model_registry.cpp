@@ -0,0 +1,244 @@
+#include "l_model_registry.h"
+#include "l_asset_pack.h"
+#include "l_common.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+namespace lain
+{
+  namespace model_registry
+  {
+    // At most half full, probes stay short.
+    static u32 constexpr kSlotCount{kMaxModels * 2};
+    static_assert((kSlotCount & (kSlotCount - 1)) == 0, "the slot count has to be a power of two");
+
+    static char const* const kManifestName{"models.manifest"};
+    static std::array<std::string_view, 4> constexpr kExtensions{".obj", ".fbx", ".gltf", ".glb"};
+
+    static std::array<model_id, kSlotCount> _ids; // kNoModel for an empty slot
+    static std::array<u32, kSlotCount> _slots; // index into `_models`
+    static std::vector<model_info> _models;
+
+    static u32 FindSlot(model_id id);
+    static bool ReadManifest(std::filesystem::path const& directory, std::string const& root, std::vector<model_info>& models);
+    static model_info MakeInfo(std::string const& path, std::string const& root);
+    static bool IsModel(std::filesystem::path const& path);
+
+    model_id GetId(std::filesystem::path const& path)
+    {
+      std::string const name{asset_pack::NormaliseName(path)};
+      model_id const id{static_cast<model_id>(fnv1a(name.data(), static_cast<u32>(name.size())))};
+
+      return id == kNoModel ? 1 : id;
+    }
+
+    bool Load(std::filesystem::path const& directory)
+    {
+      std::string const root{asset_pack::NormaliseName(directory)};
+      std::vector<model_info> models;
+
+      bool const valid{ReadManifest(directory, root, models)};
+
+      // Whatever isn't in the manifest gets the defaults. Sorted so the order doesn't depend on the file system.
+      std::vector<std::string> found{asset_pack::List(directory)};
+      std::error_code error;
+      std::filesystem::recursive_directory_iterator it{directory, error};
+
+      // No exceptions, so not a range for.
+      for (; !error && it != std::filesystem::recursive_directory_iterator{}; it.increment(error)) {
+	if (it->is_regular_file()) {
+	  found.push_back(asset_pack::NormaliseName(it->path()));
+	}
+      }
+
+      std::erase_if(found, [](std::string const& path) { return !IsModel(path); });
+      std::sort(found.begin(), found.end());
+      found.erase(std::unique(found.begin(), found.end()), found.end());
+
+      for (auto const& path : found) {
+	models.push_back(MakeInfo(path, root));
+      }
+
+      bool added{true};
+
+      for (auto const& info : models) {
+	added = Add(info) && added;
+      }
+
+      std::cout << __FUNCTION__ << ": " << _models.size() << " models under " << root << '\n';
+
+      return valid && added;
+    }
+
+    bool Add(model_info const& info)
+    {
+      assert(info._id != kNoModel);
+
+      u32 const slot{FindSlot(info._id)};
+
+      if (_ids[slot] == info._id) {
+	if (_models[_slots[slot]]._path != info._path) {
+	  std::cerr << __FUNCTION__ << ": " << info._path << " has the same id as " << _models[_slots[slot]]._path
+		    << ", rename one of them\n";
+	  return false;
+	}
+
+	return true;
+      }
+
+      if (_models.size() == kMaxModels) {
+	std::cerr << __FUNCTION__ << ": more than " << kMaxModels << " models, " << info._path << " isn't registered\n";
+	return false;
+      }
+
+      _ids[slot] = info._id;
+      _slots[slot] = static_cast<u32>(_models.size());
+      _models.push_back(info);
+
+      return true;
+    }
+
+    void Clear()
+    {
+      _ids.fill(kNoModel);
+      _models.clear();
+    }
+
+    u32 GetIndex(model_id id)
+    {
+      if (id == kNoModel) {
+	return kNotFound;
+      }
+
+      u32 const slot{FindSlot(id)};
+
+      return _ids[slot] == id ? _slots[slot] : kNotFound;
+    }
+
+    u32 GetCount()
+    {
+      return static_cast<u32>(_models.size());
+    }
+
+    model_info const& Get(u32 index)
+    {
+      return _models[index];
+    }
+
+    model_info const* Find(model_id id)
+    {
+      u32 const index{GetIndex(id)};
+
+      return index != kNotFound ? &_models[index] : nullptr;
+    }
+
+    // The slot holding `id`, or the empty one it would go in. There's always an empty one.
+    static u32 FindSlot(model_id id)
+    {
+      u32 slot{id & (kSlotCount - 1)};
+
+      while (_ids[slot] != kNoModel && _ids[slot] != id) {
+	slot = (slot + 1) & (kSlotCount - 1);
+      }
+
+      return slot;
+    }
+
+    // One model per line, its path relative to the manifest then its flags:
+    //
+    //   # comment
+    //   maze.obj occluder collision
+    //
+    // occluder: drawn into the occlusion buffer, needs the positions so implies collision.
+    // collision: positions are kept on the CPU after the upload.
+    static bool ReadManifest(std::filesystem::path const& directory, std::string const& root, std::vector<model_info>& models)
+    {
+      std::filesystem::path const manifestPath{directory / kManifestName};
+      mapped_file file;
+
+      // Optional, everything gets the defaults without one.
+      if (!asset_pack::Open(manifestPath, file)) {
+	return true;
+      }
+
+      std::string_view text{reinterpret_cast<char const*>(file._data), file._size};
+      bool valid{true};
+      u32 lineNumber{0};
+
+      while (!text.empty()) {
+	std::size_t const end{std::min(text.find('\n'), text.size())};
+	std::string_view line{text.substr(0, end)};
+
+	text.remove_prefix(std::min(end + 1, text.size()));
+	++lineNumber;
+
+	line = line.substr(0, line.find('#'));
+
+	std::vector<std::string_view> words;
+
+	while (!line.empty()) {
+	  std::size_t const start{line.find_first_not_of(" \t\r")};
+
+	  if (start == std::string_view::npos) {
+	    break;
+	  }
+
+	  line.remove_prefix(start);
+
+	  std::size_t const length{std::min(line.find_first_of(" \t\r"), line.size())};
+
+	  words.push_back(line.substr(0, length));
+	  line.remove_prefix(length);
+	}
+
+	if (words.empty()) {
+	  continue;
+	}
+
+	model_info info{MakeInfo(asset_pack::NormaliseName(directory / words[0]), root)};
+
+	for (u32 i{1}; i < words.size(); ++i) {
+	  if (words[i] == "occluder") {
+	    info._isOccluder = true;
+	    info._residency = mesh_residency::collision;
+	  } else if (words[i] == "collision") {
+	    info._residency = mesh_residency::collision;
+	  } else {
+	    std::cerr << __FUNCTION__ << ": " << manifestPath << ":" << lineNumber << ": unknown flag " << words[i] << '\n';
+	    valid = false;
+	  }
+	}
+
+	models.push_back(std::move(info));
+      }
+
+      asset_pack::Close(file);
+
+      return valid;
+    }
+
+    static model_info MakeInfo(std::string const& path, std::string const& root)
+    {
+      // Relative to the directory and without the extension, "props/crate".
+      std::filesystem::path name{std::filesystem::path(path).lexically_relative(root)};
+
+      if (name.empty()) {
+	name = path;
+      }
+
+      name.replace_extension();
+
+      return {GetId(path), path, name.generic_string(), false, mesh_residency::gpu_only};
+    }
+
+    static bool IsModel(std::filesystem::path const& path)
+    {
+      std::string const extension{path.extension().string()};
+
+      return std::find(kExtensions.begin(), kExtensions.end(), extension) != kExtensions.end();
+    }
+  };
+};
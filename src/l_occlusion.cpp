@@ -0,0 +1,340 @@
+#include "l_occlusion.h"
+#include "glm/ext/vector_float4.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <smmintrin.h>
+#include <utility>
+#include <vector>
+
+namespace lain
+{
+  namespace occlusion
+  {
+    struct hiz_level final
+    {
+      u32 _width;
+      u32 _height;
+      std::vector<f32> _depth;
+    };
+
+    using clock = std::chrono::steady_clock;
+
+    static u32 constexpr kMaxLevels{16};
+
+    static u32 constexpr kBoxIndices[] = {
+      0, 1, 2, 0, 2, 3, // -z
+      4, 6, 5, 4, 7, 6, // +z
+      0, 4, 5, 0, 5, 1, // -y
+      3, 2, 6, 3, 6, 7, // +y
+      0, 3, 7, 0, 7, 4, // -x
+      1, 5, 6, 1, 6, 2, // +x
+    };
+
+    static hiz_level _levels[kMaxLevels];
+    static u32 _levelCount;
+    static glm::mat4 _viewProjection;
+    static occlusion_stats _stats;
+
+    static void RasteriseClipSpaceTriangle(glm::vec4 const& c0, glm::vec4 const& c1, glm::vec4 const& c2);
+    static void RasteriseScreenSpaceTriangle(glm::vec3 s0, glm::vec3 s1, glm::vec3 s2);
+    static glm::vec3 ClipSpaceToScreenSpace(glm::vec4 const& c);
+    static f32 ElapsedMs(clock::time_point start);
+
+    void Initialise(u32 width, u32 height)
+    {
+      assert(width % 4 == 0 && "occlusion buffer width has to be a multiple of 4");
+      assert((width & (width - 1)) == 0 && (height & (height - 1)) == 0 && "occlusion buffer has to be a power of two");
+
+      _levelCount = 0;
+
+      while (width > 0 && height > 0 && _levelCount < kMaxLevels) {
+	_levels[_levelCount]._width = width;
+	_levels[_levelCount]._height = height;
+	_levels[_levelCount]._depth.assign(width * height, 1.f);
+
+	++_levelCount;
+	width /= 2;
+	height /= 2;
+      }
+    }
+
+    void BeginFrame(glm::mat4 const& viewProjection)
+    {
+      assert(_levelCount > 0 && "occlusion buffer wasn't initialised");
+
+      _viewProjection = viewProjection;
+      _stats = {};
+
+      std::fill(_levels[0]._depth.begin(), _levels[0]._depth.end(), 1.f);
+    }
+
+    void RasteriseBox(aabb const& box, glm::mat4 const& model)
+    {
+      glm::vec3 const corners[] = {
+	{box._min.x, box._min.y, box._min.z},
+	{box._max.x, box._min.y, box._min.z},
+	{box._max.x, box._max.y, box._min.z},
+	{box._min.x, box._max.y, box._min.z},
+	{box._min.x, box._min.y, box._max.z},
+	{box._max.x, box._min.y, box._max.z},
+	{box._max.x, box._max.y, box._max.z},
+	{box._min.x, box._max.y, box._max.z},
+      };
+
+      RasteriseTriangles(corners, kBoxIndices, std::size(kBoxIndices), model);
+    }
+
+    void RasteriseTriangles(glm::vec3 const* positions,
+			    u32 const* indices,
+			    u32 indexCount,
+			    glm::mat4 const& model)
+    {
+      auto const start = clock::now();
+
+      glm::mat4 const mvp{_viewProjection * model};
+
+      for (u32 i{0}; i + 2 < indexCount; i += 3) {
+	glm::vec4 const c[3] = {
+	  mvp * glm::vec4(positions[indices[i]], 1.f),
+	  mvp * glm::vec4(positions[indices[i + 1]], 1.f),
+	  mvp * glm::vec4(positions[indices[i + 2]], 1.f),
+	};
+
+	// Distance to the near plane (z = -w in GL clip space), negative is behind it.
+	f32 const d[3] = {c[0].z + c[0].w, c[1].z + c[1].w, c[2].z + c[2].w};
+
+	if (d[0] < 0.f && d[1] < 0.f && d[2] < 0.f) {
+	  continue;
+	}
+
+	if (d[0] >= 0.f && d[1] >= 0.f && d[2] >= 0.f) {
+	  RasteriseClipSpaceTriangle(c[0], c[1], c[2]);
+	  continue;
+	}
+
+	// Clip against the near plane, leaves a triangle or a quad.
+	glm::vec4 polygon[4];
+	u32 count{0};
+
+	for (u32 j{0}; j < 3; ++j) {
+	  u32 const k{(j + 1) % 3};
+
+	  if (d[j] >= 0.f) {
+	    polygon[count++] = c[j];
+	  }
+
+	  if ((d[j] >= 0.f) != (d[k] >= 0.f)) {
+	    f32 const t{d[j] / (d[j] - d[k])};
+	    polygon[count++] = c[j] + (c[k] - c[j]) * t;
+	  }
+	}
+
+	for (u32 j{1}; j + 1 < count; ++j) {
+	  RasteriseClipSpaceTriangle(polygon[0], polygon[j], polygon[j + 1]);
+	}
+      }
+
+      ++_stats._occluders;
+      _stats._rasterMs += ElapsedMs(start);
+    }
+
+    void BuildHiZ()
+    {
+      auto const start = clock::now();
+
+      for (u32 l{1}; l < _levelCount; ++l) {
+	hiz_level const& src = _levels[l - 1];
+	hiz_level& dst = _levels[l];
+
+	for (u32 y{0}; y < dst._height; ++y) {
+	  f32 const* row0{&src._depth[(y * 2) * src._width]};
+	  f32 const* row1{&src._depth[(y * 2 + 1) * src._width]};
+
+	  for (u32 x{0}; x < dst._width; ++x) {
+	    dst._depth[y * dst._width + x] = std::max(std::max(row0[x * 2], row0[x * 2 + 1]),
+						      std::max(row1[x * 2], row1[x * 2 + 1]));
+	  }
+	}
+      }
+
+      _stats._rasterMs += ElapsedMs(start);
+    }
+
+    bool IsVisible(aabb const& worldBox)
+    {
+      ++_stats._tested;
+
+      glm::vec3 screenMin{FLT_MAX};
+      glm::vec3 screenMax{-FLT_MAX};
+
+      for (u32 i{0}; i < 8; ++i) {
+	glm::vec3 const corner{(i & 1) ? worldBox._max.x : worldBox._min.x,
+			       (i & 2) ? worldBox._max.y : worldBox._min.y,
+			       (i & 4) ? worldBox._max.z : worldBox._min.z};
+
+	glm::vec4 const c{_viewProjection * glm::vec4(corner, 1.f)};
+
+	if (c.z < -c.w) {
+	  return true;
+	}
+
+	glm::vec3 const s{ClipSpaceToScreenSpace(c)};
+	screenMin = glm::min(screenMin, s);
+	screenMax = glm::max(screenMax, s);
+      }
+
+      hiz_level const& base = _levels[0];
+
+      // Off screen is the frustum culler's business, not ours.
+      if (screenMax.x < 0.f || screenMax.y < 0.f || screenMin.x >= base._width || screenMin.y >= base._height) {
+	return true;
+      }
+
+      // Grow the rectangle by one texel, the rasteriser only samples texel centres.
+      i32 const x0{std::max(static_cast<i32>(std::floor(screenMin.x)) - 1, 0)};
+      i32 const y0{std::max(static_cast<i32>(std::floor(screenMin.y)) - 1, 0)};
+      i32 const x1{std::min(static_cast<i32>(std::floor(screenMax.x)) + 1, static_cast<i32>(base._width) - 1)};
+      i32 const y1{std::min(static_cast<i32>(std::floor(screenMax.y)) + 1, static_cast<i32>(base._height) - 1)};
+
+      // Coarsest level where the rectangle covers at most 3x3 texels.
+      u32 const extent{static_cast<u32>(std::max(x1 - x0, y1 - y0) + 1)};
+      u32 level{0};
+
+      while ((extent >> level) > 2 && level + 1 < _levelCount) {
+	++level;
+      }
+
+      hiz_level const& hiz = _levels[level];
+      f32 farthest{0.f};
+
+      for (i32 y{y0 >> level}; y <= (y1 >> level); ++y) {
+	for (i32 x{x0 >> level}; x <= (x1 >> level); ++x) {
+	  farthest = std::max(farthest, hiz._depth[y * hiz._width + x]);
+	}
+      }
+
+      if (screenMin.z > farthest) {
+	++_stats._culled;
+	return false;
+      }
+
+      return true;
+    }
+
+    occlusion_stats GetStats()
+    {
+      return _stats;
+    }
+
+    f32 GetDepth(u32 x, u32 y)
+    {
+      return _levels[0]._depth[y * _levels[0]._width + x];
+    }
+
+    static void RasteriseClipSpaceTriangle(glm::vec4 const& c0, glm::vec4 const& c1, glm::vec4 const& c2)
+    {
+      RasteriseScreenSpaceTriangle(ClipSpaceToScreenSpace(c0),
+				   ClipSpaceToScreenSpace(c1),
+				   ClipSpaceToScreenSpace(c2));
+    }
+
+    static void RasteriseScreenSpaceTriangle(glm::vec3 s0, glm::vec3 s1, glm::vec3 s2)
+    {
+      hiz_level& base = _levels[0];
+
+      f32 area{(s1.x - s0.x) * (s2.y - s0.y) - (s1.y - s0.y) * (s2.x - s0.x)};
+
+      if (area == 0.f) {
+	return;
+      }
+
+      // Occluders are rendered double sided, just make the winding positive.
+      if (area < 0.f) {
+	std::swap(s1, s2);
+	area = -area;
+      }
+
+      i32 minX{static_cast<i32>(std::floor(std::min({s0.x, s1.x, s2.x})))};
+      i32 minY{static_cast<i32>(std::floor(std::min({s0.y, s1.y, s2.y})))};
+      i32 maxX{static_cast<i32>(std::ceil(std::max({s0.x, s1.x, s2.x})))};
+      i32 maxY{static_cast<i32>(std::ceil(std::max({s0.y, s1.y, s2.y})))};
+
+      minX = std::max(minX, 0);
+      minY = std::max(minY, 0);
+      maxX = std::min(maxX, static_cast<i32>(base._width) - 1);
+      maxY = std::min(maxY, static_cast<i32>(base._height) - 1);
+
+      if (minX > maxX || minY > maxY) {
+	return;
+      }
+
+      // Process 4 texels at a time, the buffer width is a multiple of 4.
+      minX &= ~3;
+
+      // Edge functions E(p) = A * p.x + B * p.y + C, each one is the (scaled)
+      // barycentric weight of the opposite vertex.
+      f32 const a0{s1.y - s2.y}, b0{s2.x - s1.x}, k0{s1.x * s2.y - s1.y * s2.x};
+      f32 const a1{s2.y - s0.y}, b1{s0.x - s2.x}, k1{s2.x * s0.y - s2.y * s0.x};
+      f32 const a2{s0.y - s1.y}, b2{s1.x - s0.x}, k2{s0.x * s1.y - s0.y * s1.x};
+
+      // Depth is affine in screen space.
+      f32 const invArea{1.f / area};
+      f32 const za{(a0 * s0.z + a1 * s1.z + a2 * s2.z) * invArea};
+      f32 const zb{(b0 * s0.z + b1 * s1.z + b2 * s2.z) * invArea};
+      f32 const zk{(k0 * s0.z + k1 * s1.z + k2 * s2.z) * invArea};
+
+      __m128 const laneOffsets{_mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f)};
+      __m128 const zero{_mm_setzero_ps()};
+      __m128 const va0{_mm_set1_ps(a0)}, va1{_mm_set1_ps(a1)}, va2{_mm_set1_ps(a2)}, vza{_mm_set1_ps(za)};
+
+      for (i32 y{minY}; y <= maxY; ++y) {
+	f32 const py{static_cast<f32>(y) + 0.5f};
+	f32* row{&base._depth[y * base._width]};
+
+	__m128 const rowE0{_mm_set1_ps(b0 * py + k0)};
+	__m128 const rowE1{_mm_set1_ps(b1 * py + k1)};
+	__m128 const rowE2{_mm_set1_ps(b2 * py + k2)};
+	__m128 const rowZ{_mm_set1_ps(zb * py + zk)};
+
+	for (i32 x{minX}; x <= maxX; x += 4) {
+	  __m128 const px{_mm_add_ps(_mm_set1_ps(static_cast<f32>(x)), laneOffsets)};
+
+	  __m128 const e0{_mm_add_ps(_mm_mul_ps(va0, px), rowE0)};
+	  __m128 const e1{_mm_add_ps(_mm_mul_ps(va1, px), rowE1)};
+	  __m128 const e2{_mm_add_ps(_mm_mul_ps(va2, px), rowE2)};
+
+	  __m128 const inside{_mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+					 _mm_cmpge_ps(e2, zero))};
+
+	  if (_mm_movemask_ps(inside) == 0) {
+	    continue;
+	  }
+
+	  __m128 const z{_mm_add_ps(_mm_mul_ps(vza, px), rowZ)};
+	  __m128 const old{_mm_loadu_ps(row + x)};
+	  __m128 const nearest{_mm_min_ps(old, z)};
+
+	  _mm_storeu_ps(row + x, _mm_blendv_ps(old, nearest, inside));
+	}
+      }
+    }
+
+    static glm::vec3 ClipSpaceToScreenSpace(glm::vec4 const& c)
+    {
+      hiz_level const& base = _levels[0];
+      f32 const invW{1.f / c.w};
+
+      return glm::vec3((c.x * invW * 0.5f + 0.5f) * base._width,
+		       (c.y * invW * 0.5f + 0.5f) * base._height,
+		       c.z * invW * 0.5f + 0.5f);
+    }
+
+    static f32 ElapsedMs(clock::time_point start)
+    {
+      return std::chrono::duration<f32, std::milli>(clock::now() - start).count();
+    }
+  };
+};
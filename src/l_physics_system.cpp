@@ -1,4 +1,5 @@
 #include "l_physics_system.h"
+#include "l_profiler.h"
 #include "l_transform_system.h"
 #include "glm/ext/vector_float3.hpp"
 
@@ -10,9 +11,11 @@ namespace lain
 
     void Update()
     {
+      LAIN_PROFILE_ZONE("physics_system::Update");
+
       for (u32 i{0}; i < _entities.size(); ++i) {
 	// Get entity's model matrix.
-	auto const model = transform_system::GetTransform(i)._model;
+	auto const& model = transform_system::GetTransform(i)._model;
 
 	for (u32 j{0}; j < _entities[i]._collisionShapeStart.size(); ++j) {
 	  // Update collision shape (it's hardcoded to be an AABB)
@@ -65,7 +68,7 @@ namespace lain
       return _entities[id]._collisionShape;
     }
 
-    physics_component GetPhysicsComponent(entity_id id)
+    physics_component const& GetPhysicsComponent(entity_id id)
     {
       return _entities[id];
     }
@@ -0,0 +1,223 @@
+#include "l_profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+namespace lain
+{
+  namespace profiler
+  {
+    // 512 KiB per thread, a couple of seconds of history at 60 fps with lots of zones.
+    static u32 constexpr kRingSize{16384};
+    static u32 constexpr kMaxDepth{64};
+    static u32 constexpr kMaxThreads{64};
+    // Zones this close to being overwritten may be torn, readers skip them.
+    static u32 constexpr kRingSlack{1024};
+
+    // Only its own thread writes to a ring, `_head` is published with release so
+    // readers on other threads see complete zones.
+    struct thread_ring final
+    {
+      zone _zones[kRingSize];
+      std::atomic<u64> _head; // number of zones ever written
+      u64 _starts[kMaxDepth];
+      char const* _names[kMaxDepth];
+      u32 _depth;
+      u32 _thread;
+    };
+
+    static std::atomic<thread_ring*> _rings[kMaxThreads];
+    static std::atomic<u32> _ringCount;
+    static thread_local thread_ring* _ring;
+
+    static u64 _frameStart;
+    static u64 _lastFrameStart;
+    static u64 _lastFrameEnd;
+    static std::vector<zone> _lastFrame;
+
+    static thread_ring* GetRing();
+
+    void BeginZone(char const* name)
+    {
+      thread_ring* ring{GetRing()};
+
+      if (ring == nullptr) {
+	return;
+      }
+
+      // Zones deeper than this are dropped, keeps the hot path branch-light.
+      if (ring->_depth < kMaxDepth) {
+	ring->_names[ring->_depth] = name;
+	ring->_starts[ring->_depth] = Now();
+      }
+
+      ++ring->_depth;
+    }
+
+    void EndZone()
+    {
+      thread_ring* ring{_ring};
+
+      if (ring == nullptr) {
+	return;
+      }
+
+      assert(ring->_depth > 0 && "EndZone without BeginZone");
+
+      u32 const depth{--ring->_depth};
+
+      if (depth >= kMaxDepth) {
+	return;
+      }
+
+      u64 const head{ring->_head.load(std::memory_order_relaxed)};
+
+      ring->_zones[head & (kRingSize - 1)] = {ring->_names[depth], ring->_starts[depth], Now(), depth, ring->_thread};
+      ring->_head.store(head + 1, std::memory_order_release);
+    }
+
+    u64 Now()
+    {
+      using namespace std::chrono;
+      return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    void BeginFrame()
+    {
+      u64 const now{Now()};
+
+      _lastFrame.clear();
+
+      if (_frameStart != 0) {
+	u32 const ringCount{std::min(_ringCount.load(std::memory_order_relaxed), kMaxThreads)};
+
+	for (u32 i{0}; i < ringCount; ++i) {
+	  thread_ring const* ring{_rings[i].load(std::memory_order_acquire)};
+
+	  if (ring == nullptr) {
+	    continue;
+	  }
+
+	  u64 const head{ring->_head.load(std::memory_order_acquire)};
+	  u64 const tail{head > kRingSize - kRingSlack ? head - (kRingSize - kRingSlack) : 0};
+	  std::size_t const first{_lastFrame.size()};
+
+	  // Zones are stored in the order they end, walk back until we're before the frame.
+	  for (u64 index{head}; index > tail; --index) {
+	    zone const& z{ring->_zones[(index - 1) & (kRingSize - 1)]};
+
+	    if (z._end < _frameStart) {
+	      break;
+	    }
+
+	    if (z._start >= _frameStart && z._end <= now) {
+	      _lastFrame.push_back(z);
+	    }
+	  }
+
+	  std::sort(_lastFrame.begin() + first, _lastFrame.end(), [](zone const& a, zone const& b) {
+	    return a._start < b._start || (a._start == b._start && a._depth < b._depth);
+	  });
+	}
+      }
+
+      _lastFrameStart = _frameStart;
+      _lastFrameEnd = now;
+      _frameStart = now;
+    }
+
+    std::vector<zone> const& GetLastFrame()
+    {
+      return _lastFrame;
+    }
+
+    u64 GetLastFrameStart()
+    {
+      return _lastFrameStart;
+    }
+
+    u64 GetLastFrameEnd()
+    {
+      return _lastFrameEnd;
+    }
+
+    bool ExportChromeTrace(std::filesystem::path const& file)
+    {
+      std::ofstream out(file);
+
+      if (!out.is_open()) {
+	std::cerr << __FUNCTION__ << ": couldn't open " << file << '\n';
+	return false;
+      }
+
+      std::vector<zone> zones;
+      u32 const ringCount{std::min(_ringCount.load(std::memory_order_relaxed), kMaxThreads)};
+
+      for (u32 i{0}; i < ringCount; ++i) {
+	thread_ring const* ring{_rings[i].load(std::memory_order_acquire)};
+
+	if (ring == nullptr) {
+	  continue;
+	}
+
+	u64 const head{ring->_head.load(std::memory_order_acquire)};
+	u64 const tail{head > kRingSize - kRingSlack ? head - (kRingSize - kRingSlack) : 0};
+
+	for (u64 index{tail}; index < head; ++index) {
+	  zones.push_back(ring->_zones[index & (kRingSize - 1)]);
+	}
+      }
+
+      u64 origin{~0ull};
+
+      for (auto const& z : zones) {
+	origin = std::min(origin, z._start);
+      }
+
+      out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+
+      for (u32 i{0}; i < ringCount; ++i) {
+	out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << i
+	    << ",\"args\":{\"name\":\"" << (i == 0 ? "main" : "worker") << ' ' << i << "\"}},\n";
+      }
+
+      // Complete ("X") events, timestamps in microseconds.
+      out.precision(3);
+      out << std::fixed;
+
+      for (std::size_t i{0}; i < zones.size(); ++i) {
+	zone const& z{zones[i]};
+
+	out << "{\"ph\":\"X\",\"name\":\"" << z._name << "\",\"pid\":1,\"tid\":" << z._thread
+	    << ",\"ts\":" << (z._start - origin) / 1000.0
+	    << ",\"dur\":" << (z._end - z._start) / 1000.0 << '}'
+	    << (i + 1 < zones.size() ? ",\n" : "\n");
+      }
+
+      out << "]}\n";
+
+      return out.good();
+    }
+
+    static thread_ring* GetRing()
+    {
+      if (_ring == nullptr) {
+	u32 const index{_ringCount.fetch_add(1, std::memory_order_relaxed)};
+
+	if (index >= kMaxThreads) {
+	  return nullptr;
+	}
+
+	// Never freed, the rings have to stay readable after their thread exits.
+	_ring = new thread_ring{};
+	_ring->_thread = index;
+	_rings[index].store(_ring, std::memory_order_release);
+      }
+
+      return _ring;
+    }
+  };
+};
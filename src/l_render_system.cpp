@@ -2,47 +2,87 @@
 #include "glad/glad.h"
 #include "glm/ext/matrix_clip_space.hpp"
 #include "glm/gtc/type_ptr.hpp"
+#include "glm/matrix.hpp"
 #include "l_camera.h"
+#include "l_cluster.h"
 #include "l_common.h"
+#include "l_gl_state.h"
+#include "l_gpu_timer.h"
+#include "l_lod.h"
 #include "l_mesh.h"
+#include "l_profiler.h"
 #include "l_resource_manager.h"
 #include "l_shader.h"
 #include "l_transform_system.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
 #include <unordered_map>
 
 namespace lain
 {
   namespace render_system
   {
-    // utility class
-    struct pair_hash final
-    {
-      u32 operator()(const std::pair<u32, std::string>& arg) const
-      {
-	const auto hash1 = std::hash<u32>{}(arg.first);
-	const auto hash2 = std::hash<std::string>{}(arg.second);
-	return hash1 ^ (hash2 << 1);
-      }
+    // Program id in the high half, hash of the uniform's name in the low one, so
+    // looking up a location never builds a string. The name is kept to catch two
+    // names hashing the same.
+    struct cached_uniform final
+    {
+      u32 _location;
+      std::string _name;
     };
 
-    using cache_type = std::unordered_map<std::pair<u32, std::string>, u32, pair_hash>;
+    using cache_type = std::unordered_map<u64, cached_uniform>;
 
     static f32 constexpr kFovY{45.f};
     static f32 constexpr kNearPlaneDistance{0.1f};
     static f32 constexpr kFarPlaneDistance{1000.f};
+    static u32 constexpr kOcclusionBufferWidth{256};
+    static u32 constexpr kOcclusionBufferHeight{128};
     static glm::mat4 _perspective;
     static cache_type _uniforms;
     static shader const* _meshWithTextureShader;
     static shader const* _meshWithoutTextureShader;
     static std::vector<render_component> _entities;
-
-    static u32 GetUniformLocation(u32 id, std::string const& uniname);
-    static void DrawMeshWithTexture(mesh const& mesh);
-    static void DrawMeshWithNoTexture(mesh const& mesh);
+    static culling::bounds_soa _bounds;
+    static std::vector<mesh_ref> _boundsOwners;
+    // Scratch for BuildSnapshot.
+    static std::vector<u32> _visible;
+    static culling::cull_stats _cullStats;
+    static culling::cull_stats _drawnCullStats;
+    static bool _occlusionCulling{true};
+    // Levels of detail, kept per entry of `_boundsOwners` for the hysteresis.
+    static std::vector<u32> _lods;
+    static lod_stats _drawnLodStats;
+    static f32 _pixelsPerUnit; // pixels one unit covers one unit away from the camera
+    static bool _lodEnabled{true};
+    static std::vector<u32> _visibleClusters;
+    static culling::cull_stats _drawnClusterStats;
+    static bool _clusterCulling{true};
+    static u32 _indirectBuffer; // the snapshot's draw commands, filled again every frame
+
+    static u32 GetUniformLocation(u32 id, char const* uniname);
+    static void DrawMeshWithTexture(mesh const& mesh, mesh_ref const& ref, mesh_lod const* stale);
+    static void DrawMeshWithNoTexture(mesh const& mesh, mesh_ref const& ref, mesh_lod const* stale);
+    static void DrawMesh(mesh const& mesh, mesh_ref const& ref, mesh_lod const* stale);
+    static void SelectLods(render_snapshot& snapshot);
+    static void BuildDrawCommands(render_snapshot& snapshot);
+    static void BuildBounds(std::vector<glm::mat4> const& models);
+    static void CullOccludedMeshes(glm::mat4 const& viewProjection, std::vector<glm::mat4> const& models);
 
     void Initialise(f32 width, f32 height)
     {
       _perspective = glm::perspective(glm::radians(kFovY), width / height, kNearPlaneDistance, kFarPlaneDistance);
+      _pixelsPerUnit = height / (2.f * std::tan(glm::radians(kFovY) * 0.5f));
+
+      occlusion::Initialise(kOcclusionBufferWidth, kOcclusionBufferHeight);
+
+      glGenBuffers(1, &_indirectBuffer);
 
       _meshWithTextureShader = resource_manager::GetShader(kLevelEditorModelWithTextureShaderId);
 
@@ -57,63 +97,137 @@ namespace lain
 
     void UseShader(u32 id)
     {
-      glUseProgram(id);
+      gl_state::UseProgram(id);
     }
 
-    void SetUniformMat4(u32 id, std::string const& uniname, glm::mat4 const& m)
+    void SetUniformMat4(u32 id, char const* uniname, glm::mat4 const& m)
     {
       glUniformMatrix4fv(GetUniformLocation(id, uniname), 1, false, glm::value_ptr(m));
     }
 
-    void SetUniformVec2(u32 id, std::string const& uniname, glm::vec2 const& value)
+    void SetUniformVec2(u32 id, char const* uniname, glm::vec2 const& value)
     {
       glUniform2f(GetUniformLocation(id, uniname), value.x, value.y);
     }
 
-    void SetUniformVec3(u32 id, std::string const& uniname, glm::vec3 const& value)
+    void SetUniformVec3(u32 id, char const* uniname, glm::vec3 const& value)
     {
       glUniform3f(GetUniformLocation(id, uniname), value.x, value.y, value.z);
     }
 
-    void SetUniformVec4(u32 id, std::string const& uniname, glm::vec4 const& value)
+    void SetUniformVec4(u32 id, char const* uniname, glm::vec4 const& value)
     {
       glUniform4f(GetUniformLocation(id, uniname), value.x, value.y, value.z, value.w);
     }
 
-    void SetUniformInt(u32 id, std::string const& uniname, i32 value)
+    void SetUniformInt(u32 id, char const* uniname, i32 value)
     {
       glUniform1i(GetUniformLocation(id, uniname), int(value));
     }
 
-    void DrawEntities(camera3D const& camera)
+    void SetUniformFloat(u32 id, char const* uniname, f32 value)
     {
-      glm::mat4 const viewMatrix{camera.GetViewMatrix()};
+      glUniform1f(GetUniformLocation(id, uniname), value);
+    }
+
+    void BuildSnapshot(camera3D const& camera, render_snapshot& snapshot)
+    {
+      LAIN_PROFILE_ZONE("render_system::BuildSnapshot");
+
+      snapshot._view = camera.GetViewMatrix();
+      snapshot._viewProjection = _perspective * snapshot._view;
+      snapshot._cameraPosition = camera._position;
+
+      snapshot._models.resize(_entities.size());
+
+      for (u32 i{0}; i < _entities.size(); ++i) {
+	snapshot._models[i] = transform_system::GetTransform(i)._model;
+      }
+
+      BuildBounds(snapshot._models);
+
+      _cullStats = culling::CullBounds(culling::ExtractFrustum(snapshot._viewProjection), _bounds, _visible);
+
+      if (_occlusionCulling) {
+	CullOccludedMeshes(snapshot._viewProjection, snapshot._models);
+      }
+
+      SelectLods(snapshot);
+      BuildDrawCommands(snapshot);
+
+      snapshot._cullStats = _cullStats;
+    }
+
+    void DrawEntities(render_snapshot const& snapshot)
+    {
+      LAIN_PROFILE_ZONE("render_system::DrawEntities");
 
       UseShader(_meshWithTextureShader->_id);
-      SetUniformMat4(_meshWithTextureShader->_id, "view", viewMatrix);
+      SetUniformMat4(_meshWithTextureShader->_id, "view", snapshot._view);
 
       UseShader(_meshWithoutTextureShader->_id);
-      SetUniformMat4(_meshWithoutTextureShader->_id, "view", viewMatrix);
+      SetUniformMat4(_meshWithoutTextureShader->_id, "view", snapshot._view);
 
-      for (u32 i{0}; i < _entities.size(); ++i) {
-	auto const model = transform_system::GetTransform(i)._model;
+      gpu_timer::scoped_pass const pass{"Entities"};
 
-	UseShader(_meshWithTextureShader->_id);
-	SetUniformMat4(_meshWithTextureShader->_id, "model", model);
+      // Every draw of the frame in one go, the meshes then point into it.
+      gl_state::BindBuffer(GL_DRAW_INDIRECT_BUFFER, _indirectBuffer);
+      glBufferData(GL_DRAW_INDIRECT_BUFFER, snapshot._commands.size() * sizeof(draw_command), snapshot._commands.data(),
+		   GL_STREAM_DRAW);
 
-	UseShader(_meshWithoutTextureShader->_id);
-	SetUniformMat4(_meshWithoutTextureShader->_id, "model", model);
+      // Visible meshes come sorted by entity, so the model matrix only changes between entities.
+      u32 currentEntity{no_entity};
 
-	for (auto const& mesh : _entities[i]._data->_meshes) {
-	  if (!mesh._textures.empty()) {
-	    UseShader(_meshWithTextureShader->_id);
-	    DrawMeshWithTexture(mesh);
-	  } else {
-	    UseShader(_meshWithoutTextureShader->_id);
-	    DrawMeshWithNoTexture(mesh);
-	  }
+      for (mesh_ref const ref : snapshot._visible) {
+	// The editor may have removed entities after the snapshot was built.
+	if (ref._entity >= _entities.size() || ref._entity >= snapshot._models.size() ||
+	    ref._mesh >= _entities[ref._entity]._data->_meshes.size()) {
+	  continue;
+	}
+
+	if (ref._entity != currentEntity) {
+	  currentEntity = ref._entity;
+
+	  auto const& model = snapshot._models[currentEntity];
+
+	  UseShader(_meshWithTextureShader->_id);
+	  SetUniformMat4(_meshWithTextureShader->_id, "model", model);
+
+	  UseShader(_meshWithoutTextureShader->_id);
+	  SetUniformMat4(_meshWithoutTextureShader->_id, "model", model);
+	}
+
+	auto const& meshes = _entities[ref._entity]._data->_meshes;
+
+	// Also when every cluster was culled.
+	if (ref._mesh >= meshes.size() || ref._commandCount == 0) {
+	  continue;
+	}
+
+	mesh const* mesh{resource_manager::GetMesh(meshes[ref._mesh])};
+
+	if (mesh == nullptr) {
+	  continue;
+	}
+
+	// Streamed meshes can have replaced the placeholder since the draws were built (pipelined,
+	// they're built a frame ahead), the level is drawn whole then. Ranges can't tell: the
+	// placeholder's fit inside most meshes' level 0.
+	mesh_lod const& lod{mesh->_lods[std::min(ref._lod, mesh->_lodCount - 1)]};
+	bool const stale{meshes[ref._mesh] != ref._built};
+
+	if (!mesh->_textures.empty()) {
+	  UseShader(_meshWithTextureShader->_id);
+	  DrawMeshWithTexture(*mesh, ref, stale ? &lod : nullptr);
+	} else {
+	  UseShader(_meshWithoutTextureShader->_id);
+	  DrawMeshWithNoTexture(*mesh, ref, stale ? &lod : nullptr);
 	}
       }
+
+      _drawnCullStats = snapshot._cullStats;
+      _drawnClusterStats = snapshot._clusterStats;
+      _drawnLodStats = snapshot._lodStats;
     }
 
     void DrawLines(u32 id, u32 vao, u32 count, glm::mat4 const& view, glm::vec4 const& colour)
@@ -125,39 +239,58 @@ namespace lain
       SetUniformMat4(id, "model", glm::mat4(1.f));
       SetUniformVec4(id, "colour", colour);
 
-      glBindVertexArray(vao);
+      gl_state::BindVertexArray(vao);
       glDrawArrays(GL_LINES, 0, count);
     }
 
-    void DrawBoundingBox(u32 id, u32 vao, glm::mat4 const& view, glm::vec4 const& colour)
+    glm::mat4 GetCurrentProjectionMatrix()
     {
-      UseShader(id);
+      return _perspective;
+    }
 
-      SetUniformMat4(id, "projection", _perspective);
-      SetUniformMat4(id, "view", view);
-      SetUniformMat4(id, "model", glm::mat4{1.f});
-      SetUniformVec4(id, "colour", colour);
+    culling::cull_stats GetCullStats()
+    {
+      return _drawnCullStats;
+    }
 
-      glBindVertexArray(vao);
-      glDrawElements(GL_LINES, 24, GL_UNSIGNED_INT, 0);
+    void SetOcclusionCulling(bool enabled)
+    {
+      _occlusionCulling = enabled;
     }
 
-    void DrawBoundingBoxWithoutModel(u32 id, u32 vao, glm::mat4 const& view, glm::vec4 const& colour)
+    bool IsOcclusionCullingEnabled()
     {
-      UseShader(id);
+      return _occlusionCulling;
+    }
 
-      SetUniformMat4(id, "projection", _perspective);
-      SetUniformMat4(id, "view", view);
-      SetUniformMat4(id, "model", glm::mat4(1.f));
-      SetUniformVec4(id, "colour", colour);
+    lod_stats GetLodStats()
+    {
+      return _drawnLodStats;
+    }
 
-      glBindVertexArray(vao);
-      glDrawElements(GL_LINES, 24, GL_UNSIGNED_INT, 0);
+    void SetLod(bool enabled)
+    {
+      _lodEnabled = enabled;
     }
 
-    glm::mat4 GetCurrentProjectionMatrix()
+    bool IsLodEnabled()
     {
-      return _perspective;
+      return _lodEnabled;
+    }
+
+    culling::cull_stats GetClusterStats()
+    {
+      return _drawnClusterStats;
+    }
+
+    void SetClusterCulling(bool enabled)
+    {
+      _clusterCulling = enabled;
+    }
+
+    bool IsClusterCullingEnabled()
+    {
+      return _clusterCulling;
     }
 
     void AddEntity(render_component&& r)
@@ -180,49 +313,234 @@ namespace lain
       _entities.clear();
     }
 
-    static void DrawMeshWithTexture(mesh const& mesh)
+    static void BuildBounds(std::vector<glm::mat4> const& models)
+    {
+      LAIN_PROFILE_ZONE("render_system::BuildBounds");
+
+      culling::ClearBounds(_bounds);
+      _boundsOwners.clear();
+
+      for (u32 i{0}; i < _entities.size(); ++i) {
+	auto const& meshes = _entities[i]._data->_meshes;
+
+	for (u32 j{0}; j < meshes.size(); ++j) {
+	  culling::AddBounds(_bounds, TransformAABB(resource_manager::GetMesh(meshes[j])->_boundingBox, models[i]));
+	  _boundsOwners.push_back({i, j, 0, 0, 0, {}});
+	}
+      }
+
+      // Only goes wrong for a frame when entities are added or removed, the levels move along with them.
+      _lods.resize(_boundsOwners.size(), 0);
+    }
+
+    static void CullOccludedMeshes(glm::mat4 const& viewProjection, std::vector<glm::mat4> const& models)
+    {
+      LAIN_PROFILE_ZONE("render_system::CullOccludedMeshes");
+
+      occlusion::BeginFrame(viewProjection);
+
+      // Only occluders that survived the frustum test can hide anything.
+      for (u32 const index : _visible) {
+	mesh_ref const ref{_boundsOwners[index]};
+	model const* model{_entities[ref._entity]._data};
+
+	// Its real triangles, the bounds of a wall that turns a corner cover the corridor it turns into.
+	// Nothing until the positions are in (streaming placeholder), it just hides less for a frame.
+	if (model->_isOccluder) {
+	  mesh const* occluder{resource_manager::GetMesh(model->_meshes[ref._mesh])};
+	  collision_mesh::collision_mesh_view const triangles{collision_mesh::Get(occluder->_collision)};
+
+	  if (!triangles._indices.empty()) {
+	    occlusion::RasteriseTriangles(triangles._positions.data(), triangles._indices.data(),
+					  static_cast<u32>(triangles._indices.size()), models[ref._entity]);
+	  }
+	}
+      }
+
+      occlusion::BuildHiZ();
+
+      // Compact the visible list in place, occluders are always kept.
+      u32 kept{0};
+
+      for (u32 const index : _visible) {
+	mesh_ref const ref{_boundsOwners[index]};
+	bool const isOccluder{_entities[ref._entity]._data->_isOccluder};
+
+	glm::vec3 const min{_bounds._centreX[index] - _bounds._extentX[index],
+			    _bounds._centreY[index] - _bounds._extentY[index],
+			    _bounds._centreZ[index] - _bounds._extentZ[index]};
+
+	glm::vec3 const max{_bounds._centreX[index] + _bounds._extentX[index],
+			    _bounds._centreY[index] + _bounds._extentY[index],
+			    _bounds._centreZ[index] + _bounds._extentZ[index]};
+
+	if (isOccluder || occlusion::IsVisible(aabb{min, max})) {
+	  _visible[kept++] = index;
+	}
+      }
+
+      _cullStats._culled += static_cast<u32>(_visible.size()) - kept;
+      _cullStats._visible = kept;
+      _visible.resize(kept);
+    }
+
+    // Level of detail by how big its error shows on screen, from the closest point of the mesh's bounds.
+    static void SelectLods(render_snapshot& snapshot)
+    {
+      LAIN_PROFILE_ZONE("render_system::SelectLods");
+
+      snapshot._visible.clear();
+
+      for (u32 const index : _visible) {
+	mesh_ref ref{_boundsOwners[index]};
+	mesh const* mesh{resource_manager::GetMesh(_entities[ref._entity]._data->_meshes[ref._mesh])};
+
+	if (_lodEnabled) {
+	  glm::vec3 const centre{_bounds._centreX[index], _bounds._centreY[index], _bounds._centreZ[index]};
+	  glm::vec3 const extent{_bounds._extentX[index], _bounds._extentY[index], _bounds._extentZ[index]};
+	  f32 const distance{std::max(glm::length(centre - snapshot._cameraPosition) - glm::length(extent), kNearPlaneDistance)};
+
+	  // The model matrix's largest scale, errors are in the mesh's units.
+	  glm::mat4 const& model{snapshot._models[ref._entity]};
+	  f32 const scale{std::max({glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))})};
+
+	  _lods[index] = lod::Select(mesh->_lods, mesh->_lodCount, _pixelsPerUnit * scale / distance, _lods[index]);
+	} else {
+	  _lods[index] = 0;
+	}
+
+	ref._lod = _lods[index];
+	snapshot._visible.push_back(ref);
+      }
+    }
+
+    // Level 0 goes cluster by cluster, what survives the frustum and the back facing test is drawn
+    // with neighbouring clusters merged into one command. Other levels are drawn whole.
+    static void BuildDrawCommands(render_snapshot& snapshot)
+    {
+      LAIN_PROFILE_ZONE("render_system::BuildDrawCommands");
+
+      snapshot._commands.clear();
+      snapshot._clusterStats = {0, 0, 0};
+      snapshot._lodStats = {0, 0};
+
+      for (mesh_ref& ref : snapshot._visible) {
+	ref._built = _entities[ref._entity]._data->_meshes[ref._mesh];
+
+	mesh const* mesh{resource_manager::GetMesh(ref._built)};
+	mesh_lod const& lod{mesh->_lods[ref._lod]};
+
+	ref._firstCommand = static_cast<u32>(snapshot._commands.size());
+	ref._commandCount = 0;
+	snapshot._lodStats._fullDetailTriangles += mesh->_lods[0]._indexCount / 3;
+
+	if (ref._lod != 0 || !_clusterCulling || mesh->_clusters.empty()) {
+	  snapshot._commands.push_back({lod._indexCount, 1, lod._firstIndex, 0, 0});
+	  ref._commandCount = 1;
+	  snapshot._lodStats._triangles += lod._indexCount / 3;
+	  continue;
+	}
+
+	// In the mesh's space: six planes and the camera go there instead of every cluster coming out.
+	glm::mat4 const& model{snapshot._models[ref._entity]};
+	culling::frustum const frustum{culling::ExtractFrustum(snapshot._viewProjection * model)};
+	glm::vec3 const cameraPosition{glm::inverse(model) * glm::vec4(snapshot._cameraPosition, 1.f)};
+	culling::cull_stats const stats{
+	  cluster::Cull(frustum, cameraPosition, mesh->_clusters.data(), static_cast<u32>(mesh->_clusters.size()), _visibleClusters)};
+
+	snapshot._clusterStats._tested += stats._tested;
+	snapshot._clusterStats._visible += stats._visible;
+	snapshot._clusterStats._culled += stats._culled;
+
+	for (u32 const i : _visibleClusters) {
+	  mesh_cluster const& cluster{mesh->_clusters[i]};
+	  draw_command* const previous{ref._commandCount > 0 ? &snapshot._commands.back() : nullptr};
+
+	  if (previous != nullptr && previous->_firstIndex + previous->_count == cluster._firstIndex) {
+	    previous->_count += cluster._indexCount;
+	  } else {
+	    snapshot._commands.push_back({cluster._indexCount, 1, cluster._firstIndex, 0, 0});
+	    ++ref._commandCount;
+	  }
+
+	  snapshot._lodStats._triangles += cluster._indexCount / 3;
+	}
+      }
+    }
+
+    static void DrawMesh(mesh const& mesh, mesh_ref const& ref, mesh_lod const* stale)
+    {
+      gl_state::BindVertexArray(mesh._vao);
+
+      if (stale != nullptr) {
+	u32 const indexSize{mesh._indexType == GL_UNSIGNED_SHORT ? 2u : 4u};
+
+	glDrawElements(GL_TRIANGLES, stale->_indexCount, mesh._indexType,
+		       reinterpret_cast<void*>(static_cast<std::uintptr_t>(stale->_firstIndex) * indexSize));
+	return;
+      }
+
+      glMultiDrawElementsIndirect(GL_TRIANGLES, mesh._indexType,
+				  reinterpret_cast<void*>(static_cast<std::uintptr_t>(ref._firstCommand) * sizeof(draw_command)),
+				  ref._commandCount, sizeof(draw_command));
+    }
+
+    static void DrawMeshWithTexture(mesh const& mesh, mesh_ref const& ref, mesh_lod const* stale)
     {
       u32 diffuseIndex{1}, specularIndex{1};
-      std::string number;
-      std::string name;
+      char name[64];
 
       for (u32 i{0}; i < mesh._textures.size(); ++i) {
-	glActiveTexture(GL_TEXTURE0 + i);
-	name = mesh._textures[i]._type;
-
-	if (name == "textureDiffuse") {
-	  number = std::to_string(diffuseIndex++);
-	} else if (name == "textureSpecular") {
-	  number = std::to_string(specularIndex++);
+	gl_state::ActiveTexture(GL_TEXTURE0 + i);
+	std::string const& type{mesh._textures[i]._type};
+	u32 number{0};
+
+	if (type == "textureDiffuse") {
+	  number = diffuseIndex++;
+	} else if (type == "textureSpecular") {
+	  number = specularIndex++;
 	}
 
-	SetUniformInt(_meshWithTextureShader->_id, name + number, i);
-	glBindTexture(GL_TEXTURE_2D, mesh._textures[i]._id);
+	// A stack buffer, this runs for every textured mesh every frame.
+	std::snprintf(name, sizeof(name), number > 0 ? "%s%u" : "%s", type.c_str(), number);
+
+	SetUniformInt(_meshWithTextureShader->_id, name, i);
+	gl_state::BindTexture(GL_TEXTURE_2D, mesh._textures[i]._id);
       }
 
-      glBindVertexArray(mesh._vao);
-      glDrawElements(GL_TRIANGLES, mesh._indices.size(), GL_UNSIGNED_INT, 0);
+      SetUniformVec3(_meshWithTextureShader->_id, "positionOffset", mesh._positionOffset);
+      SetUniformVec3(_meshWithTextureShader->_id, "positionScale", mesh._positionScale);
+      DrawMesh(mesh, ref, stale);
     }
 
-    static void DrawMeshWithNoTexture(mesh const& mesh)
+    static void DrawMeshWithNoTexture(mesh const& mesh, mesh_ref const& ref, mesh_lod const* stale)
     {
       SetUniformVec3(_meshWithoutTextureShader->_id, "diffuseColour", mesh._diffuseColour);
-      glBindVertexArray(mesh._vao);
-      glDrawElements(GL_TRIANGLES, mesh._indices.size(), GL_UNSIGNED_INT, 0);
+      SetUniformVec3(_meshWithoutTextureShader->_id, "positionOffset", mesh._positionOffset);
+      SetUniformVec3(_meshWithoutTextureShader->_id, "positionScale", mesh._positionScale);
+      DrawMesh(mesh, ref, stale);
     }
 
-    static u32 GetUniformLocation(u32 id, std::string const& uniname)
+    static u32 GetUniformLocation(u32 id, char const* uniname)
     {
-      const auto key = std::make_pair(id, uniname);
+      u32 const hash{static_cast<u32>(fnv1a(uniname, static_cast<u32>(std::strlen(uniname))))};
+      u64 const key{static_cast<u64>(id) << 32 | hash};
       const auto it = _uniforms.find(key);
 
       if (it == _uniforms.end()) {
-	auto const location = glGetUniformLocation(id, uniname.c_str());
-	_uniforms[key] = location;
+	auto const location = glGetUniformLocation(id, uniname);
+	_uniforms.emplace(key, cached_uniform{static_cast<u32>(location), uniname});
 	return location;
       }
 
-      return it->second;
+      // Not the one that's cached, rename one of them. Still right, just not cached.
+      if (it->second._name != uniname) {
+	std::cerr << __FUNCTION__ << ": uniforms " << it->second._name << " and " << uniname << " have the same hash\n";
+	assert(false && "uniform name hash collision");
+	return glGetUniformLocation(id, uniname);
+      }
+
+      return it->second._location;
     }
   };
 };
@@ -5,42 +5,145 @@
 #include "assimp/postprocess.h"
 #include "assimp/scene.h"
 #include "assimp/types.h"
+#include "l_allocation_tracker.h"
+#include "l_asset_pack.h"
+#include "l_cluster.h"
 #include "l_common.h"
 #include "l_entity_system.h"
+#include "glm/geometric.hpp"
+#include "l_gl_state.h"
+#include "l_lod.h"
 #include "l_math.h"
+#include "l_mesh_cache.h"
+#include "l_mesh_optimiser.h"
 #include "l_model.h"
+#include "l_model_registry.h"
+#include "l_pool.h"
+#include "l_profiler.h"
 #include "l_shader.h"
+#include "l_shader_cache.h"
 #include "l_texture.h"
+#include "l_texture_cache.h"
+#include "l_thread_pool.h"
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cfloat>
-#include <fstream>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
 #include <iostream>
-#include <memory>
+#include <mutex>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+// S3TC isn't core and glad was generated without the extension, every desktop driver has it though.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
 namespace lain
 {
   namespace resource_manager {
-    std::unordered_map<i32, std::unique_ptr<shader>> _shaders;
-    std::unordered_map<i32, std::unique_ptr<texture>> _textures;
-    std::unordered_map<model_type, std::unique_ptr<model>> _models;
-    std::unordered_map<entity_id, model_type> _entityModelRelationship;
-    std::unordered_map<std::string, mesh_texture> _meshTexturesCache;
+    static u32 constexpr kMaxShaders{32};
+    static u32 constexpr kMaxTextures{256};
+    static u32 constexpr kMaxMeshes{4096};
+
+    static pool<shader, kMaxShaders> _shaders;
+    static pool<texture, kMaxTextures> _textures;
+    static pool<model, model_registry::kMaxModels> _models;
+    static pool<mesh, kMaxMeshes> _meshes;
+
+    // Ids are only looked up when something asks for a handle, never per frame.
+    std::unordered_map<i32, shader_handle> _shaderHandles;
+    std::unordered_map<i32, texture_handle> _textureHandles;
+    std::unordered_map<entity_id, model_id> _entityModelRelationship;
+    static std::vector<model_handle> _modelHandles; // by model_registry index, empty ones not created yet
+    std::unordered_map<std::string, mesh_texture> _meshTexturesCache; // by normalised path
+
+    // ---------------------------------------------------------------------------------------------
+    // Loading: parsing models and decoding images runs on the thread pool, whatever touches GL is
+    // queued up for the main thread, which runs it in `PumpUploads`. The pools are main thread only.
+    // ---------------------------------------------------------------------------------------------
+    static std::mutex _loadMutex;
+    static std::condition_variable _loadCondition;
+    static std::deque<std::function<void()>> _uploads;
+    static std::unordered_set<std::string> _requestedTextures;
+    static u32 _loadJobs; // submitted and not finished yet
+    static std::atomic<u32> _loadDone;
+    static std::atomic<u32> _loadTotal;
+
+    // Streaming: models waiting for a worker, the closest to the viewer go first. Main thread only.
+    struct stream_request final
+    {
+      model_id _id;
+      model_handle _handle;
+      glm::vec3 _position;
+    };
+
+    static std::vector<stream_request> _streamRequests;
+    static bool _streaming;
+    static mesh_handle _placeholderMesh;
+    static u32 _placeholderTexture;
+
+    // Set before any texture is loaded, workers only read them.
+    static texture_cache::compression _textureCompression{texture_cache::compression::bc};
+    static bool _hasS3TC;
+    static vertex_format _vertexFormat{vertex_format::packed};
 
     static bool ShaderHasCompilationErrors(u32 program, shader_type type);
     static u32 CompileAndLinkShaders(std::filesystem::path const& vertex, std::filesystem::path const& fragment);
-    static std::vector<mesh_texture> LoadMaterialTextures(aiMaterial* material, aiTextureType type, std::string const& typeName, model* model);
-    static mesh ProcessMesh(aiMesh* aiMesh, aiScene const* scene, model* model);
-    static void ProcessNode(aiNode* node, aiScene const* scene, model* model);
-    static std::filesystem::path GetPathFromModelType(model_type type);
-    static void LoadModels();
-
-    void Initialise()
+    static u32 CompileAndLink(std::string_view vertcode, std::string_view fragcode);
+    static unsigned char* DecodeImage(std::filesystem::path const& file, bool flip, i32* width, i32* height, i32* channels);
+    static texture_cache::texture_format GetTextureFormat(i32 channels);
+    static bool LoadBakedTexture(std::filesystem::path const& file, bool flip, texture_cache::baked_texture& baked);
+    static bool HasExtension(char const* name);
+    static std::vector<mesh_texture> LoadMaterialTextures(aiMaterial* material, aiTextureType type, std::string const& typeName);
+    static mesh_data ProcessMesh(aiMesh* aiMesh, aiScene const* scene);
+    static void ProcessNode(aiNode* node, aiScene const* scene, std::vector<mesh_data>& meshes);
+    static std::vector<mesh_data> ParseModel(std::filesystem::path const& path, bool& cached);
+    static void RegisterModels();
+    static model_handle CreateModel(u32 index);
+    static void SubmitModel(model_handle handle, std::filesystem::path const& path);
+    static void RequestModel(model_id id);
+    static mesh_data MakePlaceholderMesh();
+    static void RequestTexture(std::string const& path);
+    static void ResolveMeshTextures();
+    static void SubmitLoadJob(std::function<void()> job);
+    static void QueueUpload(std::function<void()> upload);
+    static void PumpUploads(progress_callback onProgress);
+    static u32 UploadTexture(texture_cache::baked_texture const& baked, i32 wrapS, i32 wrapT);
+
+    void Initialise(progress_callback onProgress)
     {
+      LAIN_PROFILE_ZONE("resource_manager::Initialise");
+
+      u64 const start{profiler::Now()};
+
+      // What streamed models and textures show until their data is in.
+      _placeholderMesh = _meshes.Create(MakePlaceholderMesh(), _vertexFormat);
+
+      _hasS3TC = HasExtension("GL_EXT_texture_compression_s3tc");
+
+      u32 const checker[] = {0xffff00ff, 0xff808080, 0xff808080, 0xffff00ff}; // RGBA8, magenta and grey
+      texture_cache::baked_texture placeholder;
+
+      texture_cache::Bake(reinterpret_cast<u8 const*>(checker), 2, 2, 4, texture_cache::texture_format::rgba8, 0, placeholder);
+      _placeholderTexture = UploadTexture(placeholder, GL_REPEAT, GL_REPEAT);
+
+      //
+      // Only find out which models there are here, there can be thousands. They're loaded when a
+      // level or the editor places one (`LoadModel`, or `StreamModel` when streaming).
+      //
+      RegisterModels();
+
       // ---------------------------------------------------------------------------------------------
       // shaders
       // ---------------------------------------------------------------------------------------------
@@ -49,28 +152,167 @@ namespace lain
 
       assert(id != 0 && "couldn't create shader for models with textures in object editor");
 
-      _shaders[kLevelEditorModelWithTextureShaderId] = std::make_unique<shader>(id);
+      _shaderHandles[kLevelEditorModelWithTextureShaderId] = _shaders.Create(id);
 
       id = CompileAndLinkShaders("./res/shaders/LevelEditor_ModelWithoutTextures.vert",
 				 "./res/shaders/LevelEditor_ModelWithoutTextures.frag");
 
       assert(id != 0 && "couldn't create shader for models without textures in object editor");
 
-      _shaders[kLevelEditorModelWithoutTextureShaderId] = std::make_unique<shader>(id);
+      _shaderHandles[kLevelEditorModelWithoutTextureShaderId] = _shaders.Create(id);
 
       id = CompileAndLinkShaders("./res/shaders/Primitive.vert", "./res/shaders/Primitive.frag");
 
       assert(id != 0 && "couldn't create primitive shader");
 
-      _shaders[kPrimitiveShaderId] = std::make_unique<shader>(id);
+      _shaderHandles[kPrimitiveShaderId] = _shaders.Create(id);
 
-      //
-      // Load every model here, don't lazy load them. Reasons:
-      //
-      // 1) Try to do allocations always at startup and minimise doing them while the game is running.
-      // 2) To load levels from files, it's very useful to have models already loaded.
-      //
-      LoadModels();
+      id = CompileAndLinkShaders("./res/shaders/LevelEditor_Grid.vert",
+				 "./res/shaders/LevelEditor_Grid.frag");
+
+      assert(id != 0 && "couldn't create grid shader for the level editor");
+
+      _shaderHandles[kLevelEditorGridShaderId] = _shaders.Create(id);
+
+      id = CompileAndLinkShaders("./res/shaders/DebugLines.vert", "./res/shaders/DebugLines.frag");
+
+      assert(id != 0 && "couldn't create debug lines shader");
+
+      _shaderHandles[kDebugLinesShaderId] = _shaders.Create(id);
+
+      PumpUploads(onProgress);
+      ResolveMeshTextures();
+
+      std::cout << __FUNCTION__ << ": " << _models.GetCount() << " models, " << _meshTexturesCache.size()
+		<< " textures in " << (profiler::Now() - start) / 1e6 << " ms on "
+		<< thread_pool::GetThreadCount() << " threads\n";
+    }
+
+    loading_progress GetLoadingProgress()
+    {
+      return {_loadDone.load(), _loadTotal.load()};
+    }
+
+    void SetStreaming(bool streaming)
+    {
+      _streaming = streaming;
+    }
+
+    bool IsStreaming()
+    {
+      return _streaming;
+    }
+
+    void SetTextureCompression(texture_cache::compression compression)
+    {
+      _textureCompression = compression;
+    }
+
+    void SetVertexFormat(vertex_format format)
+    {
+      _vertexFormat = format;
+    }
+
+    model_handle StreamModel(model_id const id, glm::vec3 const& position)
+    {
+      u32 const index{model_registry::GetIndex(id)};
+
+      if (index == model_registry::kNotFound) {
+	std::cerr << __FUNCTION__ << ": no model with id " << id << '\n';
+	assert(false && "unknown model");
+	return {};
+      }
+
+      if (_modelHandles[index].IsValid()) {
+	return _modelHandles[index];
+      }
+
+      model_handle const handle{CreateModel(index)};
+
+      if (!handle.IsValid()) {
+	return handle;
+      }
+
+      _models.Get(handle)->_meshes.push_back(_placeholderMesh);
+      _streamRequests.push_back({id, handle, position});
+
+      return handle;
+    }
+
+    bool IsModelResident(model_id const id)
+    {
+      u32 const index{model_registry::GetIndex(id)};
+
+      if (index == model_registry::kNotFound) {
+	return false;
+      }
+
+      model const* data{_models.Get(_modelHandles[index])};
+
+      return data != nullptr && data->_isResident;
+    }
+
+    void UpdateStreaming(glm::vec3 const& viewer, f32 const budgetMs)
+    {
+      LAIN_PROFILE_ZONE("resource_manager::UpdateStreaming");
+      allocation_tracker::scoped_tag const tag{allocation_tracker::tag::resources};
+
+      // Only hand out as many requests as there are workers, so a closer one can still jump the queue later.
+      if (!_streamRequests.empty()) {
+	auto const distance = [&viewer](stream_request const& request) {
+	  glm::vec3 const d{request._position - viewer};
+	  return glm::dot(d, d);
+	};
+
+	// Farthest first, they're taken from the back.
+	std::sort(_streamRequests.begin(), _streamRequests.end(),
+		  [&distance](stream_request const& a, stream_request const& b) { return distance(a) > distance(b); });
+
+	u32 inFlight;
+
+	{
+	  std::lock_guard const lock{_loadMutex};
+	  inFlight = _loadJobs;
+	}
+
+	while (!_streamRequests.empty() && inFlight < thread_pool::GetThreadCount()) {
+	  SubmitModel(_streamRequests.back()._handle, model_registry::Find(_streamRequests.back()._id)->_path);
+	  _streamRequests.pop_back();
+	  ++inFlight;
+	}
+      }
+
+      // At least one upload per frame, an upload bigger than the budget would stall streaming otherwise.
+      u64 const deadline{profiler::Now() + static_cast<u64>(budgetMs * 1e6f)};
+      bool uploaded{false};
+
+      while (true) {
+	std::function<void()> upload;
+
+	{
+	  std::lock_guard const lock{_loadMutex};
+
+	  if (_uploads.empty()) {
+	    break;
+	  }
+
+	  upload = std::move(_uploads.front());
+	  _uploads.pop_front();
+	}
+
+	upload();
+
+	++_loadDone;
+	uploaded = true;
+
+	if (profiler::Now() >= deadline) {
+	  break;
+	}
+      }
+
+      if (uploaded) {
+	ResolveMeshTextures();
+      }
     }
 
     bool LoadTextureFromFile(std::filesystem::path const& file,
@@ -79,107 +321,68 @@ namespace lain
 			     i32 const wrapT,
 			     i32 const id)
     {
-      i32 width, height, channels;
+      LAIN_PROFILE_ZONE("resource_manager::LoadTextureFromFile");
+      allocation_tracker::scoped_tag const tag{allocation_tracker::tag::resources};
 
-      if (flip) {
-	stbi_set_flip_vertically_on_load(true);
-      }
-
-      unsigned char* data{stbi_load(file.c_str(), &width, &height, &channels, 0)};
+      texture_cache::baked_texture baked;
 
-      if (data == nullptr) {
+      if (!LoadBakedTexture(file, flip, baked)) {
 	std::cerr << __FUNCTION__ << ": couldn't load image " << file << '\n';
 	return false;
       }
 
-      GLenum format;
+      u32 const glTexId{UploadTexture(baked, wrapS, wrapT)};
 
-      switch (channels) {
-      case 1:
-	format = GL_RED;
-	break;
-      case 2:
-	format = GL_RG;
-	break;
-      case 3:
-	format = GL_RGB;
-	break;
-      case 4:
-	format = GL_RGBA;
-	break;
+      auto it = _textureHandles.find(id);
+
+      if (it != _textureHandles.end()) {
+	texture const* old{_textures.Get(it->second)};
+
+	// Reloaded, the slot goes but the GL texture has to go with it.
+	if (old != nullptr) {
+	  glDeleteTextures(1, &old->_id);
+	  gl_state::ForgetTexture(old->_id);
+	}
+
+	_textures.Destroy(it->second);
+	_textureHandles.erase(it);
       }
 
-      // don't assume dimensions are multiple of 4
-      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-      u32 glTexId;
-      glGenTextures(1, &glTexId);
-      glBindTexture(GL_TEXTURE_2D, glTexId);
-      glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-      glGenerateMipmap(GL_TEXTURE_2D);
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapS);
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapT);
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-      glBindTexture(GL_TEXTURE_2D, 0);
+      texture_handle const handle{_textures.Create(glTexId, static_cast<i32>(baked._width), static_cast<i32>(baked._height),
+						   baked._channels)};
 
-      stbi_image_free(data);
+      texture_cache::Release(baked);
 
-      if (flip) {
-	stbi_set_flip_vertically_on_load(false);
+      if (!handle.IsValid()) {
+	glDeleteTextures(1, &glTexId);
+	gl_state::ForgetTexture(glTexId);
+	return false;
       }
 
-      _textures[id] = std::make_unique<texture>(glTexId, width, height, channels);
+      _textureHandles[id] = handle;
 
       return true;
     }
 
     u32 LoadTextureFromFile(std::filesystem::path const& file)
     {
-      i32 width, height, channels;
+      texture_cache::baked_texture baked;
 
-      unsigned char* data{stbi_load(file.c_str(), &width, &height, &channels, 0)};
-
-      if (data == nullptr) {
+      if (!LoadBakedTexture(file, false, baked)) {
 	std::cerr << __FUNCTION__ << ": couldn't load image " << file << '\n';
 	return 0;
       }
 
-      GLenum format;
+      u32 const glTexId{UploadTexture(baked, GL_REPEAT, GL_REPEAT)};
 
-      switch (channels) {
-      case 1:
-	format = GL_RED;
-	break;
-      case 2:
-	format = GL_RG;
-	break;
-      case 3:
-	format = GL_RGB;
-	break;
-      case 4:
-	format = GL_RGBA;
-	break;
-      }
-
-      // don't assume dimensions are multiple of 4
-      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-      u32 glTexId;
-      glGenTextures(1, &glTexId);
-      glBindTexture(GL_TEXTURE_2D, glTexId);
-      glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-      glGenerateMipmap(GL_TEXTURE_2D);
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-      glBindTexture(GL_TEXTURE_2D, 0);
-
-      stbi_image_free(data);
+      texture_cache::Release(baked);
 
       return glTexId;
     }
 
-    void AddEntityModelRelationship(entity_id const id, model_type const type)
+    void AddEntityModelRelationship(entity_id const id, model_id const model)
     {
-      _entityModelRelationship[id] = type;
+      _entityModelRelationship[id] = model;
     }
 
     void RemoveEntityModelRelationship(entity_id const id)
@@ -190,17 +393,46 @@ namespace lain
 
     model const* GetModelDataFromEntity(entity_id const id)
     {
-      return _models.at(_entityModelRelationship.at(id)).get();
+      return _models.Get(_modelHandles[model_registry::GetIndex(_entityModelRelationship.at(id))]);
+    }
+
+    shader_handle GetShaderHandle(i32 const id)
+    {
+      auto it = _shaderHandles.find(id);
+
+      return it != _shaderHandles.end() ? it->second : shader_handle{};
+    }
+
+    texture_handle GetTextureHandle(i32 const id)
+    {
+      auto it = _textureHandles.find(id);
+
+      return it != _textureHandles.end() ? it->second : texture_handle{};
+    }
+
+    shader const* GetShader(shader_handle const handle)
+    {
+      return _shaders.Get(handle);
+    }
+
+    texture const* GetTexture(texture_handle const handle)
+    {
+      return _textures.Get(handle);
+    }
+
+    mesh const* GetMesh(mesh_handle const handle)
+    {
+      return _meshes.Get(handle);
     }
 
     shader const* GetShader(i32 const id)
     {
-      return _shaders.at(id).get();
+      return _shaders.Get(_shaderHandles.at(id));
     }
 
     texture const* GetTexture(i32 const id)
     {
-      return _textures.at(id).get();
+      return _textures.Get(_textureHandles.at(id));
     }
 
     shader CreatePrimitiveVAO(std::vector<f32> const& vertices, GLenum const usage)
@@ -210,9 +442,9 @@ namespace lain
       glGenVertexArrays(1, &vao);
       glGenBuffers(1, &vbo);
 
-      glBindVertexArray(vao);
+      gl_state::BindVertexArray(vao);
 
-      glBindBuffer(GL_ARRAY_BUFFER, vbo);
+      gl_state::BindBuffer(GL_ARRAY_BUFFER, vbo);
       glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(f32), vertices.data(), usage);
 
       glEnableVertexAttribArray(0);
@@ -231,12 +463,12 @@ namespace lain
       glGenBuffers(1, &vbo);
       glGenBuffers(1, &ebo);
 
-      glBindVertexArray(vao);
+      gl_state::BindVertexArray(vao);
 
-      glBindBuffer(GL_ARRAY_BUFFER, vbo);
+      gl_state::BindBuffer(GL_ARRAY_BUFFER, vbo);
       glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(f32), vertices.data(), usage);
 
-      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+      gl_state::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
       glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(u32), indices.data(), usage);
 
       glEnableVertexAttribArray(0);
@@ -245,35 +477,45 @@ namespace lain
       return shader(0, vao, vbo, ebo);
     }
 
-    void LoadModel(model_type const type)
+    void LoadModel(model_id const id)
     {
-      if (_models.find(type) != _models.end()) {
+      LAIN_PROFILE_ZONE("resource_manager::LoadModel");
+
+      model_info const* info{model_registry::Find(id)};
+
+      if (info == nullptr) {
+	std::cerr << __FUNCTION__ << ": no model with id " << id << '\n';
+	assert(false && "unknown model");
 	return;
       }
 
-      auto newModel = std::make_unique<model>();
-
-      std::filesystem::path path{GetPathFromModelType(type)};
+      RequestModel(id);
 
-      Assimp::Importer importer;
+      model const* data{_models.Get(_modelHandles[model_registry::GetIndex(id)])};
 
-      aiScene const* scene{importer.ReadFile(path.c_str(), aiProcess_Triangulate | aiProcess_FlipUVs)};
-
-      if (scene == nullptr || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || scene->mRootNode == nullptr) {
-	std::cerr << __FUNCTION__ << ": couldn't load model: " << importer.GetErrorString() << '\n';
-	assert(false && "couldn't load model");
+      // The pool was full, already reported.
+      if (data == nullptr || data->_isResident) {
+	return;
       }
 
-      newModel->_directory = path.parent_path();
+      // Still waiting to be streamed in, skip the queue.
+      auto it = std::find_if(_streamRequests.begin(), _streamRequests.end(),
+			     [id](stream_request const& request) { return request._id == id; });
 
-      ProcessNode(scene->mRootNode, scene, newModel.get());
+      if (it != _streamRequests.end()) {
+	SubmitModel(it->_handle, info->_path);
+	_streamRequests.erase(it);
+      }
 
-      _models[type] = std::move(newModel);
+      PumpUploads(nullptr);
+      ResolveMeshTextures();
     }
 
-    model_type GetModelType(entity_id const id)
+    model_id GetModelId(entity_id const id)
     {
-      return _entityModelRelationship[id];
+      auto it = _entityModelRelationship.find(id);
+
+      return it != _entityModelRelationship.end() ? it->second : kNoModel;
     }
 
     static bool ShaderHasCompilationErrors(u32 program, shader_type type)
@@ -313,32 +555,57 @@ namespace lain
 
     static u32 CompileAndLinkShaders(std::filesystem::path const& vertex, std::filesystem::path const& fragment)
     {
-      std::ifstream vertfs(vertex);
-      std::ifstream fragfs(fragment);
+      u64 const start{profiler::Now()};
+
+      mapped_file vertfile, fragfile;
 
-      if (!vertfs) {
+      if (!asset_pack::Open(vertex, vertfile)) {
 	std::cerr << __FUNCTION__ << ": couldn't open vertex file: " << vertex << '\n';
-	return false;
+	return 0;
       }
 
-      if (!fragfs) {
+      if (!asset_pack::Open(fragment, fragfile)) {
 	std::cerr << __FUNCTION__ << ": couldn't open fragment file: " << fragment << '\n';
-	return false;
+	asset_pack::Close(vertfile);
+	return 0;
       }
 
-      std::stringstream vertss;
-      std::stringstream fragss;
-      vertss << vertfs.rdbuf();
-      fragss << fragfs.rdbuf();
+      // Straight out of the mapping, no copies.
+      std::string_view const vertcode{reinterpret_cast<char const*>(vertfile._data), vertfile._size};
+      std::string_view const fragcode{reinterpret_cast<char const*>(fragfile._data), fragfile._size};
 
-      std::string const vertcode{vertss.str()};
-      std::string const fragcode{fragss.str()};
+      u64 const hash{shader_cache::Hash(vertcode, fragcode)};
+      u32 shaderProgram{shader_cache::Load(hash)};
+      bool const cached{shaderProgram != 0};
 
-      char const* vertcodec{vertcode.c_str()};
-      char const* fragcodec{fragcode.c_str()};
+      if (!cached) {
+	shaderProgram = CompileAndLink(vertcode, fragcode);
+
+	if (shaderProgram != 0) {
+	  shader_cache::Save(shaderProgram, hash);
+	}
+      }
+
+      asset_pack::Close(vertfile);
+      asset_pack::Close(fragfile);
+
+      if (shaderProgram != 0) {
+	std::cout << __FUNCTION__ << ": " << vertex.filename() << " + " << fragment.filename()
+		  << (cached ? " from cache in " : " compiled in ") << (profiler::Now() - start) / 1e6 << " ms\n";
+      }
+
+      return shaderProgram;
+    }
+
+    static u32 CompileAndLink(std::string_view vertcode, std::string_view fragcode)
+    {
+      char const* vertcodec{vertcode.data()};
+      char const* fragcodec{fragcode.data()};
+      i32 const vertlength{static_cast<i32>(vertcode.size())};
+      i32 const fraglength{static_cast<i32>(fragcode.size())};
 
       u32 vertexShaderId{glCreateShader(GL_VERTEX_SHADER)};
-      glShaderSource(vertexShaderId, 1, &vertcodec, nullptr);
+      glShaderSource(vertexShaderId, 1, &vertcodec, &vertlength);
       glCompileShader(vertexShaderId);
       if (ShaderHasCompilationErrors(vertexShaderId, shader_type::vertex)) {
 	glDeleteShader(vertexShaderId);
@@ -346,7 +613,7 @@ namespace lain
       }
 
       u32 fragmentShaderId{glCreateShader(GL_FRAGMENT_SHADER)};
-      glShaderSource(fragmentShaderId, 1, &fragcodec, nullptr);
+      glShaderSource(fragmentShaderId, 1, &fragcodec, &fraglength);
       glCompileShader(fragmentShaderId);
       if (ShaderHasCompilationErrors(fragmentShaderId, shader_type::fragment)) {
 	glDeleteShader(vertexShaderId);
@@ -357,6 +624,7 @@ namespace lain
       u32 shaderProgram{glCreateProgram()};
       glAttachShader(shaderProgram, vertexShaderId);
       glAttachShader(shaderProgram, fragmentShaderId);
+      glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
       glLinkProgram(shaderProgram);
       if (ShaderHasCompilationErrors(shaderProgram, shader_type::program)) {
 	glDeleteShader(vertexShaderId);
@@ -372,43 +640,22 @@ namespace lain
 
     static std::vector<mesh_texture> LoadMaterialTextures(aiMaterial* material,
 							  aiTextureType type,
-							  std::string const& typeName,
-							  model* model)
+							  std::string const& typeName)
     {
       std::vector<mesh_texture> textures;
 
+      // Only the names, `RequestTexture` loads them once the mesh is out of the importer (or the cache).
       for (u32 i{0}; i < material->GetTextureCount(type); ++i) {
 	aiString str;
 	material->GetTexture(type, i, &str);
 
-	auto it = _meshTexturesCache.find(str.C_Str());
-
-	if (it != _meshTexturesCache.end()) {
-	  textures.push_back(it->second);
-	  continue;
-	}
-
-	std::filesystem::path filepath{model->_directory};
-	filepath /= str.C_Str();
-
-	u32 const textureId{resource_manager::LoadTextureFromFile(filepath)};
-
-	if (textureId == 0) {
-	  std::cerr << __FUNCTION__ << ": couldn't load texture from file " << filepath << '\n';
-	  continue;
-	}
-
-	mesh_texture const newTexture{textureId, typeName, str.C_Str()};
-
-	_meshTexturesCache[str.C_Str()] = newTexture;
-
-	textures.push_back(newTexture);
+	textures.push_back(mesh_texture{0, typeName, str.C_Str()});
       }
 
       return textures;
     }
 
-    static mesh ProcessMesh(aiMesh* aiMesh, aiScene const* scene, model* model)
+    static mesh_data ProcessMesh(aiMesh* aiMesh, aiScene const* scene)
     {
       aabb aabb{glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX)};
       std::vector<vertex_data> vertices;
@@ -460,47 +707,499 @@ namespace lain
       // TODO: add specular as well
       glm::vec3 diffuseColour{aiColour.r, aiColour.g, aiColour.b};
 
-      std::vector<mesh_texture> diffuseMaps{LoadMaterialTextures(material, aiTextureType_DIFFUSE, "textureDiffuse", model)};
+      std::vector<mesh_texture> diffuseMaps{LoadMaterialTextures(material, aiTextureType_DIFFUSE, "textureDiffuse")};
 
       textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
 
-      std::vector<mesh_texture> specularMaps{LoadMaterialTextures(material, aiTextureType_SPECULAR, "textureSpecular", model)};
+      std::vector<mesh_texture> specularMaps{LoadMaterialTextures(material, aiTextureType_SPECULAR, "textureSpecular")};
 
       textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
 
-      return mesh{std::move(vertices), std::move(indices), std::move(textures), diffuseColour, std::move(aabb)};
+      return mesh_data{std::move(vertices), std::move(indices), std::move(textures), aabb, diffuseColour, {}, {}};
     }
 
-    static void ProcessNode(aiNode* node, aiScene const* scene, model* model)
+    static void ProcessNode(aiNode* node, aiScene const* scene, std::vector<mesh_data>& meshes)
     {
       for (u32 i{0}; i < node->mNumMeshes; ++i) {
-	model->_meshes.emplace_back(ProcessMesh(scene->mMeshes[node->mMeshes[i]], scene, model));
+	meshes.push_back(ProcessMesh(scene->mMeshes[node->mMeshes[i]], scene));
       }
 
       for (u32 i{0}; i < node->mNumChildren; ++i) {
-	ProcessNode(node->mChildren[i], scene, model);
+	ProcessNode(node->mChildren[i], scene, meshes);
       }
     }
 
-    static std::filesystem::path GetPathFromModelType(model_type type)
+    // Whatever model_registry finds, see res/models/models.manifest for the flags.
+    static void RegisterModels()
     {
-      switch (type) {
-      case model_type::ball:
-	return std::filesystem::path("./res/models/ball.obj");
-      case model_type::maze:
-	return std::filesystem::path("./res/models/maze.obj");
+      model_registry::Clear();
+
+      if (!model_registry::Load("./res/models")) {
+	std::cerr << __FUNCTION__ << ": some models couldn't be registered\n";
+      }
+
+      _modelHandles.assign(model_registry::GetCount(), model_handle{});
+    }
+
+    static std::vector<mesh_data> ParseModel(std::filesystem::path const& path, bool& cached)
+    {
+      std::filesystem::path const cachePath{mesh_cache::GetCachePath(path)};
+      u64 const sourceHash{mesh_cache::HashSource(path)};
+
+      std::vector<mesh_data> meshes;
+
+      cached = mesh_cache::Read(cachePath, sourceHash, meshes);
+
+      if (cached) {
+	return meshes;
+      }
+
+      Assimp::Importer importer;
+
+      aiScene const* scene{importer.ReadFile(path.c_str(), aiProcess_Triangulate | aiProcess_FlipUVs)};
+
+      if (scene == nullptr || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || scene->mRootNode == nullptr) {
+	std::cerr << __FUNCTION__ << ": couldn't load model: " << importer.GetErrorString() << '\n';
+	assert(false && "couldn't load model");
+	return meshes;
+      }
+
+      ProcessNode(scene->mRootNode, scene, meshes);
+
+      // Only ever on import, what's baked is already optimised.
+      u64 verticesBefore{0}, verticesAfter{0};
+      f32 transformedBefore{0.f}, transformedAfter{0.f};
+      u64 triangles{0};
+      u64 clusters{0};
+      u64 lodTriangles[kMaxLods]{};
+
+      for (auto& mesh : meshes) {
+	u32 const vertexCount{static_cast<u32>(mesh._vertices.size())};
+	u32 const triangleCount{static_cast<u32>(mesh._indices.size() / 3)};
+
+	verticesBefore += vertexCount;
+	transformedBefore += mesh_optimiser::AnalyseVertexCache(mesh._indices, vertexCount)._acmr * triangleCount;
+
+	// Clusters are built on welded vertices in vertex cache order, which keeps them compact, then
+	// each one is ordered for the cache and overdraw in place and the vertices follow.
+	mesh_optimiser::WeldVertices(mesh);
+	mesh_optimiser::OptimiseVertexCache(mesh._indices, static_cast<u32>(mesh._vertices.size()));
+	cluster::Build(mesh);
+	mesh_optimiser::Optimise(mesh);
+
+	verticesAfter += mesh._vertices.size();
+	transformedAfter += mesh_optimiser::AnalyseVertexCache(mesh._indices, static_cast<u32>(mesh._vertices.size()))._acmr *
+	  triangleCount;
+	triangles += triangleCount;
+	clusters += mesh._clusters.size();
+
+	lod::Generate(mesh);
+
+	for (u32 i{1}; i < mesh._lods.size(); ++i) {
+	  lodTriangles[i] += mesh._lods[i]._indexCount / 3;
+	}
+      }
+
+      if (triangles > 0) {
+	std::cout << __FUNCTION__ << ": " << path.filename() << " " << verticesBefore << " -> " << verticesAfter
+		  << " vertices, ACMR " << transformedBefore / triangles << " -> " << transformedAfter / triangles
+		  << ", ATVR " << transformedBefore / verticesBefore << " -> " << transformedAfter / verticesAfter
+		  << ", LOD triangles " << triangles;
+
+	// Meshes stop at different levels, these only count the ones that got that far.
+	for (u32 i{1}; i < kMaxLods && lodTriangles[i] > 0; ++i) {
+	  std::cout << " / " << lodTriangles[i];
+	}
+
+	std::cout << ", " << clusters << " clusters\n";
+      }
+
+      // Not fatal, it'll be imported again next time.
+      if (!mesh_cache::Write(cachePath, sourceHash, meshes)) {
+	std::cerr << __FUNCTION__ << ": couldn't bake " << path << " into " << cachePath << '\n';
+      }
+
+      return meshes;
+    }
+
+    static model_handle CreateModel(u32 index)
+    {
+      model_info const& info{model_registry::Get(index)};
+      model_handle const handle{_models.Create()};
+      model* newModel{_models.Get(handle)};
+
+      // Full, the pool says so. Stays unloaded, asking again tries again.
+      if (newModel == nullptr) {
+	return handle;
+      }
+
+      newModel->_directory = std::filesystem::path(info._path).parent_path();
+      newModel->_isOccluder = info._isOccluder;
+      newModel->_residency = info._residency;
+
+      _modelHandles[index] = handle;
+
+      return handle;
+    }
+
+    static void RequestModel(model_id id)
+    {
+      u32 const index{model_registry::GetIndex(id)};
+
+      if (_modelHandles[index].IsValid()) {
+	return;
+      }
+
+      model_handle const handle{CreateModel(index)};
+
+      if (handle.IsValid()) {
+	SubmitModel(handle, model_registry::Get(index)._path);
+      }
+    }
+
+    static void SubmitModel(model_handle handle, std::filesystem::path const& path)
+    {
+      SubmitLoadJob([handle, path] {
+	LAIN_PROFILE_ZONE("resource_manager::ParseModel");
+	allocation_tracker::scoped_tag const tag{allocation_tracker::tag::resources};
+
+	u64 const start{profiler::Now()};
+	bool cached;
+
+	std::vector<mesh_data> meshes{ParseModel(path, cached)};
+
+	// Materials name their textures relative to the model, two models' "diffuse.png" can be different files.
+	for (auto& data : meshes) {
+	  for (auto& texture : data._textures) {
+	    texture._path = asset_pack::NormaliseName(path.parent_path() / texture._path);
+	    RequestTexture(texture._path);
+	  }
+	}
+
+	double const ms{(profiler::Now() - start) / 1e6};
+
+	QueueUpload([handle, path, cached, ms, meshes = std::move(meshes)]() mutable {
+	  model* model{_models.Get(handle)};
+
+	  // Drops the placeholder if it was streamed.
+	  model->_meshes.clear();
+	  model->_isResident = true;
+
+	  // What the meshes used to keep around for good against what's left on the CPU now.
+	  u64 keptBefore{0};
+	  u64 const residentBefore{collision_mesh::GetResidentBytes()};
+
+	  for (auto& data : meshes) {
+	    keptBefore += data._vertices.size() * sizeof(vertex_data) + data._indices.size() * sizeof(u32);
+
+	    mesh_handle const created{_meshes.Create(std::move(data), _vertexFormat, model->_residency)};
+
+	    // Full, the pool says so. The model is drawn without it.
+	    if (created.IsValid()) {
+	      model->_meshes.push_back(created);
+	    }
+	  }
+
+	  u64 const kept{collision_mesh::GetResidentBytes() - residentBefore};
+
+	  std::cout << "LoadModel: " << path << (cached ? " from cache" : " from source") << " in " << ms << " ms, "
+		    << keptBefore / 1024 << " -> " << kept / 1024 << " KiB resident on the CPU\n";
+	});
+      });
+    }
+
+    // `path` is normalised, so every model referencing the same file shares the texture.
+    static void RequestTexture(std::string const& path)
+    {
+      {
+	std::lock_guard const lock{_loadMutex};
+
+	if (!_requestedTextures.insert(path).second) {
+	  return;
+	}
+      }
+
+      SubmitLoadJob([path] {
+	LAIN_PROFILE_ZONE("resource_manager::LoadTexture");
+	allocation_tracker::scoped_tag const tag{allocation_tracker::tag::resources};
+
+	texture_cache::baked_texture baked;
+
+	if (!LoadBakedTexture(path, false, baked)) {
+	  std::cerr << "LoadTexture: couldn't load texture from file " << path << '\n';
+
+	  // Id 0 tells `ResolveMeshTextures` to give up on it.
+	  QueueUpload([path] { _meshTexturesCache[path] = mesh_texture{0, "", path}; });
+	  return;
+	}
+
+	QueueUpload([baked = std::move(baked), path]() mutable {
+	  u32 const textureId{UploadTexture(baked, GL_REPEAT, GL_REPEAT)};
+
+	  texture_cache::Release(baked);
+
+	  _meshTexturesCache[path] = mesh_texture{textureId, "", path};
+	});
+      });
+    }
+
+    // Meshes come out of the workers with texture names only, the ids are known once the uploads
+    // ran. Until then streamed meshes use the placeholder.
+    static void ResolveMeshTextures()
+    {
+      _meshes.ForEach([](mesh_handle, mesh& mesh) {
+	for (auto& texture : mesh._textures) {
+	  if (texture._id == 0 || texture._id == _placeholderTexture) {
+	    auto it = _meshTexturesCache.find(texture._path);
+
+	    texture._id = it != _meshTexturesCache.end() ? it->second._id : _placeholderTexture;
+	  }
+	}
+
+	// The ones that couldn't be loaded have been reported already.
+	std::erase_if(mesh._textures, [](mesh_texture const& texture) { return texture._id == 0; });
+      });
+    }
+
+    static void SubmitLoadJob(std::function<void()> job)
+    {
+      {
+	std::lock_guard const lock{_loadMutex};
+	++_loadJobs;
+      }
+
+      ++_loadTotal;
+
+      thread_pool::Submit([job = std::move(job)] {
+	// The whole job, not just what it tags itself, runs outside the frame.
+	allocation_tracker::scoped_tag const tag{allocation_tracker::tag::resources};
+
+	job();
+
+	++_loadDone;
+
+	{
+	  std::lock_guard const lock{_loadMutex};
+	  --_loadJobs;
+	}
+
+	_loadCondition.notify_all();
+      });
+    }
+
+    static void QueueUpload(std::function<void()> upload)
+    {
+      {
+	std::lock_guard const lock{_loadMutex};
+	_uploads.push_back(std::move(upload));
+      }
+
+      ++_loadTotal;
+
+      _loadCondition.notify_all();
+    }
+
+    // Runs uploads as they come in until no job is left.
+    static void PumpUploads(progress_callback onProgress)
+    {
+      LAIN_PROFILE_ZONE("resource_manager::PumpUploads");
+
+      std::unique_lock lock{_loadMutex};
+
+      while (true) {
+	_loadCondition.wait(lock, [] { return !_uploads.empty() || _loadJobs == 0; });
+
+	if (_uploads.empty()) {
+	  return;
+	}
+
+	std::function<void()> upload{std::move(_uploads.front())};
+	_uploads.pop_front();
+
+	lock.unlock();
+
+	upload();
+
+	++_loadDone;
+
+	if (onProgress != nullptr) {
+	  onProgress(GetLoadingProgress());
+	}
+
+	lock.lock();
+      }
+    }
+
+    static mesh_data MakePlaceholderMesh()
+    {
+      // Unit cube, four vertices per face so each face gets its own normal.
+      mesh_data data{};
+      glm::vec3 const normals[] = {
+	{1.f, 0.f, 0.f}, {-1.f, 0.f, 0.f}, {0.f, 1.f, 0.f}, {0.f, -1.f, 0.f}, {0.f, 0.f, 1.f}, {0.f, 0.f, -1.f}
+      };
+      glm::vec2 const corners[] = {{-1.f, -1.f}, {1.f, -1.f}, {1.f, 1.f}, {-1.f, 1.f}};
+
+      for (auto const& normal : normals) {
+	// u x v == normal, so the face is counter-clockwise seen from outside.
+	glm::vec3 const u{normal.y, normal.z, normal.x};
+	glm::vec3 const v{glm::cross(normal, u)};
+	u32 const base{static_cast<u32>(data._vertices.size())};
+
+	for (auto const& corner : corners) {
+	  data._vertices.push_back(vertex_data{(normal + u * corner.x + v * corner.y) * 0.5f, normal, (corner + 1.f) * 0.5f});
+	}
+
+	for (u32 const index : {0u, 1u, 2u, 0u, 2u, 3u}) {
+	  data._indices.push_back(base + index);
+	}
+      }
+
+      data._boundingBox = aabb{glm::vec3(-0.5f), glm::vec3(0.5f)};
+      data._diffuseColour = glm::vec3(0.5f);
+
+      return data;
+    }
+
+    // Reads the encoded image out of the asset pack (or the loose file) without copying it. Always
+    // RGBA, `channels` is what the file had. Flipped here rather than with stb's flag, which is
+    // global and workers decode at the same time.
+    static unsigned char* DecodeImage(std::filesystem::path const& file, bool flip, i32* width, i32* height, i32* channels)
+    {
+      mapped_file encoded;
+
+      if (!asset_pack::Open(file, encoded)) {
+	return nullptr;
+      }
+
+      unsigned char* data{stbi_load_from_memory(reinterpret_cast<unsigned char const*>(encoded._data),
+						static_cast<i32>(encoded._size), width, height, channels, 4)};
+
+      asset_pack::Close(encoded);
+
+      if (data != nullptr && flip) {
+	std::size_t const stride{static_cast<std::size_t>(*width) * 4};
+
+	for (i32 y{0}; y < *height / 2; ++y) {
+	  std::swap_ranges(data + y * stride, data + (y + 1) * stride, data + (*height - 1 - y) * stride);
+	}
+      }
+
+      return data;
+    }
+
+    // BC1 for opaque images and BC3 for ones with alpha, both S3TC. BC7 is core, so it's
+    // the fallback for drivers without S3TC.
+    static texture_cache::texture_format GetTextureFormat(i32 channels)
+    {
+      bool const hasAlpha{channels == 2 || channels == 4};
+
+      switch (_textureCompression) {
+      case texture_cache::compression::none:
+	return texture_cache::texture_format::rgba8;
+      case texture_cache::compression::bc7:
+	return texture_cache::texture_format::bc7;
       default:
-	return "";
+	break;
       }
+
+      if (!_hasS3TC) {
+	return texture_cache::texture_format::bc7;
+      }
+
+      return hasAlpha ? texture_cache::texture_format::bc3 : texture_cache::texture_format::bc1;
     }
 
-    static void LoadModels()
+    // Any thread. Maps the baked texture, baking it first if it's missing, stale or in another format.
+    static bool LoadBakedTexture(std::filesystem::path const& file, bool flip, texture_cache::baked_texture& baked)
     {
-      //
-      // TODO: is there a way to freaking do this automatically?
-      //
-      LoadModel(model_type::maze);
-      LoadModel(model_type::ball);
+      u64 const hash{texture_cache::HashSource(file, flip)};
+      std::filesystem::path const cachePath{texture_cache::GetCachePath(file, flip)};
+
+      if (texture_cache::Read(cachePath, hash, baked) && baked._format == GetTextureFormat(baked._channels)) {
+	return true;
+      }
+
+      texture_cache::Release(baked);
+
+      i32 width, height, channels;
+      unsigned char* rgba{DecodeImage(file, flip, &width, &height, &channels)};
+
+      if (rgba == nullptr) {
+	return false;
+      }
+
+      bool const ok{texture_cache::Bake(rgba, static_cast<u32>(width), static_cast<u32>(height), channels,
+					GetTextureFormat(channels), hash, baked)};
+
+      stbi_image_free(rgba);
+
+      // Not fatal, the next launch bakes it again.
+      if (ok) {
+	texture_cache::Write(cachePath, baked);
+      }
+
+      return ok;
+    }
+
+    static bool HasExtension(char const* name)
+    {
+      GLint count{0};
+      glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+      for (GLint i{0}; i < count; ++i) {
+	if (std::strcmp(reinterpret_cast<char const*>(glGetStringi(GL_EXTENSIONS, i)), name) == 0) {
+	  return true;
+	}
+      }
+
+      return false;
+    }
+
+    // Storage for the whole mip chain at once, then every level straight out of the mapping
+    // (or the freshly baked buffer).
+    static u32 UploadTexture(texture_cache::baked_texture const& baked, i32 wrapS, i32 wrapT)
+    {
+      GLenum internalFormat;
+
+      switch (baked._format) {
+      case texture_cache::texture_format::bc1:
+	internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	break;
+      case texture_cache::texture_format::bc3:
+	internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	break;
+      case texture_cache::texture_format::bc7:
+	internalFormat = GL_COMPRESSED_RGBA_BPTC_UNORM;
+	break;
+      default:
+	internalFormat = GL_RGBA8;
+	break;
+      }
+
+      u32 glTexId;
+      glGenTextures(1, &glTexId);
+      gl_state::BindTexture(GL_TEXTURE_2D, glTexId);
+      glTexStorage2D(GL_TEXTURE_2D, baked._levelCount, internalFormat, baked._width, baked._height);
+
+      for (u32 i{0}; i < baked._levelCount; ++i) {
+	texture_cache::texture_level const& level{baked._levels[i]};
+
+	if (baked._format == texture_cache::texture_format::rgba8) {
+	  glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, level._width, level._height, GL_RGBA, GL_UNSIGNED_BYTE,
+			  baked.GetLevelData(i));
+	} else {
+	  glCompressedTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, level._width, level._height, internalFormat,
+				    static_cast<GLsizei>(level._size), baked.GetLevelData(i));
+	}
+      }
+
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapS);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapT);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      gl_state::BindTexture(GL_TEXTURE_2D, 0);
+
+      return glTexId;
     }
   };
 };
@@ -0,0 +1,141 @@
+#include "l_shader_cache.h"
+#include "glad/glad.h"
+#include "l_common.h"
+#include "l_gl_state.h"
+#include "l_mapped_file.h"
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace lain
+{
+  namespace shader_cache
+  {
+    static u32 constexpr kMagic{0x4248534c}; // "LSHB"
+    static u32 constexpr kVersion{1};
+
+    struct file_header final
+    {
+      u32 _magic;
+      u32 _version;
+      u64 _hash;
+      u32 _format; // whatever glGetProgramBinary said, only meaningful to the same driver
+      u32 _padding;
+    };
+
+    static std::filesystem::path GetPath(u64 hash);
+
+    u64 Hash(std::string_view vertexSource, std::string_view fragmentSource)
+    {
+      u64 hash{fnv1a64(vertexSource.data(), vertexSource.size())};
+      hash = fnv1a64(fragmentSource.data(), fragmentSource.size(), hash);
+
+      for (GLenum const name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+	char const* string{reinterpret_cast<char const*>(glGetString(name))};
+
+	if (string != nullptr) {
+	  hash = fnv1a64(string, std::strlen(string), hash);
+	}
+      }
+
+      return hash;
+    }
+
+    u32 Load(u64 hash)
+    {
+      mapped_file file;
+
+      if (!MapFile(GetPath(hash), file)) {
+	return 0;
+      }
+
+      file_header header;
+      bool valid{file._size > sizeof(header)};
+
+      if (valid) {
+	std::memcpy(&header, file._data, sizeof(header));
+	valid = header._magic == kMagic && header._version == kVersion && header._hash == hash;
+      }
+
+      u32 program{0};
+
+      if (valid) {
+	program = glCreateProgram();
+
+	glProgramBinary(program, header._format, file._data + sizeof(header), static_cast<GLsizei>(file._size - sizeof(header)));
+
+	i32 success{0};
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+	// Usually a driver update that kept the version string, it gets compiled and saved again.
+	if (success != GL_TRUE) {
+	  glDeleteProgram(program);
+	  gl_state::ForgetProgram(program);
+	  program = 0;
+	}
+      }
+
+      UnmapFile(file);
+
+      return program;
+    }
+
+    void Save(u32 program, u64 hash)
+    {
+      i32 length{0};
+      glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+      // Drivers without any binary format report 0.
+      if (length <= 0) {
+	return;
+      }
+
+      std::vector<char> binary(length);
+      GLenum format;
+
+      glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+      std::filesystem::path const path{GetPath(hash)};
+      std::error_code error;
+      std::filesystem::create_directories(path.parent_path(), error);
+
+      // Written next to the real one and renamed, so a crash never leaves half a cache behind.
+      std::filesystem::path temporary{path};
+      temporary += ".tmp";
+
+      std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+
+      file_header const header{kMagic, kVersion, hash, format, 0};
+
+      out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+      out.write(binary.data(), binary.size());
+      out.close();
+
+      // Not fatal, it'll be compiled again next time.
+      if (!out) {
+	std::cerr << __FUNCTION__ << ": couldn't write " << temporary << '\n';
+	std::filesystem::remove(temporary, error);
+	return;
+      }
+
+      std::filesystem::rename(temporary, path, error);
+
+      if (error) {
+	std::cerr << __FUNCTION__ << ": couldn't rename " << temporary << " to " << path << '\n';
+	std::filesystem::remove(temporary, error);
+      }
+    }
+
+    static std::filesystem::path GetPath(u64 hash)
+    {
+      char name[32];
+      std::snprintf(name, sizeof(name), "%016" PRIx64 ".bin", hash);
+
+      return std::filesystem::path{"./res/cache/shaders"} / name;
+    }
+  };
+};
@@ -0,0 +1,886 @@
+#include "l_texture_cache.h"
+#include "l_asset_pack.h"
+#include "l_common.h"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace lain
+{
+  namespace texture_cache
+  {
+    static u32 constexpr kMagic{0x5845544c}; // "LTEX"
+    // Levels start on a 16 byte boundary, the mapping itself is at least page (or pack) aligned.
+    static u64 constexpr kLevelAlignment{16};
+
+    // BC7 interpolation weights for 4 bit indices, out of 64.
+    static u32 constexpr kBC7Weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    struct file_header final
+    {
+      u32 _magic;
+      u32 _version;
+      u64 _sourceHash;
+      texture_format _format;
+      u32 _width;
+      u32 _height;
+      i32 _channels;
+      u32 _levelCount;
+      u32 _padding;
+    };
+
+    // Bits in a compressed block, least significant first.
+    struct bit_writer final
+    {
+      std::byte* _data;
+      u32 _bit;
+
+      void Write(u32 value, u32 count)
+      {
+	for (u32 i{0}; i < count; ++i, ++_bit) {
+	  if ((value >> i & 1) != 0) {
+	    _data[_bit / 8] |= static_cast<std::byte>(1 << _bit % 8);
+	  }
+	}
+      }
+    };
+
+    struct bit_reader final
+    {
+      std::byte const* _data;
+      u32 _bit;
+
+      u32 Read(u32 count)
+      {
+	u32 value{0};
+
+	for (u32 i{0}; i < count; ++i, ++_bit) {
+	  value |= static_cast<u32>(_data[_bit / 8] >> _bit % 8 & std::byte{1}) << i;
+	}
+
+	return value;
+      }
+    };
+
+    static bool Parse(std::byte const* data, std::size_t size, u64 sourceHash, baked_texture& texture);
+    static void Downsample(u8 const* source, u32 width, u32 height, std::vector<u8>& destination);
+    static void FitEndpoints(u8 const* rgba, u32 channels, f32* low, f32* high);
+    static bool RefineEndpoints(u8 const* rgba, u32 channels, f32 const* t, f32* low, f32* high);
+    static u32 GetBlockSize(texture_format format);
+    static u16 To565(f32 const* colour);
+    static void From565(u16 colour, u8* rgb);
+    static void EncodeColourBlock(u8 const* rgba, std::byte* block);
+    static void DecodeColourBlock(std::byte const* block, bool alwaysFourColours, u8* rgba);
+    static void EncodeAlphaBlock(u8 const* rgba, std::byte* block);
+    static void DecodeAlphaBlock(std::byte const* block, u8* rgba);
+
+    u64 HashSource(std::filesystem::path const& source, bool flip)
+    {
+      u64 hash{fnv1a64(nullptr, 0)}; // just the offset basis
+
+      mapped_file file;
+
+      if (asset_pack::Open(source, file)) {
+	hash = fnv1a64(file._data, file._size, hash);
+	asset_pack::Close(file);
+      }
+
+      u32 const flipped{flip ? 1u : 0u};
+
+      return fnv1a64(&flipped, sizeof(flipped), hash);
+    }
+
+    std::filesystem::path GetCachePath(std::filesystem::path const& source, bool flip)
+    {
+      // Keep the extension, "wall.png" and "wall.jpg" are different textures.
+      std::filesystem::path path{asset_pack::GetCachePath("./res/cache/textures", source)};
+      path += flip ? ".flipped.ltex" : ".ltex";
+
+      return path;
+    }
+
+    bool Bake(u8 const* rgba, u32 width, u32 height, i32 channels, texture_format format, u64 sourceHash,
+	      baked_texture& texture)
+    {
+      Release(texture);
+
+      u32 const levelCount{static_cast<u32>(std::bit_width(std::max(width, height)))};
+
+      if (width == 0 || height == 0 || levelCount > kMaxLevels) {
+	std::cerr << __FUNCTION__ << ": can't bake a " << width << "x" << height << " texture\n";
+	return false;
+      }
+
+      file_header const header{kMagic, kVersion, sourceHash, format, width, height, channels, levelCount, 0};
+      texture_level levels[kMaxLevels];
+      u64 offset{sizeof(header) + levelCount * sizeof(texture_level)};
+
+      for (u32 i{0}; i < levelCount; ++i) {
+	u32 const levelWidth{std::max(width >> i, 1u)};
+	u32 const levelHeight{std::max(height >> i, 1u)};
+
+	offset = (offset + kLevelAlignment - 1) / kLevelAlignment * kLevelAlignment;
+	levels[i] = {levelWidth, levelHeight, offset, GetLevelSize(format, levelWidth, levelHeight)};
+	offset += levels[i]._size;
+      }
+
+      texture._memory.assign(offset, std::byte{0});
+
+      std::memcpy(texture._memory.data(), &header, sizeof(header));
+      std::memcpy(texture._memory.data() + sizeof(header), levels, levelCount * sizeof(texture_level));
+
+      // Every level is filtered from the one above it, which is already in `current`.
+      std::vector<u8> current(rgba, rgba + static_cast<std::size_t>(width) * height * 4);
+      std::vector<u8> next;
+
+      for (u32 i{0}; i < levelCount; ++i) {
+	EncodeLevel(format, current.data(), levels[i]._width, levels[i]._height, texture._memory.data() + levels[i]._offset);
+
+	if (i + 1 < levelCount) {
+	  Downsample(current.data(), levels[i]._width, levels[i]._height, next);
+	  std::swap(current, next);
+	}
+      }
+
+      return Parse(texture._memory.data(), texture._memory.size(), sourceHash, texture);
+    }
+
+    bool Write(std::filesystem::path const& file, baked_texture const& texture)
+    {
+      assert(!texture._memory.empty() && "only freshly baked textures can be written");
+
+      std::error_code error;
+      std::filesystem::create_directories(file.parent_path(), error);
+
+      // Written next to the real one and renamed, so a crash never leaves half a cache behind.
+      std::filesystem::path temporary{file};
+      temporary += ".tmp";
+
+      std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+
+      if (!out) {
+	std::cerr << __FUNCTION__ << ": couldn't open " << temporary << '\n';
+	return false;
+      }
+
+      out.write(reinterpret_cast<char const*>(texture._memory.data()), texture._memory.size());
+      out.close();
+
+      if (!out) {
+	std::cerr << __FUNCTION__ << ": couldn't write " << temporary << '\n';
+	std::filesystem::remove(temporary, error);
+	return false;
+      }
+
+      std::filesystem::rename(temporary, file, error);
+
+      if (error) {
+	std::cerr << __FUNCTION__ << ": couldn't rename " << temporary << " to " << file << '\n';
+	std::filesystem::remove(temporary, error);
+	return false;
+      }
+
+      return true;
+    }
+
+    bool Read(std::filesystem::path const& file, u64 sourceHash, baked_texture& texture)
+    {
+      Release(texture);
+
+      mapped_file mapped;
+
+      if (!asset_pack::Open(file, mapped)) {
+	return false;
+      }
+
+      if (!Parse(mapped._data, mapped._size, sourceHash, texture)) {
+	asset_pack::Close(mapped);
+	return false;
+      }
+
+      texture._file = mapped;
+
+      return true;
+    }
+
+    void Release(baked_texture& texture)
+    {
+      if (texture._file._data != nullptr) {
+	asset_pack::Close(texture._file);
+      }
+
+      texture._file = {nullptr, 0};
+      texture._memory = {};
+      texture._levelCount = 0;
+    }
+
+    u64 GetLevelSize(texture_format format, u32 width, u32 height)
+    {
+      if (format == texture_format::rgba8) {
+	return static_cast<u64>(width) * height * 4;
+      }
+
+      return static_cast<u64>((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(format);
+    }
+
+    void EncodeLevel(texture_format format, u8 const* rgba, u32 width, u32 height, std::byte* out)
+    {
+      if (format == texture_format::rgba8) {
+	std::memcpy(out, rgba, static_cast<std::size_t>(width) * height * 4);
+	return;
+      }
+
+      u32 const blockSize{GetBlockSize(format)};
+
+      for (u32 by{0}; by < height; by += 4) {
+	for (u32 bx{0}; bx < width; bx += 4) {
+	  u8 block[16 * 4];
+
+	  for (u32 y{0}; y < 4; ++y) {
+	    for (u32 x{0}; x < 4; ++x) {
+	      u32 const sx{std::min(bx + x, width - 1)};
+	      u32 const sy{std::min(by + y, height - 1)};
+
+	      std::memcpy(block + (y * 4 + x) * 4, rgba + (static_cast<std::size_t>(sy) * width + sx) * 4, 4);
+	    }
+	  }
+
+	  switch (format) {
+	  case texture_format::bc1:
+	    EncodeBC1(block, out);
+	    break;
+	  case texture_format::bc3:
+	    EncodeBC3(block, out);
+	    break;
+	  default:
+	    EncodeBC7(block, out);
+	    break;
+	  }
+
+	  out += blockSize;
+	}
+      }
+    }
+
+    void DecodeLevel(texture_format format, std::byte const* data, u32 width, u32 height, u8* rgba)
+    {
+      if (format == texture_format::rgba8) {
+	std::memcpy(rgba, data, static_cast<std::size_t>(width) * height * 4);
+	return;
+      }
+
+      u32 const blockSize{GetBlockSize(format)};
+
+      for (u32 by{0}; by < height; by += 4) {
+	for (u32 bx{0}; bx < width; bx += 4) {
+	  u8 block[16 * 4];
+
+	  switch (format) {
+	  case texture_format::bc1:
+	    DecodeBC1(data, block);
+	    break;
+	  case texture_format::bc3:
+	    DecodeBC3(data, block);
+	    break;
+	  default:
+	    DecodeBC7(data, block);
+	    break;
+	  }
+
+	  for (u32 y{0}; y < 4 && by + y < height; ++y) {
+	    for (u32 x{0}; x < 4 && bx + x < width; ++x) {
+	      std::memcpy(rgba + (static_cast<std::size_t>(by + y) * width + bx + x) * 4, block + (y * 4 + x) * 4, 4);
+	    }
+	  }
+
+	  data += blockSize;
+	}
+      }
+    }
+
+    void EncodeBC1(u8 const* rgba, std::byte* block)
+    {
+      EncodeColourBlock(rgba, block);
+    }
+
+    void EncodeBC3(u8 const* rgba, std::byte* block)
+    {
+      EncodeAlphaBlock(rgba, block);
+      EncodeColourBlock(rgba, block + 8);
+    }
+
+    void EncodeBC7(u8 const* rgba, std::byte* block)
+    {
+      //
+      // Mode 6 only: one subset, RGBA endpoints with 7 bits per channel plus a shared
+      // low bit per endpoint, and 4 bit indices. Not the best mode for every block,
+      // but a good one for most and simple enough to encode quickly.
+      //
+      f32 low[4], high[4];
+      FitEndpoints(rgba, 4, low, high);
+
+      u32 bestQuantised[2][4]{};
+      u32 bestP[2]{};
+      u32 bestIndices[16]{};
+      u32 bestError{~0u};
+
+      for (u32 pass{0}; pass < 2; ++pass) {
+	u32 quantised[2][4]{};
+	u32 p[2]{};
+	u8 endpoints[2][4];
+
+	// Pick the low bit that gets each endpoint closest.
+	for (u32 e{0}; e < 2; ++e) {
+	  f32 const* target{e == 0 ? low : high};
+	  f32 bestEndpointError{INFINITY};
+
+	  for (u32 bit{0}; bit < 2; ++bit) {
+	    f32 error{0.f};
+	    u32 q[4];
+
+	    for (u32 c{0}; c < 4; ++c) {
+	      f32 const value{std::clamp(std::round((target[c] - bit) / 2.f), 0.f, 127.f)};
+	      f32 const d{value * 2.f + bit - target[c]};
+
+	      q[c] = static_cast<u32>(value);
+	      error += d * d;
+	    }
+
+	    if (error < bestEndpointError) {
+	      bestEndpointError = error;
+	      p[e] = bit;
+	      std::copy(q, q + 4, quantised[e]);
+	    }
+	  }
+
+	  for (u32 c{0}; c < 4; ++c) {
+	    endpoints[e][c] = static_cast<u8>(quantised[e][c] << 1 | p[e]);
+	  }
+	}
+
+	u8 palette[16][4];
+
+	for (u32 i{0}; i < 16; ++i) {
+	  for (u32 c{0}; c < 4; ++c) {
+	    palette[i][c] = static_cast<u8>(((64 - kBC7Weights[i]) * endpoints[0][c] + kBC7Weights[i] * endpoints[1][c] + 32) >> 6);
+	  }
+	}
+
+	u32 indices[16];
+	u32 error{0};
+
+	for (u32 i{0}; i < 16; ++i) {
+	  u32 best{~0u};
+
+	  for (u32 j{0}; j < 16; ++j) {
+	    u32 d{0};
+
+	    for (u32 c{0}; c < 4; ++c) {
+	      i32 const delta{static_cast<i32>(rgba[i * 4 + c]) - palette[j][c]};
+	      d += static_cast<u32>(delta * delta);
+	    }
+
+	    if (d < best) {
+	      best = d;
+	      indices[i] = j;
+	    }
+	  }
+
+	  error += best;
+	}
+
+	if (error < bestError) {
+	  bestError = error;
+	  std::copy(&quantised[0][0], &quantised[0][0] + 8, &bestQuantised[0][0]);
+	  std::copy(p, p + 2, bestP);
+	  std::copy(indices, indices + 16, bestIndices);
+	}
+
+	// Second pass: least squares endpoints for the indices just picked.
+	f32 t[16];
+
+	for (u32 i{0}; i < 16; ++i) {
+	  t[i] = kBC7Weights[indices[i]] / 64.f;
+	}
+
+	if (bestError == 0 || !RefineEndpoints(rgba, 4, t, low, high)) {
+	  break;
+	}
+      }
+
+      // The first index is stored with 3 bits, its top bit has to be 0.
+      if (bestIndices[0] >= 8) {
+	std::swap(bestQuantised[0], bestQuantised[1]);
+	std::swap(bestP[0], bestP[1]);
+
+	for (auto& index : bestIndices) {
+	  index = 15 - index;
+	}
+      }
+
+      std::fill(block, block + 16, std::byte{0});
+
+      bit_writer out{block, 0};
+
+      out.Write(1 << 6, 7); // mode 6
+
+      for (u32 c{0}; c < 4; ++c) {
+	out.Write(bestQuantised[0][c], 7);
+	out.Write(bestQuantised[1][c], 7);
+      }
+
+      out.Write(bestP[0], 1);
+      out.Write(bestP[1], 1);
+
+      for (u32 i{0}; i < 16; ++i) {
+	out.Write(bestIndices[i], i == 0 ? 3 : 4);
+      }
+    }
+
+    void DecodeBC1(std::byte const* block, u8* rgba)
+    {
+      DecodeColourBlock(block, false, rgba);
+    }
+
+    void DecodeBC3(std::byte const* block, u8* rgba)
+    {
+      DecodeColourBlock(block + 8, true, rgba);
+      DecodeAlphaBlock(block, rgba);
+    }
+
+    void DecodeBC7(std::byte const* block, u8* rgba)
+    {
+      bit_reader in{block, 0};
+
+      if (in.Read(7) != 1 << 6) {
+	for (u32 i{0}; i < 16; ++i) {
+	  rgba[i * 4 + 0] = 255;
+	  rgba[i * 4 + 1] = 0;
+	  rgba[i * 4 + 2] = 255;
+	  rgba[i * 4 + 3] = 255;
+	}
+
+	return;
+      }
+
+      u32 endpoints[2][4];
+
+      for (u32 c{0}; c < 4; ++c) {
+	endpoints[0][c] = in.Read(7) << 1;
+	endpoints[1][c] = in.Read(7) << 1;
+      }
+
+      u32 const p0{in.Read(1)};
+      u32 const p1{in.Read(1)};
+
+      for (u32 c{0}; c < 4; ++c) {
+	endpoints[0][c] |= p0;
+	endpoints[1][c] |= p1;
+      }
+
+      for (u32 i{0}; i < 16; ++i) {
+	u32 const w{kBC7Weights[in.Read(i == 0 ? 3 : 4)]};
+
+	for (u32 c{0}; c < 4; ++c) {
+	  rgba[i * 4 + c] = static_cast<u8>(((64 - w) * endpoints[0][c] + w * endpoints[1][c] + 32) >> 6);
+	}
+      }
+    }
+
+    static bool Parse(std::byte const* data, std::size_t size, u64 sourceHash, baked_texture& texture)
+    {
+      file_header header;
+
+      if (size < sizeof(header)) {
+	return false;
+      }
+
+      std::memcpy(&header, data, sizeof(header));
+
+      bool valid{header._magic == kMagic &&
+		 header._version == kVersion &&
+		 header._sourceHash == sourceHash &&
+		 header._format <= texture_format::bc7 &&
+		 header._levelCount > 0 && header._levelCount <= kMaxLevels &&
+		 sizeof(header) + header._levelCount * sizeof(texture_level) <= size};
+
+      if (!valid) {
+	return false;
+      }
+
+      std::memcpy(texture._levels, data + sizeof(header), header._levelCount * sizeof(texture_level));
+
+      for (u32 i{0}; i < header._levelCount && valid; ++i) {
+	texture_level const& level{texture._levels[i]};
+
+	valid = level._width == std::max(header._width >> i, 1u) &&
+	  level._height == std::max(header._height >> i, 1u) &&
+	  level._size == GetLevelSize(header._format, level._width, level._height) &&
+	  level._offset % kLevelAlignment == 0 &&
+	  level._offset <= size && level._size <= size - level._offset;
+      }
+
+      if (!valid) {
+	std::cerr << __FUNCTION__ << ": broken level table\n";
+	return false;
+      }
+
+      texture._format = header._format;
+      texture._width = header._width;
+      texture._height = header._height;
+      texture._channels = header._channels;
+      texture._levelCount = header._levelCount;
+
+      return true;
+    }
+
+    // 2x2 box filter, odd sizes drop their last row or column.
+    static void Downsample(u8 const* source, u32 width, u32 height, std::vector<u8>& destination)
+    {
+      u32 const w{std::max(width / 2, 1u)};
+      u32 const h{std::max(height / 2, 1u)};
+
+      destination.resize(static_cast<std::size_t>(w) * h * 4);
+
+      auto const at = [source, width](u32 x, u32 y, u32 c) -> u32 {
+	return source[(static_cast<std::size_t>(y) * width + x) * 4 + c];
+      };
+
+      for (u32 y{0}; y < h; ++y) {
+	u32 const y0{std::min(y * 2, height - 1)}, y1{std::min(y * 2 + 1, height - 1)};
+
+	for (u32 x{0}; x < w; ++x) {
+	  u32 const x0{std::min(x * 2, width - 1)}, x1{std::min(x * 2 + 1, width - 1)};
+
+	  for (u32 c{0}; c < 4; ++c) {
+	    u32 const sum{at(x0, y0, c) + at(x1, y0, c) + at(x0, y1, c) + at(x1, y1, c)};
+
+	    destination[(static_cast<std::size_t>(y) * w + x) * 4 + c] = static_cast<u8>((sum + 2) / 4);
+	  }
+	}
+      }
+    }
+
+    // Endpoints at both ends of the block's colours projected on their principal axis. With 3
+    // channels alpha is left out.
+    static void FitEndpoints(u8 const* rgba, u32 channels, f32* low, f32* high)
+    {
+      f32 mean[4]{};
+
+      for (u32 i{0}; i < 16; ++i) {
+	for (u32 c{0}; c < channels; ++c) {
+	  mean[c] += rgba[i * 4 + c] / 16.f;
+	}
+      }
+
+      f32 covariance[4][4]{};
+
+      for (u32 i{0}; i < 16; ++i) {
+	for (u32 a{0}; a < channels; ++a) {
+	  for (u32 b{0}; b < channels; ++b) {
+	    covariance[a][b] += (rgba[i * 4 + a] - mean[a]) * (rgba[i * 4 + b] - mean[b]);
+	  }
+	}
+      }
+
+      // A few rounds of power iteration are plenty for a 4x4 block.
+      f32 axis[4] = {1.f, 1.f, 1.f, 1.f};
+
+      for (u32 iteration{0}; iteration < 8; ++iteration) {
+	f32 next[4]{};
+	f32 largest{0.f};
+
+	for (u32 a{0}; a < channels; ++a) {
+	  for (u32 b{0}; b < channels; ++b) {
+	    next[a] += covariance[a][b] * axis[b];
+	  }
+
+	  largest = std::max(largest, std::abs(next[a]));
+	}
+
+	if (largest == 0.f) {
+	  break;
+	}
+
+	for (u32 c{0}; c < channels; ++c) {
+	  axis[c] = next[c] / largest;
+	}
+      }
+
+      f32 length{0.f};
+
+      for (u32 c{0}; c < channels; ++c) {
+	length += axis[c] * axis[c];
+      }
+
+      length = std::sqrt(length);
+
+      f32 minimum{0.f}, maximum{0.f};
+
+      if (length > 0.f) {
+	for (u32 i{0}; i < 16; ++i) {
+	  f32 t{0.f};
+
+	  for (u32 c{0}; c < channels; ++c) {
+	    t += (rgba[i * 4 + c] - mean[c]) * axis[c] / length;
+	  }
+
+	  minimum = std::min(minimum, t);
+	  maximum = std::max(maximum, t);
+	}
+      }
+
+      for (u32 c{0}; c < channels; ++c) {
+	f32 const direction{length > 0.f ? axis[c] / length : 0.f};
+
+	low[c] = std::clamp(mean[c] + direction * minimum, 0.f, 255.f);
+	high[c] = std::clamp(mean[c] + direction * maximum, 0.f, 255.f);
+      }
+    }
+
+    // Least squares endpoints for fixed interpolation factors `t` (0 is `low`, 1 is `high`).
+    // False if they can't be solved for, e.g. every pixel picked the same factor.
+    static bool RefineEndpoints(u8 const* rgba, u32 channels, f32 const* t, f32* low, f32* high)
+    {
+      f32 aa{0.f}, ab{0.f}, bb{0.f};
+      f32 ap[4]{}, bp[4]{};
+
+      for (u32 i{0}; i < 16; ++i) {
+	f32 const a{1.f - t[i]};
+	f32 const b{t[i]};
+
+	aa += a * a;
+	ab += a * b;
+	bb += b * b;
+
+	for (u32 c{0}; c < channels; ++c) {
+	  ap[c] += a * rgba[i * 4 + c];
+	  bp[c] += b * rgba[i * 4 + c];
+	}
+      }
+
+      f32 const determinant{aa * bb - ab * ab};
+
+      if (std::abs(determinant) < 1e-6f) {
+	return false;
+      }
+
+      for (u32 c{0}; c < channels; ++c) {
+	low[c] = std::clamp((bb * ap[c] - ab * bp[c]) / determinant, 0.f, 255.f);
+	high[c] = std::clamp((aa * bp[c] - ab * ap[c]) / determinant, 0.f, 255.f);
+      }
+
+      return true;
+    }
+
+    static u32 GetBlockSize(texture_format format)
+    {
+      return format == texture_format::bc1 ? 8 : 16;
+    }
+
+    static u16 To565(f32 const* colour)
+    {
+      u32 const r{static_cast<u32>(std::round(colour[0] * 31.f / 255.f))};
+      u32 const g{static_cast<u32>(std::round(colour[1] * 63.f / 255.f))};
+      u32 const b{static_cast<u32>(std::round(colour[2] * 31.f / 255.f))};
+
+      return static_cast<u16>(r << 11 | g << 5 | b);
+    }
+
+    static void From565(u16 colour, u8* rgb)
+    {
+      u32 const r{colour >> 11u & 31u};
+      u32 const g{colour >> 5u & 63u};
+      u32 const b{colour & 31u};
+
+      rgb[0] = static_cast<u8>(r << 3 | r >> 2);
+      rgb[1] = static_cast<u8>(g << 2 | g >> 4);
+      rgb[2] = static_cast<u8>(b << 3 | b >> 2);
+    }
+
+    // The BC1 block, always in its four colour mode: alpha is ignored here.
+    static void EncodeColourBlock(u8 const* rgba, std::byte* block)
+    {
+      // Index i is at factor kFactors[i] from the first endpoint to the second.
+      static f32 constexpr kFactors[4] = {0.f, 1.f, 1.f / 3.f, 2.f / 3.f};
+
+      f32 low[4], high[4];
+      FitEndpoints(rgba, 3, low, high);
+
+      u16 bestColours[2]{};
+      u32 bestIndices{0};
+      u32 bestError{~0u};
+
+      for (u32 pass{0}; pass < 2; ++pass) {
+	u16 colours[2] = {To565(high), To565(low)};
+
+	// The first endpoint has to be the larger one for four colours, and with equal ones
+	// every index 0 is exact anyway.
+	if (colours[0] < colours[1]) {
+	  std::swap(colours[0], colours[1]);
+	}
+
+	u8 palette[4][3];
+	From565(colours[0], palette[0]);
+	From565(colours[1], palette[1]);
+
+	for (u32 c{0}; c < 3; ++c) {
+	  palette[2][c] = static_cast<u8>((2 * palette[0][c] + palette[1][c]) / 3);
+	  palette[3][c] = static_cast<u8>((palette[0][c] + 2 * palette[1][c]) / 3);
+	}
+
+	u32 const candidates{colours[0] == colours[1] ? 1u : 4u};
+	u32 indices{0};
+	u32 error{0};
+	f32 t[16];
+
+	for (u32 i{0}; i < 16; ++i) {
+	  u32 best{~0u};
+	  u32 index{0};
+
+	  for (u32 j{0}; j < candidates; ++j) {
+	    u32 d{0};
+
+	    for (u32 c{0}; c < 3; ++c) {
+	      i32 const delta{static_cast<i32>(rgba[i * 4 + c]) - palette[j][c]};
+	      d += static_cast<u32>(delta * delta);
+	    }
+
+	    if (d < best) {
+	      best = d;
+	      index = j;
+	    }
+	  }
+
+	  indices |= index << (i * 2);
+	  error += best;
+	  t[i] = kFactors[index];
+	}
+
+	if (error < bestError) {
+	  bestError = error;
+	  bestColours[0] = colours[0];
+	  bestColours[1] = colours[1];
+	  bestIndices = indices;
+	}
+
+	// Refit, with the first endpoint as `high` again to match the factors.
+	f32 refinedHigh[4], refinedLow[4];
+
+	if (bestError == 0 || !RefineEndpoints(rgba, 3, t, refinedHigh, refinedLow)) {
+	  break;
+	}
+
+	std::copy(refinedHigh, refinedHigh + 3, high);
+	std::copy(refinedLow, refinedLow + 3, low);
+      }
+
+      std::memcpy(block, bestColours, 4);
+      std::memcpy(block + 4, &bestIndices, 4);
+    }
+
+    static void DecodeColourBlock(std::byte const* block, bool alwaysFourColours, u8* rgba)
+    {
+      u16 colours[2];
+      u32 indices;
+
+      std::memcpy(colours, block, 4);
+      std::memcpy(&indices, block + 4, 4);
+
+      u8 palette[4][4];
+      From565(colours[0], palette[0]);
+      From565(colours[1], palette[1]);
+      palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+
+      if (colours[0] > colours[1] || alwaysFourColours) {
+	for (u32 c{0}; c < 3; ++c) {
+	  palette[2][c] = static_cast<u8>((2 * palette[0][c] + palette[1][c]) / 3);
+	  palette[3][c] = static_cast<u8>((palette[0][c] + 2 * palette[1][c]) / 3);
+	}
+      } else {
+	for (u32 c{0}; c < 3; ++c) {
+	  palette[2][c] = static_cast<u8>((palette[0][c] + palette[1][c]) / 2);
+	  palette[3][c] = 0;
+	}
+
+	palette[3][3] = 0;
+      }
+
+      for (u32 i{0}; i < 16; ++i) {
+	std::memcpy(rgba + i * 4, palette[indices >> (i * 2) & 3], 4);
+      }
+    }
+
+    // The BC3 alpha block: both endpoints and 3 bit indices, in its eight value mode.
+    static void EncodeAlphaBlock(u8 const* rgba, std::byte* block)
+    {
+      u8 a0{0}, a1{255};
+
+      for (u32 i{0}; i < 16; ++i) {
+	a0 = std::max(a0, rgba[i * 4 + 3]);
+	a1 = std::min(a1, rgba[i * 4 + 3]);
+      }
+
+      u8 values[8] = {a0, a1};
+
+      for (u32 i{2}; i < 8; ++i) {
+	values[i] = static_cast<u8>(((8 - i) * a0 + (i - 1) * a1) / 7);
+      }
+
+      u64 indices{0};
+
+      // Equal endpoints: every index 0.
+      for (u32 i{0}; i < 16 && a0 != a1; ++i) {
+	u32 best{~0u};
+	u64 index{0};
+
+	for (u32 j{0}; j < 8; ++j) {
+	  u32 const d{static_cast<u32>(std::abs(static_cast<i32>(rgba[i * 4 + 3]) - values[j]))};
+
+	  if (d < best) {
+	    best = d;
+	    index = j;
+	  }
+	}
+
+	indices |= index << (i * 3);
+      }
+
+      block[0] = static_cast<std::byte>(a0);
+      block[1] = static_cast<std::byte>(a1);
+      std::memcpy(block + 2, &indices, 6);
+    }
+
+    static void DecodeAlphaBlock(std::byte const* block, u8* rgba)
+    {
+      u32 const a0{static_cast<u32>(block[0])};
+      u32 const a1{static_cast<u32>(block[1])};
+      u64 indices{0};
+
+      std::memcpy(&indices, block + 2, 6);
+
+      u8 values[8] = {static_cast<u8>(a0), static_cast<u8>(a1)};
+
+      if (a0 > a1) {
+	for (u32 i{2}; i < 8; ++i) {
+	  values[i] = static_cast<u8>(((8 - i) * a0 + (i - 1) * a1) / 7);
+	}
+      } else {
+	for (u32 i{2}; i < 6; ++i) {
+	  values[i] = static_cast<u8>(((6 - i) * a0 + (i - 1) * a1) / 5);
+	}
+
+	values[6] = 0;
+	values[7] = 255;
+      }
+
+      for (u32 i{0}; i < 16; ++i) {
+	rgba[i * 4 + 3] = values[indices >> (i * 3) & 7];
+      }
+    }
+  };
+};
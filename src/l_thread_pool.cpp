@@ -0,0 +1,107 @@
+#include "l_thread_pool.h"
+#include "l_profiler.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lain
+{
+  namespace thread_pool
+  {
+    static std::vector<std::thread> _threads;
+    static std::deque<std::function<void()>> _jobs;
+    static std::mutex _mutex;
+    static std::condition_variable _jobAvailable;
+    static std::condition_variable _idle;
+    static u32 _running;
+    static bool _quit;
+
+    static void Worker();
+
+    void Initialise(u32 threadCount)
+    {
+      if (threadCount == 0) {
+	threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+      }
+
+      _quit = false;
+
+      for (u32 i{0}; i < threadCount; ++i) {
+	_threads.emplace_back(Worker);
+      }
+    }
+
+    void Shutdown()
+    {
+      {
+	std::lock_guard const lock{_mutex};
+	_quit = true;
+      }
+
+      _jobAvailable.notify_all();
+
+      for (auto& thread : _threads) {
+	thread.join();
+      }
+
+      _threads.clear();
+    }
+
+    void Submit(std::function<void()> job)
+    {
+      {
+	std::lock_guard const lock{_mutex};
+	_jobs.push_back(std::move(job));
+      }
+
+      _jobAvailable.notify_one();
+    }
+
+    void Wait()
+    {
+      std::unique_lock lock{_mutex};
+
+      _idle.wait(lock, [] { return _jobs.empty() && _running == 0; });
+    }
+
+    u32 GetThreadCount()
+    {
+      return static_cast<u32>(_threads.size());
+    }
+
+    static void Worker()
+    {
+      std::unique_lock lock{_mutex};
+
+      while (true) {
+	_jobAvailable.wait(lock, [] { return !_jobs.empty() || _quit; });
+
+	// Drain the queue before quitting, callers may be waiting on those jobs.
+	if (_jobs.empty()) {
+	  return;
+	}
+
+	std::function<void()> job{std::move(_jobs.front())};
+	_jobs.pop_front();
+	++_running;
+
+	lock.unlock();
+
+	{
+	  LAIN_PROFILE_ZONE("thread_pool::Job");
+	  job();
+	}
+
+	lock.lock();
+	--_running;
+
+	if (_jobs.empty() && _running == 0) {
+	  _idle.notify_all();
+	}
+      }
+    }
+  };
+};
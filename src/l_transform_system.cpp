@@ -1,4 +1,5 @@
 #include "l_transform_system.h"
+#include "l_profiler.h"
 #include "glm/ext/quaternion_float.hpp"
 #include <vector>
 #include <iostream>
@@ -11,6 +12,8 @@ namespace lain
 
     void Update()
     {
+      LAIN_PROFILE_ZONE("transform_system::Update");
+
       for (u32 i{0}; i < _entities.size(); ++i) {
 	// Compute model matrix for each entity
 	_entities[i]._model  = glm::mat4{1.f};
@@ -34,7 +37,7 @@ namespace lain
       _entities[id] = std::move(t);
     }
 
-    transform_component GetTransform(entity_id id)
+    transform_component const& GetTransform(entity_id id)
     {
       return _entities[id];
     }
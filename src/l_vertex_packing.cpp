@@ -0,0 +1,191 @@
+#include "l_vertex_packing.h"
+#include "glm/geometric.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace lain
+{
+  namespace vertex_packing
+  {
+    static u16 constexpr kUnormMax{65535};
+    static i16 constexpr kSnormMax{32767};
+
+    quantisation GetQuantisation(std::vector<vertex_data> const& vertices)
+    {
+      if (vertices.empty()) {
+	return {glm::vec3(0.f), glm::vec3(0.f)};
+      }
+
+      glm::vec3 min{FLT_MAX};
+      glm::vec3 max{-FLT_MAX};
+
+      for (auto const& vertex : vertices) {
+	min = glm::min(min, vertex._position);
+	max = glm::max(max, vertex._position);
+      }
+
+      return {min, max - min};
+    }
+
+    packed_vertex Pack(vertex_data const& vertex, quantisation const& quantisation)
+    {
+      packed_vertex packed{};
+
+      for (u32 i{0}; i < 3; ++i) {
+	// A flat axis has nothing to spread, every vertex sits on the offset.
+	f32 const t{quantisation._scale[i] > 0.f ? (vertex._position[i] - quantisation._offset[i]) / quantisation._scale[i] : 0.f};
+
+	packed._position[i] = static_cast<u16>(std::round(std::clamp(t, 0.f, 1.f) * kUnormMax));
+      }
+
+      EncodeOctahedral(vertex._normal, packed._normal);
+
+      packed._texCoords[0] = FloatToHalf(vertex._texCoords.x);
+      packed._texCoords[1] = FloatToHalf(vertex._texCoords.y);
+
+      return packed;
+    }
+
+    vertex_data Unpack(packed_vertex const& vertex, quantisation const& quantisation)
+    {
+      vertex_data unpacked{};
+
+      // What GL does with normalised unsigned shorts, then the shader with the uniforms.
+      for (u32 i{0}; i < 3; ++i) {
+	unpacked._position[i] = quantisation._offset[i] + vertex._position[i] / static_cast<f32>(kUnormMax) * quantisation._scale[i];
+      }
+
+      unpacked._normal = DecodeOctahedral(vertex._normal);
+      unpacked._texCoords = glm::vec2(HalfToFloat(vertex._texCoords[0]), HalfToFloat(vertex._texCoords[1]));
+
+      return unpacked;
+    }
+
+    std::vector<packed_vertex> Pack(std::vector<vertex_data> const& vertices, quantisation const& quantisation)
+    {
+      std::vector<packed_vertex> packed;
+      packed.reserve(vertices.size());
+
+      for (auto const& vertex : vertices) {
+	packed.push_back(Pack(vertex, quantisation));
+      }
+
+      return packed;
+    }
+
+    u16 FloatToHalf(f32 value)
+    {
+      u32 bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+
+      u32 const sign{(bits >> 16) & 0x8000};
+      u32 const magnitude{bits & 0x7fffffff};
+
+      // Infinity and NaN (kept quiet).
+      if (magnitude >= 0x7f800000) {
+	return static_cast<u16>(sign | 0x7c00 | (magnitude > 0x7f800000 ? 0x200 : 0));
+      }
+
+      // Rounds past 65504, the largest half.
+      if (magnitude >= 0x477ff000) {
+	return static_cast<u16>(sign | 0x7c00);
+      }
+
+      // Below 2^-14 it's a denormal half, below 2^-25 it rounds to zero.
+      if (magnitude < 0x38800000) {
+	if (magnitude < 0x33000000) {
+	  return static_cast<u16>(sign);
+	}
+
+	u32 const mantissa{(magnitude & 0x7fffff) | 0x800000};
+	u32 const shift{126 - (magnitude >> 23)};
+	u32 half{mantissa >> shift};
+	u32 const rest{mantissa & ((1u << shift) - 1)};
+	u32 const halfway{1u << (shift - 1)};
+
+	if (rest > halfway || (rest == halfway && (half & 1))) {
+	  ++half;
+	}
+
+	return static_cast<u16>(sign | half);
+      }
+
+      // Rebias the exponent and drop 13 bits of mantissa, a carry out of it bumps the exponent.
+      u32 half{(magnitude - 0x38000000) >> 13};
+      u32 const rest{magnitude & 0x1fff};
+
+      if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+	++half;
+      }
+
+      return static_cast<u16>(sign | half);
+    }
+
+    f32 HalfToFloat(u16 half)
+    {
+      u32 const sign{static_cast<u32>(half & 0x8000) << 16};
+      u32 const exponent{(half >> 10) & 0x1fu};
+      u32 const mantissa{half & 0x3ffu};
+      u32 bits;
+
+      if (exponent == 0) {
+	f32 const value{std::ldexp(static_cast<f32>(mantissa), -24)};
+	return sign ? -value : value;
+      }
+
+      if (exponent == 31) {
+	bits = sign | 0x7f800000 | (mantissa << 13);
+      } else {
+	bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+      }
+
+      f32 value;
+      std::memcpy(&value, &bits, sizeof(value));
+
+      return value;
+    }
+
+    void EncodeOctahedral(glm::vec3 const& normal, i16 encoded[2])
+    {
+      f32 const length{std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z)};
+
+      if (length == 0.f) {
+	encoded[0] = encoded[1] = 0;
+	return;
+      }
+
+      // Onto the octahedron, then the lower half folds out over the corners.
+      f32 x{normal.x / length};
+      f32 y{normal.y / length};
+
+      if (normal.z < 0.f) {
+	f32 const foldedX{(1.f - std::abs(y)) * (x >= 0.f ? 1.f : -1.f)};
+	f32 const foldedY{(1.f - std::abs(x)) * (y >= 0.f ? 1.f : -1.f)};
+
+	x = foldedX;
+	y = foldedY;
+      }
+
+      encoded[0] = static_cast<i16>(std::round(std::clamp(x, -1.f, 1.f) * kSnormMax));
+      encoded[1] = static_cast<i16>(std::round(std::clamp(y, -1.f, 1.f) * kSnormMax));
+    }
+
+    glm::vec3 DecodeOctahedral(i16 const encoded[2])
+    {
+      // GL's snorm16: -32768 and -32767 are both -1.
+      f32 const x{std::max(encoded[0] / static_cast<f32>(kSnormMax), -1.f)};
+      f32 const y{std::max(encoded[1] / static_cast<f32>(kSnormMax), -1.f)};
+      glm::vec3 normal{x, y, 1.f - std::abs(x) - std::abs(y)};
+
+      // Unfold the lower half.
+      f32 const t{std::max(-normal.z, 0.f)};
+
+      normal.x += normal.x >= 0.f ? -t : t;
+      normal.y += normal.y >= 0.f ? -t : t;
+
+      return glm::normalize(normal);
+    }
+  };
+};
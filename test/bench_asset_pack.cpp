@@ -0,0 +1,152 @@
+#include "l_asset_pack.h"
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace lain;
+
+//
+// Packs a few hundred small files, checks they come back intact, then measures
+// opening and reading all of them as loose files (ifstream, like the loaders
+// used to, and mmap) vs. out of the mounted pack.
+//
+static u64 Touch(std::byte const* data, std::size_t size)
+{
+    u64 sum{0};
+
+    for (std::size_t i{0}; i < size; i += 64) {
+	sum += static_cast<u64>(data[i]);
+    }
+
+    return sum;
+}
+
+int main()
+{
+    u32 constexpr kFileCount{500};
+
+    // Caches mirror their source's path, same named sources in different directories don't share one.
+    assert(asset_pack::GetCachePath("./res/cache", "res/models/props/repo.obj") == "./res/cache/models/props/repo.obj");
+    assert(asset_pack::GetCachePath("./res/cache", "./res/models/other/../props/repo.obj")
+	   == asset_pack::GetCachePath("./res/cache", "res/models/props/repo.obj"));
+    assert(asset_pack::GetCachePath("./res/cache", "res/models/other/repo.obj")
+	   != asset_pack::GetCachePath("./res/cache", "res/models/props/repo.obj"));
+    assert(asset_pack::GetCachePath("./res/cache", "/tmp/../../wall.png") == "./res/cache/wall.png");
+
+    std::filesystem::path const directory{"bench_asset_pack"};
+    std::filesystem::path const pack{"bench_asset_pack.pak"};
+    std::filesystem::create_directories(directory / "nested");
+
+    std::mt19937 rng{1337};
+    std::uniform_int_distribution<u32> size{1, 64 * 1024};
+    std::vector<std::filesystem::path> files;
+    std::vector<asset_pack::pack_input> inputs;
+
+    for (u32 i{0}; i < kFileCount; ++i) {
+	files.push_back(directory / (i % 2 == 0 ? "nested" : "") / ("asset_" + std::to_string(i) + ".bin"));
+
+	std::string contents(size(rng), '\0');
+	for (auto& c : contents) {
+	    c = static_cast<char>(rng());
+	}
+
+	std::ofstream(files.back(), std::ios::binary) << contents;
+	inputs.emplace_back(asset_pack::NormaliseName(files.back()), files.back());
+    }
+
+    assert(asset_pack::Write(pack, inputs));
+
+    // Nothing mounted yet: Open is a plain mmap of the loose file.
+    assert(!asset_pack::IsMounted());
+
+    using clock = std::chrono::steady_clock;
+    u64 expected{0};
+
+    auto start = clock::now();
+    for (auto const& file : files) {
+	std::ifstream in(file, std::ios::binary);
+	std::stringstream contents;
+	contents << in.rdbuf();
+	std::string const bytes{contents.str()};
+	expected += Touch(reinterpret_cast<std::byte const*>(bytes.data()), bytes.size());
+    }
+    double const ifstreamMs{std::chrono::duration<double, std::milli>(clock::now() - start).count()};
+
+    u64 sum{0};
+
+    start = clock::now();
+    for (auto const& file : files) {
+	mapped_file mapped;
+	assert(asset_pack::Open(file, mapped));
+	sum += Touch(mapped._data, mapped._size);
+	asset_pack::Close(mapped);
+    }
+    double const mmapMs{std::chrono::duration<double, std::milli>(clock::now() - start).count()};
+
+    assert(sum == expected);
+
+    // Same bytes out of the pack, with "./" in front to check names get normalised.
+    sum = 0;
+
+    start = clock::now();
+    assert(asset_pack::Mount(pack));
+    for (auto const& file : files) {
+	mapped_file mapped;
+	assert(asset_pack::Open(std::filesystem::path{"."} / file, mapped));
+	assert(reinterpret_cast<std::uintptr_t>(mapped._data) % asset_pack::kAlignment == 0);
+	sum += Touch(mapped._data, mapped._size);
+	asset_pack::Close(mapped);
+    }
+    double const packMs{std::chrono::duration<double, std::milli>(clock::now() - start).count()};
+
+    assert(sum == expected);
+
+    // Whatever isn't packed still comes from disk.
+    {
+	std::ofstream("bench_asset_pack_loose.txt") << "loose";
+
+	mapped_file mapped;
+	assert(asset_pack::Open("bench_asset_pack_loose.txt", mapped) && mapped._size == 5);
+	asset_pack::Close(mapped);
+
+	std::filesystem::remove("bench_asset_pack_loose.txt");
+    }
+
+    asset_pack::Unmount();
+
+    // Not a pack.
+    assert(!asset_pack::Mount(files[0]));
+
+    // A valid header with an entry running past the end of the file.
+    {
+	std::ifstream in(pack, std::ios::binary);
+	std::string bytes{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+	u64 tocOffset;
+
+	std::memcpy(&tocOffset, bytes.data() + 16, sizeof(tocOffset)); // after magic, version, count and padding
+	u64 const size{bytes.size()};
+	std::memcpy(bytes.data() + tocOffset + 8, &size, sizeof(size)); // the first entry's size
+
+	std::ofstream("bench_asset_pack_corrupt.pak", std::ios::binary) << bytes;
+
+	assert(!asset_pack::Mount("bench_asset_pack_corrupt.pak") && !asset_pack::IsMounted());
+
+	std::filesystem::remove("bench_asset_pack_corrupt.pak");
+    }
+
+    std::filesystem::remove_all(directory);
+    std::filesystem::remove(pack);
+
+    std::cout << kFileCount << " files: ifstream " << ifstreamMs << " ms, mmap " << mmapMs << " ms, pack "
+	      << packMs << " ms (including mounting)\n";
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "l_culling.h"
+#include "glm/ext/matrix_clip_space.hpp"
+#include "glm/ext/matrix_transform.hpp"
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+using namespace lain;
+
+//
+// CPU only, no GL context needed. Scatters boxes around the camera and measures
+// how long it takes to cull them with the SSE path vs. the scalar one.
+//
+int main()
+{
+    u32 constexpr kBoxCount{100000};
+    u32 constexpr kIterations{100};
+
+    // Same projection the render system uses.
+    glm::mat4 const projection{glm::perspective(glm::radians(45.f), 16.f / 9.f, 0.1f, 1000.f)};
+    glm::mat4 const view{glm::lookAt(glm::vec3(0.f, 2.f, 0.f), glm::vec3(0.f, 2.f, -1.f), glm::vec3(0.f, 1.f, 0.f))};
+    culling::frustum const frustum{culling::ExtractFrustum(projection * view)};
+
+    std::mt19937 rng{1337};
+    std::uniform_real_distribution<f32> position{-1200.f, 1200.f};
+    std::uniform_real_distribution<f32> size{0.1f, 5.f};
+
+    culling::bounds_soa bounds;
+
+    for (u32 i{0}; i < kBoxCount; ++i) {
+	glm::vec3 const min{position(rng), position(rng) * 0.1f, position(rng)};
+	glm::vec3 const max{min + glm::vec3(size(rng), size(rng), size(rng))};
+	culling::AddBounds(bounds, aabb{min, max});
+    }
+
+    // Sanity checks: in front of the camera is visible, behind it and past the far plane isn't.
+    {
+	culling::bounds_soa known;
+	culling::AddBounds(known, aabb{glm::vec3(-1.f, 1.f, -11.f), glm::vec3(1.f, 3.f, -9.f)});
+	culling::AddBounds(known, aabb{glm::vec3(-1.f, 1.f, 9.f), glm::vec3(1.f, 3.f, 11.f)});
+	culling::AddBounds(known, aabb{glm::vec3(-1.f, 1.f, -1100.f), glm::vec3(1.f, 3.f, -1050.f)});
+	culling::AddBounds(known, aabb{glm::vec3(-1.f, -1.f, -0.5f), glm::vec3(1.f, 5.f, 0.05f)}); // straddles near
+	culling::AddBounds(known, aabb{glm::vec3(500.f, 1.f, -11.f), glm::vec3(501.f, 3.f, -9.f)});
+
+	std::vector<u32> visible;
+	culling::CullBounds(frustum, known, visible);
+
+	assert(visible.size() == 2 && visible[0] == 0 && visible[1] == 3);
+    }
+
+    std::vector<u32> visibleSimd, visibleScalar;
+    culling::cull_stats stats{};
+
+    using clock = std::chrono::steady_clock;
+
+    auto start = clock::now();
+    for (u32 i{0}; i < kIterations; ++i) {
+	stats = culling::CullBoundsScalar(frustum, bounds, visibleScalar);
+    }
+    auto const scalarTime = std::chrono::duration<f32, std::micro>(clock::now() - start).count() / kIterations;
+
+    start = clock::now();
+    for (u32 i{0}; i < kIterations; ++i) {
+	stats = culling::CullBounds(frustum, bounds, visibleSimd);
+    }
+    auto const simdTime = std::chrono::duration<f32, std::micro>(clock::now() - start).count() / kIterations;
+
+    assert(visibleSimd == visibleScalar && "SSE and scalar culling disagree");
+
+    std::cout << "boxes: " << stats._tested << ", visible: " << stats._visible << ", culled: " << stats._culled << '\n';
+    std::cout << "scalar: " << scalarTime << " us/frame\n";
+    std::cout << "sse:    " << simdTime << " us/frame (" << scalarTime / simdTime << "x)\n";
+
+    return 0;
+}
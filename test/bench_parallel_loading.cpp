@@ -0,0 +1,122 @@
+#include "l_mesh_cache.h"
+#include "l_thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+using namespace lain;
+
+//
+// The CPU side of what resource_manager::Initialise does: reads a pile of baked
+// models and decodes a pile of images on the thread pool, with 1 worker up to
+// one per core. No GL, so the uploads the main thread does are left out.
+//
+int main()
+{
+    u32 constexpr kModelCount{64};
+    u32 constexpr kVerticesPerModel{20'000};
+    u32 constexpr kTextureCount{64};
+    i32 constexpr kTextureSize{512};
+    u64 constexpr kHash{42};
+
+    std::filesystem::path const directory{"./bench_parallel_loading"};
+    std::filesystem::create_directories(directory);
+
+    std::vector<std::filesystem::path> models;
+    std::vector<std::filesystem::path> textures;
+
+    {
+	mesh_data mesh{};
+
+	for (u32 i{0}; i < kVerticesPerModel; ++i) {
+	    f32 const f{static_cast<f32>(i)};
+	    mesh._vertices.push_back(vertex_data{glm::vec3(f), glm::vec3(0.f, 1.f, 0.f), glm::vec2(f)});
+	    mesh._indices.push_back(i);
+	}
+
+	for (u32 i{0}; i < kModelCount; ++i) {
+	    models.push_back(directory / ("model_" + std::to_string(i) + ".lmesh"));
+	    assert(mesh_cache::Write(models.back(), kHash, {mesh}));
+	}
+    }
+
+    // Binary PPM, stb_image reads those and they're trivial to write.
+    for (u32 i{0}; i < kTextureCount; ++i) {
+	textures.push_back(directory / ("texture_" + std::to_string(i) + ".ppm"));
+
+	std::ofstream out(textures.back(), std::ios::binary);
+	out << "P6\n" << kTextureSize << ' ' << kTextureSize << "\n255\n";
+
+	for (i32 p{0}; p < kTextureSize * kTextureSize; ++p) {
+	    char const rgb[3] = {static_cast<char>(p), static_cast<char>(p >> 8), static_cast<char>(i)};
+	    out.write(rgb, 3);
+	}
+    }
+
+    // 1, 2, 4... and the core count itself.
+    u32 const cores{std::max(std::thread::hardware_concurrency(), 1u)};
+    std::vector<u32> threadCounts;
+
+    for (u32 threads{1}; threads < cores; threads *= 2) {
+	threadCounts.push_back(threads);
+    }
+
+    threadCounts.push_back(cores);
+
+    for (u32 const threads : threadCounts) {
+	std::atomic<u32> loadedModels{0};
+	std::atomic<u32> loadedTextures{0};
+
+	thread_pool::Initialise(threads);
+
+	using clock = std::chrono::steady_clock;
+	auto const start = clock::now();
+
+	for (auto const& model : models) {
+	    thread_pool::Submit([&model, &loadedModels] {
+		std::vector<mesh_data> meshes;
+
+		if (mesh_cache::Read(model, kHash, meshes) && meshes[0]._vertices.size() == kVerticesPerModel) {
+		    ++loadedModels;
+		}
+	    });
+	}
+
+	for (auto const& texture : textures) {
+	    thread_pool::Submit([&texture, &loadedTextures] {
+		i32 width, height, channels;
+		unsigned char* data{stbi_load(texture.c_str(), &width, &height, &channels, 0)};
+
+		if (data != nullptr && width == kTextureSize && channels == 3) {
+		    ++loadedTextures;
+		}
+
+		stbi_image_free(data);
+	    });
+	}
+
+	thread_pool::Wait();
+
+	double const ms{std::chrono::duration<double, std::milli>(clock::now() - start).count()};
+
+	thread_pool::Shutdown();
+
+	assert(loadedModels == kModelCount && loadedTextures == kTextureCount);
+
+	std::cout << threads << " threads: " << ms << " ms\n";
+    }
+
+    std::filesystem::remove_all(directory);
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include "l_types.h"
+#include "l_pool.h"
+#include "l_shader.h"
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using namespace lain;
+
+//
+// Checks handle reuse and dangling-handle detection, then measures looking a
+// shader up through a pool handle vs. the old unordered_map<i32, unique_ptr>.
+//
+static pool<shader, 1024> _pool;
+
+int main()
+{
+    // Reuse: the slot comes back, the old handle doesn't.
+    {
+	pool<shader, 4> small;
+
+	auto const a = small.Create(1u);
+	auto const b = small.Create(2u);
+
+	assert(small.GetCount() == 2);
+	assert(small.Get(a)->_id == 1 && small.Get(b)->_id == 2);
+
+	assert(small.Destroy(a));
+	assert(small.Get(a) == nullptr);
+	assert(!small.Destroy(a));
+
+	auto const c = small.Create(3u);
+
+	assert(c._index == a._index && c._generation != a._generation);
+	assert(small.Get(a) == nullptr);
+	assert(small.Get(c)->_id == 3);
+	assert(small.Get(handle<shader>{}) == nullptr);
+
+	u32 visited{0};
+	small.ForEach([&](handle<shader>, shader& s) { visited += s._id; });
+	assert(visited == 5);
+
+	small.Clear();
+	assert(small.GetCount() == 0 && small.Get(b) == nullptr && small.Get(c) == nullptr);
+    }
+
+    u32 constexpr kShaderCount{1024};
+    u32 constexpr kLookups{10'000'000};
+
+    std::unordered_map<i32, std::unique_ptr<shader>> map;
+    std::vector<i32> ids;
+    std::vector<handle<shader>> handles;
+
+    // Ids are hashes of names in the game, spread them the same way.
+    std::mt19937 rng{1337};
+
+    for (u32 i{0}; i < kShaderCount; ++i) {
+	i32 const id{static_cast<i32>(rng())};
+
+	map[id] = std::make_unique<shader>(i);
+	ids.push_back(id);
+	handles.push_back(_pool.Create(i));
+    }
+
+    std::vector<u32> order(kLookups);
+    std::uniform_int_distribution<u32> pick{0, kShaderCount - 1};
+
+    for (auto& o : order) {
+	o = pick(rng);
+    }
+
+    using clock = std::chrono::steady_clock;
+
+    u64 mapSum{0};
+    auto start = clock::now();
+    for (u32 const o : order) {
+	mapSum += map.at(ids[o])->_id;
+    }
+    double const mapNs{std::chrono::duration<double, std::nano>(clock::now() - start).count() / kLookups};
+
+    u64 poolSum{0};
+    start = clock::now();
+    for (u32 const o : order) {
+	poolSum += _pool.Get(handles[o])->_id;
+    }
+    double const poolNs{std::chrono::duration<double, std::nano>(clock::now() - start).count() / kLookups};
+
+    assert(mapSum == poolSum);
+
+    std::cout << "unordered_map::at: " << mapNs << " ns, pool handle: " << poolNs << " ns\n";
+
+    return 0;
+}
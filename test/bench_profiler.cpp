@@ -0,0 +1,80 @@
+#define LAIN_PROFILER
+#include "l_profiler.h"
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+using namespace lain;
+
+//
+// Checks that zones of a frame are collected with the right nesting, that
+// other threads get their own ring, and measures what a zone costs.
+//
+static void Leaf()
+{
+    LAIN_PROFILE_ZONE("Leaf");
+}
+
+int main()
+{
+    profiler::BeginFrame();
+
+    {
+	LAIN_PROFILE_ZONE("Outer");
+	Leaf();
+	Leaf();
+    }
+
+    std::thread worker([] {
+	LAIN_PROFILE_ZONE("Worker");
+    });
+    worker.join();
+
+    profiler::BeginFrame();
+
+    auto const& zones = profiler::GetLastFrame();
+
+    assert(zones.size() == 4);
+    assert(std::strcmp(zones[0]._name, "Outer") == 0 && zones[0]._depth == 0);
+    assert(std::strcmp(zones[1]._name, "Leaf") == 0 && zones[1]._depth == 1);
+    assert(std::strcmp(zones[2]._name, "Leaf") == 0 && zones[2]._depth == 1);
+    assert(zones[1]._end <= zones[2]._start);
+    assert(zones[0]._start <= zones[1]._start && zones[2]._end <= zones[0]._end);
+    assert(std::strcmp(zones[3]._name, "Worker") == 0 && zones[3]._thread != zones[0]._thread);
+
+    // Next frame is empty.
+    profiler::BeginFrame();
+    assert(profiler::GetLastFrame().empty());
+
+    // Cost of a zone, this wraps the ring many times over.
+    u32 constexpr kIterations{10'000'000};
+
+    using clock = std::chrono::steady_clock;
+
+    auto start = clock::now();
+    for (u32 i{0}; i < kIterations; ++i) {
+	Leaf();
+    }
+    double const ns{std::chrono::duration<double, std::nano>(clock::now() - start).count() / kIterations};
+
+    std::filesystem::path const file{std::filesystem::temp_directory_path() / "bench_profiler.json"};
+
+    assert(profiler::ExportChromeTrace(file));
+
+    std::stringstream contents;
+    contents << std::ifstream(file).rdbuf();
+
+    std::filesystem::remove(file);
+
+    assert(contents.str().find("\"traceEvents\"") != std::string::npos);
+    assert(contents.str().find("\"name\":\"Leaf\"") != std::string::npos);
+
+    std::cout << "zone: " << ns << " ns\n";
+
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include "l_texture_cache.h"
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+using namespace lain;
+using texture_cache::texture_format;
+
+//
+// The CPU side of loading a pile of textures: decoding the source images like
+// the loader used to, baking them the first time, and reading the baked files
+// on every launch after that. No GL, so the numbers leave out the upload
+// itself and glGenerateMipmap, which the old path also paid for. The bytes
+// handed to GL (and roughly the VRAM) are printed for each format.
+//
+int main()
+{
+    u32 constexpr kTextureCount{32};
+    i32 constexpr kTextureSize{512};
+
+    std::filesystem::path const directory{"./bench_texture_cache"};
+    std::filesystem::create_directories(directory);
+
+    std::vector<std::filesystem::path> sources;
+
+    // Binary PPM, stb_image reads those and they're trivial to write.
+    for (u32 i{0}; i < kTextureCount; ++i) {
+	sources.push_back(directory / ("texture_" + std::to_string(i) + ".ppm"));
+
+	std::ofstream out(sources.back(), std::ios::binary);
+	out << "P6\n" << kTextureSize << ' ' << kTextureSize << "\n255\n";
+
+	for (i32 y{0}; y < kTextureSize; ++y) {
+	    for (i32 x{0}; x < kTextureSize; ++x) {
+		char const rgb[3] = {static_cast<char>(x), static_cast<char>(y), static_cast<char>(i * 8 + (x ^ y) % 16)};
+		out.write(rgb, 3);
+	    }
+	}
+    }
+
+    using clock = std::chrono::steady_clock;
+
+    // What every launch used to do.
+    u64 decodedBytes{0};
+    auto start = clock::now();
+
+    for (auto const& source : sources) {
+	i32 width, height, channels;
+	unsigned char* data{stbi_load(source.c_str(), &width, &height, &channels, 0)};
+
+	assert(data != nullptr);
+	decodedBytes += static_cast<u64>(width) * height * channels;
+
+	stbi_image_free(data);
+    }
+
+    double const decodeMs{std::chrono::duration<double, std::milli>(clock::now() - start).count()};
+
+    // RGB textures end up as RGBA8 on pretty much every driver, plus a third for the mips.
+    u64 const uncompressedVram{static_cast<u64>(kTextureSize) * kTextureSize * 4 * 4 / 3 * kTextureCount};
+
+    std::cout << kTextureCount << " textures, " << kTextureSize << "x" << kTextureSize << "\n";
+    std::cout << "  decode:         " << decodeMs << " ms, " << decodedBytes / 1024 << " KiB uploaded, about "
+	      << uncompressedVram / 1024 << " KiB of VRAM with mips\n";
+
+    for (auto const format : {texture_format::rgba8, texture_format::bc1, texture_format::bc7}) {
+	std::vector<std::filesystem::path> caches;
+
+	// First launch: decode, build the mips, encode, write.
+	start = clock::now();
+
+	for (auto const& source : sources) {
+	    i32 width, height, channels;
+	    unsigned char* data{stbi_load(source.c_str(), &width, &height, &channels, 4)};
+
+	    assert(data != nullptr);
+
+	    texture_cache::baked_texture baked;
+	    u64 const hash{texture_cache::HashSource(source, false)};
+
+	    caches.push_back(directory / (source.stem().string() + "_" + std::to_string(static_cast<u32>(format)) + ".ltex"));
+
+	    assert(texture_cache::Bake(data, width, height, channels, format, hash, baked));
+	    assert(texture_cache::Write(caches.back(), baked));
+
+	    texture_cache::Release(baked);
+	    stbi_image_free(data);
+	}
+
+	double const bakeMs{std::chrono::duration<double, std::milli>(clock::now() - start).count()};
+
+	// Every launch after: hash the source, map the cache and read every level like the upload does.
+	u64 uploadedBytes{0};
+	u64 sum{0};
+
+	start = clock::now();
+
+	for (u32 i{0}; i < kTextureCount; ++i) {
+	    texture_cache::baked_texture baked;
+
+	    assert(texture_cache::Read(caches[i], texture_cache::HashSource(sources[i], false), baked));
+
+	    for (u32 level{0}; level < baked._levelCount; ++level) {
+		std::byte const* data{baked.GetLevelData(level)};
+
+		for (u64 offset{0}; offset < baked._levels[level]._size; offset += 64) {
+		    sum += static_cast<u64>(data[offset]);
+		}
+
+		uploadedBytes += baked._levels[level]._size;
+	    }
+
+	    texture_cache::Release(baked);
+	}
+
+	double const readMs{std::chrono::duration<double, std::milli>(clock::now() - start).count()};
+
+	char const* const names[] = {"rgba8", "bc1", "bc3", "bc7"};
+
+	std::cout << "  " << names[static_cast<u32>(format)] << ": bake " << bakeMs << " ms, read " << readMs << " ms, "
+		  << uploadedBytes / 1024 << " KiB uploaded and in VRAM (" << sum % 2 << ")\n";
+    }
+
+    std::filesystem::remove_all(directory);
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "l_mesh.h"
+#include "l_types.h"
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace lain
+{
+  // ---------------------------------------------------------------------------
+  // Reads the game's OBJ models for the tests the way Assimp hands them over:
+  // one vertex per face corner, indices in file order. Triangles only, which
+  // is all the models have. Paths are relative to the repository root.
+  // ---------------------------------------------------------------------------
+  namespace test_obj
+  {
+    // A new mesh starts at every material, the way Assimp splits them.
+    inline std::vector<mesh_data> LoadMeshes(char const* path)
+    {
+      std::ifstream in(path);
+      assert(in && "run from the repository root");
+
+      std::vector<glm::vec3> positions, normals;
+      std::vector<glm::vec2> texCoords;
+      std::vector<mesh_data> meshes(1);
+      std::string line;
+
+      while (std::getline(in, line)) {
+	std::istringstream tokens(line);
+	std::string type;
+	tokens >> type;
+
+	if (type == "v") {
+	  glm::vec3 p;
+	  tokens >> p.x >> p.y >> p.z;
+	  positions.push_back(p);
+	} else if (type == "vn") {
+	  glm::vec3 n;
+	  tokens >> n.x >> n.y >> n.z;
+	  normals.push_back(n);
+	} else if (type == "vt") {
+	  glm::vec2 t;
+	  tokens >> t.x >> t.y;
+	  texCoords.push_back(t);
+	} else if (type == "usemtl") {
+	  if (!meshes.back()._indices.empty()) {
+	    meshes.emplace_back();
+	  }
+	} else if (type == "f") {
+	  std::string corner;
+
+	  while (tokens >> corner) {
+	    i32 v{0}, t{0}, n{0};
+
+	    if (std::sscanf(corner.c_str(), "%d/%d/%d", &v, &t, &n) != 3) {
+	      t = 0;
+	      std::sscanf(corner.c_str(), "%d//%d", &v, &n);
+	    }
+
+	    vertex_data vertex{positions[v - 1], glm::vec3(0.f), glm::vec2(0.f)};
+
+	    if (n > 0) {
+	      vertex._normal = normals[n - 1];
+	    }
+
+	    if (t > 0) {
+	      vertex._texCoords = texCoords[t - 1];
+	    }
+
+	    meshes.back()._indices.push_back(static_cast<u32>(meshes.back()._vertices.size()));
+	    meshes.back()._vertices.push_back(vertex);
+	  }
+	}
+      }
+
+      return meshes;
+    }
+
+    // The whole file as one mesh, materials ignored.
+    inline mesh_data Load(char const* path)
+    {
+      std::vector<mesh_data> meshes{LoadMeshes(path)};
+      mesh_data mesh{};
+
+      for (auto& part : meshes) {
+	u32 const first{static_cast<u32>(mesh._vertices.size())};
+
+	for (u32 const index : part._indices) {
+	  mesh._indices.push_back(first + index);
+	}
+
+	mesh._vertices.insert(mesh._vertices.end(), part._vertices.begin(), part._vertices.end());
+      }
+
+      return mesh;
+    }
+  };
+};
@@ -0,0 +1,255 @@
+#include "l_cluster.h"
+#include "l_mesh_optimiser.h"
+#include "l_test_obj.h"
+#include "glm/ext/matrix_clip_space.hpp"
+#include "glm/ext/matrix_transform.hpp"
+#include "glm/geometric.hpp"
+#include "glm/matrix.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace lain;
+
+//
+// Splits the game's models into clusters and checks they cover level 0
+// exactly once, stay within the limits and that their spheres and cones
+// really bound them. Then checks the back facing test never drops a cluster
+// with a triangle facing the camera, and counts the clusters that survive
+// from a few viewpoints. Run from the repository root.
+//
+
+static std::array<u32, 3> GetTriangle(std::vector<u32> const& indices, u32 first)
+{
+    // Rotated so the smallest index comes first, keeps the winding.
+    std::array<u32, 3> triangle{indices[first], indices[first + 1], indices[first + 2]};
+    std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+
+    return triangle;
+}
+
+static void CheckClusters(mesh_data const& before, mesh_data const& mesh)
+{
+    // Every triangle still there once, with the same winding, and the clusters back to back.
+    std::vector<std::array<u32, 3>> original, clustered;
+
+    for (u32 i{0}; i < before._indices.size(); i += 3) {
+	original.push_back(GetTriangle(before._indices, i));
+	clustered.push_back(GetTriangle(mesh._indices, i));
+    }
+
+    std::sort(original.begin(), original.end());
+    std::sort(clustered.begin(), clustered.end());
+    assert(original == clustered);
+
+    u32 next{0};
+
+    for (auto const& cluster : mesh._clusters) {
+	assert(cluster._firstIndex == next);
+	assert(cluster._indexCount > 0 && cluster._indexCount % 3 == 0 && cluster._indexCount <= cluster::kMaxTriangles * 3);
+	next += cluster._indexCount;
+
+	std::vector<u32> vertices(mesh._indices.begin() + cluster._firstIndex, mesh._indices.begin() + next);
+	std::sort(vertices.begin(), vertices.end());
+	assert(std::unique(vertices.begin(), vertices.end()) - vertices.begin() <= cluster::kMaxVertices);
+
+	f32 const tolerance{1e-4f * (1.f + cluster._radius)};
+	f32 const minDot{std::sqrt(1.f - cluster._coneCutoff * cluster._coneCutoff)};
+
+	for (u32 i{cluster._firstIndex}; i < next; i += 3) {
+	    glm::vec3 const& a{mesh._vertices[mesh._indices[i]]._position};
+	    glm::vec3 const& b{mesh._vertices[mesh._indices[i + 1]]._position};
+	    glm::vec3 const& c{mesh._vertices[mesh._indices[i + 2]]._position};
+
+	    for (glm::vec3 const& p : {a, b, c}) {
+		assert(glm::length(p - cluster._centre) <= cluster._radius + tolerance);
+	    }
+
+	    glm::vec3 const normal{glm::cross(b - a, c - a)};
+
+	    if (cluster._coneCutoff < 1.f && glm::length(normal) > 0.f) {
+		assert(glm::dot(glm::normalize(normal), cluster._coneAxis) >= minDot - 1e-4f);
+	    }
+	}
+    }
+
+    assert(next == mesh._indices.size());
+}
+
+static std::array<f32, 9> GetTrianglePositions(mesh_data const& mesh, u32 first)
+{
+    // Rotated so the smallest position comes first, vertex indices change when they're reordered.
+    std::array<std::array<f32, 3>, 3> corners;
+
+    for (u32 corner{0}; corner < 3; ++corner) {
+	glm::vec3 const& p{mesh._vertices[mesh._indices[first + corner]]._position};
+	corners[corner] = {p.x, p.y, p.z};
+    }
+
+    std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+
+    return {corners[0][0], corners[0][1], corners[0][2], corners[1][0], corners[1][1], corners[1][2],
+	    corners[2][0], corners[2][1], corners[2][2]};
+}
+
+static void CheckOptimised(mesh_data const& clustered, mesh_data const& mesh)
+{
+    assert(mesh._clusters.size() == clustered._clusters.size());
+
+    for (u32 c{0}; c < mesh._clusters.size(); ++c) {
+	mesh_cluster const& cluster{mesh._clusters[c]};
+	std::vector<std::array<f32, 9>> before, after;
+
+	assert(cluster._firstIndex == clustered._clusters[c]._firstIndex && cluster._indexCount == clustered._clusters[c]._indexCount);
+
+	for (u32 i{cluster._firstIndex}; i < cluster._firstIndex + cluster._indexCount; i += 3) {
+	    before.push_back(GetTrianglePositions(clustered, i));
+	    after.push_back(GetTrianglePositions(mesh, i));
+	}
+
+	std::sort(before.begin(), before.end());
+	std::sort(after.begin(), after.end());
+	assert(before == after);
+    }
+
+    u32 const vertexCount{static_cast<u32>(mesh._vertices.size())};
+    f32 const acmrBefore{mesh_optimiser::AnalyseVertexCache(clustered._indices, static_cast<u32>(clustered._vertices.size()))._acmr};
+    f32 const acmrAfter{mesh_optimiser::AnalyseVertexCache(mesh._indices, vertexCount)._acmr};
+
+    assert(acmrAfter <= acmrBefore);
+}
+
+// Back facing means every triangle in it is, seen from anywhere around the mesh.
+static void CheckBackFacing(mesh_data const& mesh, f32 distance)
+{
+    std::mt19937 random{7};
+    std::uniform_real_distribution<f32> coordinate{-1.f, 1.f};
+    glm::vec3 const centre{(mesh._boundingBox._min + mesh._boundingBox._max) * 0.5f};
+
+    for (u32 sample{0}; sample < 200; ++sample) {
+	glm::vec3 const direction{glm::normalize(glm::vec3(coordinate(random), coordinate(random), coordinate(random)))};
+	glm::vec3 const camera{centre + direction * distance * (0.5f + coordinate(random) * 0.4f + 0.5f)};
+
+	for (auto const& cluster : mesh._clusters) {
+	    if (!cluster::IsBackFacing(cluster, camera)) {
+		continue;
+	    }
+
+	    for (u32 i{cluster._firstIndex}; i < cluster._firstIndex + cluster._indexCount; i += 3) {
+		glm::vec3 const& a{mesh._vertices[mesh._indices[i]]._position};
+		glm::vec3 const& b{mesh._vertices[mesh._indices[i + 1]]._position};
+		glm::vec3 const& c{mesh._vertices[mesh._indices[i + 2]]._position};
+
+		assert(glm::dot(glm::cross(b - a, c - a), a - camera) >= -1e-5f);
+	    }
+	}
+    }
+}
+
+static std::vector<mesh_data> BuildClusters(char const* path)
+{
+    std::vector<mesh_data> meshes{test_obj::LoadMeshes(path)};
+
+    for (auto& mesh : meshes) {
+	mesh_optimiser::WeldVertices(mesh);
+	mesh_optimiser::OptimiseVertexCache(mesh._indices, static_cast<u32>(mesh._vertices.size()));
+
+	glm::vec3 min{mesh._vertices[0]._position}, max{min};
+
+	for (auto const& vertex : mesh._vertices) {
+	    min = glm::min(min, vertex._position);
+	    max = glm::max(max, vertex._position);
+	}
+
+	mesh._boundingBox = aabb{min, max};
+
+	mesh_data const before{mesh};
+	cluster::Build(mesh);
+	CheckClusters(before, mesh);
+
+	// Ordered for the GPU within each cluster, the clusters stay what they were.
+	mesh_data const clustered{mesh};
+	mesh_optimiser::Optimise(mesh);
+	CheckOptimised(clustered, mesh);
+	CheckBackFacing(mesh, glm::length(max - min));
+    }
+
+    return meshes;
+}
+
+// What a camera there keeps, with and without the back facing test. Returns the clusters it dropped for facing away.
+static u32 CountSurvivors(char const* name, std::vector<mesh_data> const& meshes, glm::vec3 const& camera, glm::vec3 const& target)
+{
+    glm::mat4 const projection{glm::perspective(glm::radians(45.f), 16.f / 9.f, 0.1f, 1000.f)};
+    glm::mat4 const viewProjection{projection * glm::lookAt(camera, target, glm::vec3(0.f, 1.f, 0.f))};
+    culling::frustum const frustum{culling::ExtractFrustum(viewProjection)};
+    u32 clusters{0}, inFrustum{0}, visible{0}, triangles{0}, visibleTriangles{0};
+    std::vector<u32> survivors;
+
+    for (auto const& mesh : meshes) {
+	culling::cull_stats const stats{
+	    cluster::Cull(frustum, camera, mesh._clusters.data(), static_cast<u32>(mesh._clusters.size()), survivors)};
+
+	assert(stats._tested == mesh._clusters.size() && stats._visible == survivors.size());
+
+	for (auto const& cluster : mesh._clusters) {
+	    bool const inside{std::all_of(std::begin(frustum._planes), std::end(frustum._planes), [&](glm::vec4 const& plane) {
+		return glm::dot(glm::vec3(plane), cluster._centre) + plane.w >= -cluster._radius;
+	    })};
+
+	    inFrustum += inside;
+	    triangles += cluster._indexCount / 3;
+	}
+
+	for (u32 const i : survivors) {
+	    visibleTriangles += mesh._clusters[i]._indexCount / 3;
+	}
+
+	clusters += stats._tested;
+	visible += stats._visible;
+    }
+
+    std::cout << "  " << name << ": " << clusters << " clusters, " << inFrustum << " in the frustum, " << visible
+	      << " also facing the camera, triangles " << triangles << " -> " << visibleTriangles << '\n';
+
+    assert(visible <= inFrustum);
+
+    return inFrustum - visible;
+}
+
+int main()
+{
+    // The cone test on its own: a flat cluster facing +z is back facing from behind only.
+    {
+	mesh_cluster const cluster{0, 3, glm::vec3(0.f), 1.f, glm::vec3(0.f, 0.f, 1.f), 0.f};
+
+	assert(!cluster::IsBackFacing(cluster, glm::vec3(0.f, 0.f, 5.f)));
+	assert(cluster::IsBackFacing(cluster, glm::vec3(0.f, 0.f, -5.f)));
+	assert(!cluster::IsBackFacing(cluster, glm::vec3(0.f, 0.f, -0.5f))); // inside the sphere
+	assert(!cluster::IsBackFacing(cluster, glm::vec3(5.f, 0.f, -0.1f))); // edge on
+
+	mesh_cluster const open{0, 3, glm::vec3(0.f), 1.f, glm::vec3(0.f, 0.f, 1.f), 1.f};
+
+	assert(!cluster::IsBackFacing(open, glm::vec3(0.f, 0.f, -5.f)));
+    }
+
+    std::vector<mesh_data> const ball{BuildClusters("./res/models/ball.obj")};
+    std::vector<mesh_data> const maze{BuildClusters("./res/models/maze.obj")};
+
+    // From three radii away two thirds of a sphere face away, whole clusters of those get dropped.
+    std::cout << "ball.obj:\n";
+    u32 const ballBackFacing{CountSurvivors("from the side", ball, glm::vec3(0.f, 0.f, 3.f), glm::vec3(0.f))};
+    CountSurvivors("close up", ball, glm::vec3(0.f, 0.f, 1.5f), glm::vec3(0.f));
+
+    std::cout << "maze.obj:\n";
+    u32 const mazeBackFacing{CountSurvivors("from above", maze, glm::vec3(0.f, 8.f, 6.f), glm::vec3(0.f))};
+    CountSurvivors("inside, looking along a corridor", maze, glm::vec3(0.f, 0.5f, 2.5f), glm::vec3(0.f, 0.5f, -3.f));
+
+    assert(ballBackFacing > 0 && mazeBackFacing > 0);
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include "l_collision_mesh.h"
+#include "l_mesh.h"
+#include "l_mesh_optimiser.h"
+#include "l_test_obj.h"
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+using namespace lain;
+
+//
+// Keeps CPU copies of the game's models the way the loader does and checks
+// they hold the same triangles, then prints what every model kept resident
+// before (the whole mesh) and now (nothing, or positions for collision). Run
+// from the repository root.
+//
+
+static void CheckTriangles(mesh_data const& mesh, collision_mesh::collision_mesh_ref ref)
+{
+    collision_mesh::collision_mesh_view const view{collision_mesh::Get(ref)};
+
+    assert(view._indices.size() == mesh._indices.size());
+    assert(view._positions.size() <= mesh._vertices.size());
+
+    for (u32 i{0}; i < mesh._indices.size(); ++i) {
+	assert(view._indices[i] < view._positions.size());
+	assert(view._positions[view._indices[i]] == mesh._vertices[mesh._indices[i]]._position);
+    }
+}
+
+int main()
+{
+    struct shipped_model final
+    {
+	char const* _path;
+	mesh_residency _residency;
+    };
+
+    // Same flags as res/models/models.manifest.
+    shipped_model const models[] = {
+	{"./res/models/ball.obj", mesh_residency::gpu_only},
+	{"./res/models/maze.obj", mesh_residency::collision},
+    };
+
+    std::vector<mesh_data> meshes;
+    std::vector<collision_mesh::collision_mesh_ref> refs;
+
+    for (auto const& model : models) {
+	mesh_data mesh{test_obj::Load(model._path)};
+
+	// What the cache holds.
+	mesh_optimiser::Optimise(mesh);
+
+	u64 const before{mesh._vertices.size() * sizeof(vertex_data) + mesh._indices.size() * sizeof(u32)};
+	u64 const residentBefore{collision_mesh::GetResidentBytes()};
+
+	if (model._residency == mesh_residency::collision) {
+	    refs.push_back(collision_mesh::Add(mesh._vertices, mesh._indices));
+	    meshes.push_back(mesh);
+	}
+
+	u64 const after{collision_mesh::GetResidentBytes() - residentBefore};
+
+	std::cout << model._path << ": " << mesh._vertices.size() << " vertices, " << mesh._indices.size() / 3 << " triangles, "
+		  << before / 1024 << " -> " << after / 1024 << " KiB resident on the CPU\n";
+    }
+
+    // Every mesh sees its own triangles, whatever was added after it.
+    meshes.push_back(test_obj::Load("./res/models/maze.obj"));
+    refs.push_back(collision_mesh::Add(meshes.back()._vertices, meshes.back()._indices));
+
+    assert(refs[1]._firstPosition == refs[0]._firstPosition + refs[0]._positionCount);
+    assert(refs[1]._firstIndex == refs[0]._firstIndex + refs[0]._indexCount);
+
+    for (u32 i{0}; i < meshes.size(); ++i) {
+	CheckTriangles(meshes[i], refs[i]);
+    }
+
+    // Welding went by position only: the unoptimised copy ends up with as many as the optimised one.
+    assert(refs[1]._positionCount == refs[0]._positionCount);
+
+    return 0;
+}
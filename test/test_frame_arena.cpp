@@ -0,0 +1,82 @@
+#include "l_allocation_tracker.h"
+#include "l_frame_arena.h"
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+using namespace lain;
+
+int main()
+{
+    frame_arena::Initialise(1024);
+
+    // Alignment is respected after odd sized allocations.
+    auto* bytes = frame_arena::AllocateArray<char>(3);
+    auto* doubles = frame_arena::AllocateArray<double>(4);
+
+    assert(bytes != nullptr && doubles != nullptr);
+    assert(reinterpret_cast<std::uintptr_t>(doubles) % alignof(double) == 0);
+    assert(frame_arena::GetBytesUsed() == 8 + 4 * sizeof(double));
+
+    // A new frame starts from the beginning again.
+    frame_arena::BeginFrame();
+    assert(frame_arena::GetBytesUsed() == 0);
+    assert(frame_arena::GetHighWaterMark() == 8 + 4 * sizeof(double));
+    assert(frame_arena::AllocateArray<char>(1) == bytes);
+
+    // Containers in the arena don't touch the heap.
+    allocation_tracker::BeginFrame();
+
+    {
+	std::vector<i32, frame_arena::allocator<i32>> values;
+	values.reserve(16);
+
+	for (i32 i{0}; i < 16; ++i) {
+	    values.push_back(i);
+	}
+    }
+
+    allocation_tracker::BeginFrame();
+
+    auto const& arenaStats = allocation_tracker::GetLastFrameStats();
+    u32 const other{static_cast<u32>(allocation_tracker::tag::other)};
+
+    assert(arenaStats._allocations[other] == 0);
+
+    // Heap allocations are charged to the current tag.
+    {
+	allocation_tracker::scoped_tag const tag{allocation_tracker::tag::render};
+	std::vector<i32> heap(100);
+	assert(heap.size() == 100);
+    }
+
+    allocation_tracker::BeginFrame();
+
+    auto const& heapStats = allocation_tracker::GetLastFrameStats();
+    u32 const render{static_cast<u32>(allocation_tracker::tag::render)};
+
+    assert(heapStats._allocations[render] == 1);
+    assert(heapStats._bytes[render] == 100 * sizeof(i32));
+    assert(heapStats._allocations[other] == 0);
+
+    // Strict mode lets loading allocate, it's counted but not part of the steady state.
+    allocation_tracker::SetStrict(true, 0);
+
+    {
+	allocation_tracker::scoped_tag const tag{allocation_tracker::tag::resources};
+	std::vector<i32> streamed(100);
+	assert(streamed.size() == 100);
+    }
+
+    allocation_tracker::BeginFrame();
+    allocation_tracker::SetStrict(false);
+
+    assert(allocation_tracker::GetLastFrameStats()._allocations[static_cast<u32>(allocation_tracker::tag::resources)] == 1);
+
+    frame_arena::Shutdown();
+
+    std::cout << "frame arena ok\n";
+
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include "l_frame_stats.h"
+#include <cassert>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace lain;
+
+int main()
+{
+    // 1..100 ms, the percentiles are easy to check.
+    for (u32 i{1}; i <= 100; ++i) {
+	f32 const ms{static_cast<f32>(i)};
+	frame_stats::Record({0.f, 0.f, ms, 0.f, ms});
+    }
+
+    auto summary = frame_stats::Summarise();
+
+    assert(summary._count == 100);
+    assert(summary._min == 1.f && summary._max == 100.f);
+    assert(std::abs(summary._average - 50.5f) < 1e-4f);
+    assert(summary._p50 == 51.f);
+    assert(summary._p95 == 95.f);
+    assert(summary._p99 == 99.f);
+    assert(summary._stutters == 0);
+
+    // Wrap the ring: only the newest kCapacity frames are kept, oldest first.
+    frame_stats::Clear();
+
+    for (u32 i{0}; i < frame_stats::kCapacity + 10; ++i) {
+	frame_stats::Record({0.f, 0.f, 0.f, 0.f, 16.f});
+    }
+
+    frame_stats::Record({0.f, 0.f, 0.f, 0.f, 40.f});
+
+    assert(frame_stats::GetFrameCount() == frame_stats::kCapacity);
+    assert(frame_stats::GetFrame(frame_stats::kCapacity - 1)._total == 40.f);
+
+    summary = frame_stats::Summarise();
+
+    assert(summary._p50 == 16.f && summary._max == 40.f);
+    assert(summary._stutters == 1);
+
+    std::filesystem::path const directory{std::filesystem::temp_directory_path()};
+
+    assert(frame_stats::ExportCSV(directory / "test_frame_stats.csv"));
+    assert(frame_stats::Export(directory / "test_frame_stats.json"));
+
+    std::ifstream csv(directory / "test_frame_stats.csv");
+    std::string line;
+    u32 lines{0};
+
+    while (std::getline(csv, line)) {
+	++lines;
+    }
+
+    assert(lines == frame_stats::kCapacity + 1);
+
+    std::filesystem::remove(directory / "test_frame_stats.csv");
+    std::filesystem::remove(directory / "test_frame_stats.json");
+
+    std::cout << "frame stats ok\n";
+
+    return 0;
+}
@@ -0,0 +1,182 @@
+#include "l_lod.h"
+#include "l_mesh_optimiser.h"
+#include "l_test_obj.h"
+#include "glm/geometric.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <numbers>
+#include <vector>
+
+using namespace lain;
+
+//
+// Simplifies a closed sphere and checks the result is still a valid mesh,
+// checks picking a level doesn't flicker at the threshold, then builds the
+// ball's levels and counts the triangles a field of balls submits per frame
+// with and without them. Run from the repository root.
+//
+
+// Subdivided icosahedron with shared vertices, closed and without seams, so nothing is locked.
+static mesh_data MakeSphere(u32 subdivisions)
+{
+    f32 const t{(1.f + std::sqrt(5.f)) * 0.5f};
+    std::vector<glm::vec3> positions{{-1.f, t, 0.f}, {1.f, t, 0.f}, {-1.f, -t, 0.f}, {1.f, -t, 0.f},
+				     {0.f, -1.f, t}, {0.f, 1.f, t}, {0.f, -1.f, -t}, {0.f, 1.f, -t},
+				     {t, 0.f, -1.f}, {t, 0.f, 1.f}, {-t, 0.f, -1.f}, {-t, 0.f, 1.f}};
+    std::vector<u32> indices{0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11, 1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+			     3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9, 4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1};
+
+    for (u32 s{0}; s < subdivisions; ++s) {
+	std::map<std::pair<u32, u32>, u32> midpoints;
+	std::vector<u32> next;
+
+	auto const midpoint = [&](u32 a, u32 b) {
+	    auto const [it, inserted] = midpoints.try_emplace({std::min(a, b), std::max(a, b)}, static_cast<u32>(positions.size()));
+
+	    if (inserted) {
+		positions.push_back((positions[a] + positions[b]) * 0.5f);
+	    }
+
+	    return it->second;
+	};
+
+	for (u32 i{0}; i < indices.size(); i += 3) {
+	    u32 const a{indices[i]}, b{indices[i + 1]}, c{indices[i + 2]};
+	    u32 const ab{midpoint(a, b)}, bc{midpoint(b, c)}, ca{midpoint(c, a)};
+
+	    next.insert(next.end(), {a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca});
+	}
+
+	indices = std::move(next);
+    }
+
+    mesh_data mesh{};
+
+    for (auto const& p : positions) {
+	glm::vec3 const n{glm::normalize(p)};
+	mesh._vertices.push_back(vertex_data{n, n, glm::vec2(0.f)});
+    }
+
+    mesh._indices = std::move(indices);
+
+    return mesh;
+}
+
+// Every index in range, no triangle collapsed to a line.
+static void CheckIndices(std::vector<vertex_data> const& vertices, u32 const* indices, u32 indexCount)
+{
+    assert(indexCount % 3 == 0);
+
+    for (u32 i{0}; i < indexCount; i += 3) {
+	assert(indices[i] < vertices.size() && indices[i + 1] < vertices.size() && indices[i + 2] < vertices.size());
+	assert(indices[i] != indices[i + 1] && indices[i + 1] != indices[i + 2] && indices[i + 2] != indices[i]);
+    }
+}
+
+int main()
+{
+    // A sphere halves as asked, and stops early when the error allowed is tiny.
+    {
+	mesh_data const sphere{MakeSphere(5)};
+	u32 const target{static_cast<u32>(sphere._indices.size() / 6 * 3)};
+	f32 error;
+
+	std::vector<u32> const half{lod::Simplify(sphere._vertices, sphere._indices, target, 1.f, error)};
+
+	CheckIndices(sphere._vertices, half.data(), static_cast<u32>(half.size()));
+	assert(half.size() <= target);
+	assert(error > 0.f && error < 0.01f);
+
+	std::cout << "sphere: " << sphere._indices.size() / 3 << " -> " << half.size() / 3 << " triangles, error " << error << '\n';
+
+	std::vector<u32> const tight{lod::Simplify(sphere._vertices, sphere._indices, 0, 1e-6f, error)};
+
+	assert(tight.size() > target);
+	assert(error <= 1e-6f);
+
+	std::vector<u32> const same{lod::Simplify(sphere._vertices, sphere._indices, static_cast<u32>(sphere._indices.size()), 1.f, error)};
+
+	assert(same == sphere._indices);
+	assert(error == 0.f);
+    }
+
+    // Picking: coarser only once well under a pixel, finer as soon as it's over.
+    {
+	mesh_lod const lods[3]{{0, 300, 0.f}, {300, 150, 0.01f}, {450, 75, 0.04f}};
+
+	assert(lod::Select(lods, 3, 1000.f, 0) == 0); // 10 px
+	assert(lod::Select(lods, 3, 10.f, 0) == 2); // 0.4 px
+	assert(lod::Select(lods, 3, 90.f, 0) == 0); // 0.9 px for level 1, within the hysteresis band
+	assert(lod::Select(lods, 3, 90.f, 1) == 1); // but stays there once it's on it
+	assert(lod::Select(lods, 3, 110.f, 1) == 0); // 1.1 px, back to full detail straight away
+	assert(lod::Select(lods, 3, 24.f, 2) == 2); // 0.96 px
+	assert(lod::Select(lods, 3, 24.f, 1) == 1);
+	assert(lod::Select(lods, 3, 24.f, 9) == 2);
+	assert(lod::Select(lods, 0, 1.f, 0) == 0);
+    }
+
+    // The ball, and a field of 1000 of them from 2 to 200 radii away at 720p and 45 degrees.
+    {
+	std::vector<mesh_data> ball{test_obj::LoadMeshes("./res/models/ball.obj")};
+	glm::vec3 min{FLT_MAX}, max{-FLT_MAX};
+
+	for (auto& mesh : ball) {
+	    mesh_optimiser::Optimise(mesh);
+
+	    u32 const fullCount{static_cast<u32>(mesh._indices.size())};
+
+	    lod::Generate(mesh);
+
+	    assert(!mesh._lods.empty() && mesh._lods.size() <= kMaxLods);
+	    assert(mesh._lods[0]._firstIndex == 0 && mesh._lods[0]._indexCount == fullCount && mesh._lods[0]._error == 0.f);
+
+	    std::cout << "ball mesh: " << mesh._vertices.size() << " vertices, triangles";
+
+	    for (u32 i{0}; i < mesh._lods.size(); ++i) {
+		mesh_lod const& level{mesh._lods[i]};
+
+		assert(level._firstIndex + level._indexCount <= mesh._indices.size());
+		CheckIndices(mesh._vertices, mesh._indices.data() + level._firstIndex, level._indexCount);
+
+		if (i > 0) {
+		    assert(level._indexCount < mesh._lods[i - 1]._indexCount);
+		    assert(level._error >= mesh._lods[i - 1]._error);
+		}
+
+		std::cout << ' ' << level._indexCount / 3 << " (" << level._error << ')';
+	    }
+
+	    std::cout << '\n';
+
+	    for (auto const& vertex : mesh._vertices) {
+		min = glm::min(min, vertex._position);
+		max = glm::max(max, vertex._position);
+	    }
+	}
+
+	f32 const radius{glm::length(max - min) * 0.5f};
+	f32 const pixelsPerUnit{720.f / (2.f * std::tan(std::numbers::pi_v<f32> / 8.f))};
+	u32 constexpr kBalls{1000};
+	u64 full{0}, submitted{0};
+
+	for (u32 i{0}; i < kBalls; ++i) {
+	    f32 const distance{radius * (2.f + 198.f * i / (kBalls - 1))};
+
+	    for (auto const& mesh : ball) {
+		u32 const level{lod::Select(mesh._lods.data(), static_cast<u32>(mesh._lods.size()), pixelsPerUnit / distance, 0)};
+
+		full += mesh._lods[0]._indexCount / 3;
+		submitted += mesh._lods[level]._indexCount / 3;
+	    }
+	}
+
+	std::cout << kBalls << " balls: " << full << " triangles per frame at full detail, " << submitted << " with LODs\n";
+	assert(submitted < full);
+    }
+
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include "l_mesh_cache.h"
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+using namespace lain;
+
+//
+// Bakes a couple of meshes, reads them back and checks that a stale or broken
+// cache is rejected. Also times reading a mesh about the size of the ball.
+//
+static mesh_data MakeMesh(u32 vertexCount, bool textured)
+{
+    mesh_data mesh{};
+
+    for (u32 i{0}; i < vertexCount; ++i) {
+	f32 const f{static_cast<f32>(i)};
+	mesh._vertices.push_back(vertex_data{glm::vec3(f, f + 1.f, f + 2.f), glm::vec3(0.f, 1.f, 0.f), glm::vec2(f * 0.5f, 1.f)});
+	mesh._indices.push_back(vertexCount - 1 - i);
+    }
+
+    if (textured) {
+	mesh._textures.push_back(mesh_texture{7, "textureDiffuse", "Tiled Floor Texture.png"});
+    }
+
+    mesh._boundingBox = aabb{glm::vec3(0.f), glm::vec3(static_cast<f32>(vertexCount))};
+    mesh._diffuseColour = glm::vec3(0.25f, 0.5f, 1.f);
+
+    // A coarser level made of the first half of the indices again.
+    if (vertexCount >= 6) {
+	u32 const levelCount{vertexCount / 6 * 3};
+
+	mesh._lods.push_back(mesh_lod{0, vertexCount, 0.f});
+	mesh._lods.push_back(mesh_lod{vertexCount, levelCount, 0.125f});
+	mesh._indices.insert(mesh._indices.end(), mesh._indices.begin(), mesh._indices.begin() + levelCount);
+
+	// And level 0 in two clusters.
+	mesh._clusters.push_back(mesh_cluster{0, levelCount, glm::vec3(1.f), 2.f, glm::vec3(0.f, 1.f, 0.f), 0.5f});
+	mesh._clusters.push_back(mesh_cluster{levelCount, vertexCount / 3 * 3 - levelCount, glm::vec3(3.f), 4.f, glm::vec3(1.f, 0.f, 0.f), 1.f});
+    }
+
+    return mesh;
+}
+
+int main()
+{
+    std::filesystem::path const file{"./test_mesh_cache.lmesh"};
+    u64 constexpr kHash{0x1234'5678'9abc'def0};
+
+    std::vector<mesh_data> const baked{MakeMesh(3, true), MakeMesh(100, false)};
+
+    assert(mesh_cache::Write(file, kHash, baked));
+
+    std::vector<mesh_data> loaded;
+
+    assert(mesh_cache::Read(file, kHash, loaded));
+    assert(loaded.size() == baked.size());
+
+    for (u32 i{0}; i < baked.size(); ++i) {
+	assert(loaded[i]._vertices.size() == baked[i]._vertices.size());
+	assert(loaded[i]._indices == baked[i]._indices);
+	assert(loaded[i]._boundingBox._max == baked[i]._boundingBox._max);
+	assert(loaded[i]._diffuseColour == baked[i]._diffuseColour);
+	assert(loaded[i]._textures.size() == baked[i]._textures.size());
+	assert(loaded[i]._lods.size() == baked[i]._lods.size());
+
+	for (u32 j{0}; j < baked[i]._lods.size(); ++j) {
+	    assert(loaded[i]._lods[j]._firstIndex == baked[i]._lods[j]._firstIndex);
+	    assert(loaded[i]._lods[j]._indexCount == baked[i]._lods[j]._indexCount);
+	    assert(loaded[i]._lods[j]._error == baked[i]._lods[j]._error);
+	}
+
+	assert(loaded[i]._clusters.size() == baked[i]._clusters.size());
+
+	for (u32 j{0}; j < baked[i]._clusters.size(); ++j) {
+	    assert(loaded[i]._clusters[j]._firstIndex == baked[i]._clusters[j]._firstIndex);
+	    assert(loaded[i]._clusters[j]._indexCount == baked[i]._clusters[j]._indexCount);
+	    assert(loaded[i]._clusters[j]._centre == baked[i]._clusters[j]._centre);
+	    assert(loaded[i]._clusters[j]._coneCutoff == baked[i]._clusters[j]._coneCutoff);
+	}
+
+	for (u32 j{0}; j < baked[i]._vertices.size(); ++j) {
+	    assert(loaded[i]._vertices[j]._position == baked[i]._vertices[j]._position);
+	    assert(loaded[i]._vertices[j]._texCoords == baked[i]._vertices[j]._texCoords);
+	}
+    }
+
+    // Texture ids aren't baked, they belong to this run's GL context.
+    assert(loaded[0]._textures[0]._id == 0);
+    assert(loaded[0]._textures[0]._type == "textureDiffuse");
+    assert(loaded[0]._textures[0]._path == "Tiled Floor Texture.png");
+
+    // A level pointing past the indices.
+    {
+	std::vector<mesh_data> broken{MakeMesh(100, false)};
+	broken[0]._lods[1]._indexCount = 1000;
+
+	assert(mesh_cache::Write(file, kHash, broken));
+	assert(!mesh_cache::Read(file, kHash, loaded));
+
+	// A cluster reaching into the coarser levels.
+	broken = {MakeMesh(100, false)};
+	broken[0]._clusters[1]._indexCount += 3;
+
+	assert(mesh_cache::Write(file, kHash, broken));
+	assert(!mesh_cache::Read(file, kHash, loaded));
+	assert(mesh_cache::Write(file, kHash, baked));
+    }
+
+    // The source changed.
+    assert(!mesh_cache::Read(file, kHash + 1, loaded));
+    assert(loaded.empty());
+
+    // Cut off in the middle of the vertices.
+    std::filesystem::resize_file(file, std::filesystem::file_size(file) - 100);
+    assert(!mesh_cache::Read(file, kHash, loaded));
+
+    assert(!mesh_cache::Read("./does_not_exist.lmesh", kHash, loaded));
+
+    // Hashing notices a single changed byte.
+    {
+	std::filesystem::path const source{"./test_mesh_cache.obj"};
+
+	std::ofstream("./test_mesh_cache.obj") << "v 0 0 0\n";
+	u64 const before{mesh_cache::HashSource(source)};
+	std::ofstream("./test_mesh_cache.obj") << "v 0 0 1\n";
+	assert(mesh_cache::HashSource(source) != before);
+
+	std::filesystem::remove(source);
+    }
+
+    // Roughly what the ball is after triangulation.
+    std::vector<mesh_data> const big{MakeMesh(100'000, false)};
+    assert(mesh_cache::Write(file, kHash, big));
+
+    using clock = std::chrono::steady_clock;
+
+    auto start = clock::now();
+    assert(mesh_cache::Read(file, kHash, loaded));
+    double const ms{std::chrono::duration<double, std::milli>(clock::now() - start).count()};
+
+    std::filesystem::remove(file);
+
+    std::cout << "read " << loaded[0]._vertices.size() << " vertices in " << ms << " ms\n";
+
+    return 0;
+}
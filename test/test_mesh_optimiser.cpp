@@ -0,0 +1,120 @@
+#include "l_mesh_optimiser.h"
+#include "l_test_obj.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace lain;
+
+//
+// Runs the optimiser over the game's models, read the way Assimp hands them
+// over (one vertex per face corner, indices in file order), and prints the
+// vertex cache stats before and after. Also checks no triangle got lost or
+// flipped on the way. Run from the repository root.
+//
+
+// Every triangle as bytes, rotated so the smallest corner is first (keeps the winding), sorted.
+static std::vector<std::string> GetTriangles(mesh_data const& mesh)
+{
+    std::vector<std::string> triangles;
+
+    for (u32 i{0}; i < mesh._indices.size(); i += 3) {
+	std::string corners[3];
+
+	for (u32 j{0}; j < 3; ++j) {
+	    corners[j].assign(reinterpret_cast<char const*>(&mesh._vertices[mesh._indices[i + j]]), sizeof(vertex_data));
+	}
+
+	u32 const first{static_cast<u32>(std::min_element(corners, corners + 3) - corners)};
+	triangles.push_back(corners[first] + corners[(first + 1) % 3] + corners[(first + 2) % 3]);
+    }
+
+    std::sort(triangles.begin(), triangles.end());
+
+    return triangles;
+}
+
+static void Report(char const* name, mesh_data mesh)
+{
+    std::vector<std::string> const triangles{GetTriangles(mesh)};
+    u32 const vertexCount{static_cast<u32>(mesh._vertices.size())};
+    mesh_optimiser::cache_stats const before{mesh_optimiser::AnalyseVertexCache(mesh._indices, vertexCount)};
+
+    using clock = std::chrono::steady_clock;
+
+    auto const start = clock::now();
+    mesh_optimiser::Optimise(mesh);
+    double const ms{std::chrono::duration<double, std::milli>(clock::now() - start).count()};
+
+    mesh_optimiser::cache_stats const after{mesh_optimiser::AnalyseVertexCache(mesh._indices, static_cast<u32>(mesh._vertices.size()))};
+
+    std::cout << name << ": " << mesh._indices.size() / 3 << " triangles, " << vertexCount << " -> " << mesh._vertices.size()
+	      << " vertices, ACMR " << before._acmr << " -> " << after._acmr << ", ATVR " << before._atvr << " -> "
+	      << after._atvr << " (" << ms << " ms)\n";
+
+    assert(GetTriangles(mesh) == triangles);
+    assert(after._acmr < before._acmr);
+
+    // Vertex fetch order: every vertex is first used after the previous one.
+    u32 highest{0};
+
+    for (u32 const index : mesh._indices) {
+	assert(index <= highest);
+	highest = std::max(highest, index + 1);
+    }
+}
+
+int main()
+{
+    // A regular grid, indexed row by row: welding does nothing, the cache order does a lot.
+    {
+	u32 constexpr kSize{64};
+	mesh_data grid{};
+
+	for (u32 y{0}; y <= kSize; ++y) {
+	    for (u32 x{0}; x <= kSize; ++x) {
+		grid._vertices.push_back(vertex_data{glm::vec3(x, 0.f, y), glm::vec3(0.f, 1.f, 0.f), glm::vec2(x, y)});
+	    }
+	}
+
+	for (u32 y{0}; y < kSize; ++y) {
+	    for (u32 x{0}; x < kSize; ++x) {
+		u32 const i{y * (kSize + 1) + x};
+
+		grid._indices.insert(grid._indices.end(), {i, i + kSize + 1, i + 1, i + 1, i + kSize + 1, i + kSize + 2});
+	    }
+	}
+
+	mesh_data welded{grid};
+	assert(mesh_optimiser::WeldVertices(welded) == grid._vertices.size());
+
+	Report("64x64 grid", grid);
+    }
+
+    // Duplicates go, the indices follow them.
+    {
+	mesh_data quad{};
+	vertex_data const corners[] = {
+	    {glm::vec3(0.f, 0.f, 0.f), glm::vec3(0.f, 0.f, 1.f), glm::vec2(0.f, 0.f)},
+	    {glm::vec3(1.f, 0.f, 0.f), glm::vec3(0.f, 0.f, 1.f), glm::vec2(1.f, 0.f)},
+	    {glm::vec3(1.f, 1.f, 0.f), glm::vec3(0.f, 0.f, 1.f), glm::vec2(1.f, 1.f)},
+	    {glm::vec3(0.f, 1.f, 0.f), glm::vec3(0.f, 0.f, 1.f), glm::vec2(0.f, 1.f)},
+	};
+
+	for (u32 const i : {0, 1, 2, 0, 2, 3}) {
+	    quad._indices.push_back(static_cast<u32>(quad._vertices.size()));
+	    quad._vertices.push_back(corners[i]);
+	}
+
+	assert(mesh_optimiser::WeldVertices(quad) == 4);
+	assert((quad._indices == std::vector<u32>{0, 1, 2, 0, 2, 3}));
+    }
+
+    Report("ball.obj", test_obj::Load("./res/models/ball.obj"));
+    Report("maze.obj", test_obj::Load("./res/models/maze.obj"));
+
+    return 0;
+}
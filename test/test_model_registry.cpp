@@ -0,0 +1,149 @@
+#include "l_asset_pack.h"
+#include "l_model_registry.h"
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace lain;
+
+//
+// Fills the registry up with made up paths and checks every id comes back,
+// then registers the game's models (flags from res/models/models.manifest)
+// and a directory with a manifest, loose files and a pack. Ends timing
+// lookups against the unordered_map the models used to be kept in. Run from
+// the repository root.
+//
+int main()
+{
+    // The same model whichever way its path is written.
+    assert(model_registry::GetId("./res/models/ball.obj") == model_registry::GetId("res/models/ball.obj"));
+    assert(model_registry::GetId("res/models/../models/ball.obj") == model_registry::GetId("res/models/ball.obj"));
+    assert(model_registry::GetId("res/models/ball.obj") != model_registry::GetId("res/models/maze.obj"));
+
+    // Full, every one found, nothing else.
+    std::vector<model_id> ids;
+
+    for (u32 i{0}; i < model_registry::kMaxModels; ++i) {
+	std::string const path{"res/models/generated/model_" + std::to_string(i) + ".obj"};
+
+	ids.push_back(model_registry::GetId(path));
+	assert(model_registry::Add({ids.back(), path, "model_" + std::to_string(i), i % 2 == 0, mesh_residency::gpu_only}));
+    }
+
+    assert(model_registry::GetCount() == model_registry::kMaxModels);
+    assert(model_registry::Add({ids[7], "res/models/generated/model_7.obj", "model_7", false, mesh_residency::gpu_only}));
+    assert(!model_registry::Add({ids[7], "res/models/somewhere_else.obj", "x", false, mesh_residency::gpu_only}));
+    assert(!model_registry::Add({model_registry::GetId("res/one_too_many.obj"), "res/one_too_many.obj", "x", false,
+				 mesh_residency::gpu_only}));
+
+    for (u32 i{0}; i < ids.size(); ++i) {
+	model_info const* info{model_registry::Find(ids[i])};
+
+	assert(info != nullptr && info->_id == ids[i] && model_registry::GetIndex(ids[i]) == i);
+	assert(info->_isOccluder == (i % 2 == 0));
+    }
+
+    assert(model_registry::Find(kNoModel) == nullptr);
+    assert(model_registry::Find(model_registry::GetId("res/models/not_there.obj")) == nullptr);
+
+    // Lookups, against what resource_manager used before.
+    {
+	std::unordered_map<model_id, u32> map;
+
+	for (u32 i{0}; i < ids.size(); ++i) {
+	    map[ids[i]] = i;
+	}
+
+	using clock = std::chrono::steady_clock;
+	u32 constexpr kRounds{1000};
+	u64 sum{0};
+
+	auto const start = clock::now();
+
+	for (u32 round{0}; round < kRounds; ++round) {
+	    for (model_id const id : ids) {
+		sum += model_registry::GetIndex(id);
+	    }
+	}
+
+	auto const middle = clock::now();
+
+	for (u32 round{0}; round < kRounds; ++round) {
+	    for (model_id const id : ids) {
+		sum -= map.find(id)->second;
+	    }
+	}
+
+	auto const end = clock::now();
+	double const lookups{static_cast<double>(kRounds) * ids.size()};
+
+	assert(sum == 0);
+
+	std::cout << ids.size() << " models, ns per lookup: registry "
+		  << std::chrono::duration<double, std::nano>(middle - start).count() / lookups << ", unordered_map "
+		  << std::chrono::duration<double, std::nano>(end - middle).count() / lookups << '\n';
+    }
+
+    // The game's models.
+    model_registry::Clear();
+
+    assert(model_registry::GetCount() == 0 && model_registry::Find(ids[0]) == nullptr);
+    assert(model_registry::Load("./res/models"));
+    assert(model_registry::GetCount() == 2);
+
+    model_info const* maze{model_registry::Find(model_registry::GetId("res/models/maze.obj"))};
+    model_info const* ball{model_registry::Find(model_registry::GetId("res/models/ball.obj"))};
+
+    assert(maze != nullptr && maze->_path == "res/models/maze.obj" && maze->_name == "maze");
+    assert(maze->_isOccluder && maze->_residency == mesh_residency::collision);
+    assert(ball != nullptr && ball->_name == "ball");
+    assert(!ball->_isOccluder && ball->_residency == mesh_residency::gpu_only);
+
+    // Saved levels store these, they mustn't change.
+    assert(ball->_id == 803335079 && maze->_id == 1717520085);
+
+    // Nested and packed ones, a bad flag, and things that aren't models.
+    {
+	std::filesystem::path const directory{"test_model_registry"};
+	std::filesystem::path const pack{"test_model_registry.pak"};
+
+	std::filesystem::create_directories(directory / "props");
+	std::ofstream(directory / "models.manifest") << "# comment\n\n  rock.fbx   collision # trailing\r\nprops/crate.glb wobbly\n";
+	std::ofstream(directory / "rock.fbx") << "x";
+	std::ofstream(directory / "props" / "crate.glb") << "x";
+	std::ofstream(directory / "props" / "crate.png") << "x";
+	std::ofstream(directory / "packed.gltf") << "x";
+
+	assert(asset_pack::Write(pack, {{asset_pack::NormaliseName(directory / "packed.gltf"), directory / "packed.gltf"},
+					{asset_pack::NormaliseName(directory / "models.manifest"), directory / "models.manifest"}}));
+	std::filesystem::remove(directory / "packed.gltf");
+	assert(asset_pack::Mount(pack));
+
+	model_registry::Clear();
+
+	assert(!model_registry::Load(directory)); // wobbly
+	assert(model_registry::GetCount() == 3);
+
+	model_info const* rock{model_registry::Find(model_registry::GetId(directory / "rock.fbx"))};
+	model_info const* crate{model_registry::Find(model_registry::GetId(directory / "props" / "crate.glb"))};
+	model_info const* packed{model_registry::Find(model_registry::GetId(directory / "packed.gltf"))};
+
+	assert(rock != nullptr && rock->_residency == mesh_residency::collision && !rock->_isOccluder);
+	assert(crate != nullptr && crate->_name == "props/crate" && crate->_residency == mesh_residency::gpu_only);
+	assert(packed != nullptr && packed->_name == "packed");
+
+	// Manifest order first, then the rest sorted.
+	assert(model_registry::Get(0)._id == rock->_id && model_registry::Get(1)._id == crate->_id);
+
+	asset_pack::Unmount();
+	std::filesystem::remove_all(directory);
+	std::filesystem::remove(pack);
+    }
+
+    return 0;
+}
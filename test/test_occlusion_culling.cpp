@@ -0,0 +1,73 @@
+#include "l_occlusion.h"
+#include "glm/ext/matrix_clip_space.hpp"
+#include "glm/ext/matrix_transform.hpp"
+#include <cassert>
+#include <iostream>
+
+using namespace lain;
+
+int main()
+{
+    glm::mat4 const projection{glm::perspective(glm::radians(45.f), 16.f / 9.f, 0.1f, 1000.f)};
+    glm::mat4 const view{glm::lookAt(glm::vec3(0.f, 1.f, 0.f), glm::vec3(0.f, 1.f, -1.f), glm::vec3(0.f, 1.f, 0.f))};
+
+    occlusion::Initialise(256, 128);
+    occlusion::BeginFrame(projection * view);
+
+    // A wall 5 units in front of the camera.
+    occlusion::RasteriseBox(aabb{glm::vec3(-2.f, 0.f, -5.5f), glm::vec3(2.f, 5.f, -5.f)}, glm::mat4(1.f));
+    occlusion::BuildHiZ();
+
+    // Straight ahead the wall is what we see, the corner of the screen is empty.
+    assert(occlusion::GetDepth(128, 64) < 1.f);
+    assert(occlusion::GetDepth(0, 0) == 1.f);
+
+    // Behind the wall.
+    assert(!occlusion::IsVisible(aabb{glm::vec3(-0.5f, 0.5f, -20.f), glm::vec3(0.5f, 1.5f, -19.f)}));
+
+    // In front of the wall.
+    assert(occlusion::IsVisible(aabb{glm::vec3(-0.5f, 0.5f, -3.f), glm::vec3(0.5f, 1.5f, -2.f)}));
+
+    // Behind the wall's depth but to the side of it.
+    assert(occlusion::IsVisible(aabb{glm::vec3(12.f, 0.5f, -20.f), glm::vec3(13.f, 1.5f, -19.f)}));
+
+    // Partially behind the wall, partially not.
+    assert(occlusion::IsVisible(aabb{glm::vec3(1.f, 0.5f, -20.f), glm::vec3(12.f, 1.5f, -19.f)}));
+
+    // Crosses the near plane, has to be kept.
+    assert(occlusion::IsVisible(aabb{glm::vec3(-0.5f, 0.5f, -1.f), glm::vec3(0.5f, 1.5f, 1.f)}));
+
+    // A wall that goes through the camera's near plane still occludes.
+    occlusion::BeginFrame(projection * view);
+    occlusion::RasteriseBox(aabb{glm::vec3(-50.f, -5.f, -6.f), glm::vec3(50.f, 50.f, -0.05f)}, glm::mat4(1.f));
+    occlusion::BuildHiZ();
+
+    assert(!occlusion::IsVisible(aabb{glm::vec3(-0.5f, 0.5f, -20.f), glm::vec3(0.5f, 1.5f, -19.f)}));
+
+    // An L shaped wall, a back wall and one down the left side. What stands in the corner is behind
+    // the near face of its bounds but in front of both walls, only its triangles leave it visible.
+    glm::vec3 const wall[8]{{-4.f, 0.f, -15.f}, {4.f, 0.f, -15.f}, {4.f, 3.f, -15.f}, {-4.f, 3.f, -15.f},
+			    {-4.f, 0.f, -5.f}, {-4.f, 0.f, -15.f}, {-4.f, 3.f, -15.f}, {-4.f, 3.f, -5.f}};
+    u32 const wallIndices[12]{0, 1, 2, 0, 2, 3, 4, 5, 6, 4, 6, 7};
+    aabb const inTheCorner{glm::vec3(0.f, 0.5f, -10.f), glm::vec3(1.f, 1.5f, -9.f)};
+
+    occlusion::BeginFrame(projection * view);
+    occlusion::RasteriseBox(aabb{glm::vec3(-4.f, 0.f, -15.f), glm::vec3(4.f, 3.f, -5.f)}, glm::mat4(1.f));
+    occlusion::BuildHiZ();
+
+    assert(!occlusion::IsVisible(inTheCorner));
+
+    occlusion::BeginFrame(projection * view);
+    occlusion::RasteriseTriangles(wall, wallIndices, 12, glm::mat4(1.f));
+    occlusion::BuildHiZ();
+
+    assert(occlusion::IsVisible(inTheCorner));
+    assert(!occlusion::IsVisible(aabb{glm::vec3(0.f, 0.5f, -30.f), glm::vec3(1.f, 1.5f, -29.f)}));
+
+    auto const stats = occlusion::GetStats();
+
+    std::cout << "occluders: " << stats._occluders << ", tested: " << stats._tested
+	      << ", culled: " << 100.f * stats._culled / stats._tested << "%, raster: " << stats._rasterMs << " ms\n";
+
+    return 0;
+}
@@ -0,0 +1,213 @@
+#include "l_texture_cache.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+using namespace lain;
+using texture_cache::texture_format;
+
+//
+// Encodes blocks and whole images with every format, decodes them again on
+// the CPU and checks how far off they come back. Then bakes a mip chain,
+// writes it, reads it back and checks a stale or broken cache is rejected.
+//
+static std::vector<u8> MakeImage(u32 width, u32 height)
+{
+    std::vector<u8> image(static_cast<std::size_t>(width) * height * 4);
+
+    // Smooth gradients with a bit of structure, the same slopes whatever the size.
+    for (u32 y{0}; y < height; ++y) {
+	for (u32 x{0}; x < width; ++x) {
+	    u8* p{image.data() + (static_cast<std::size_t>(y) * width + x) * 4};
+
+	    p[0] = static_cast<u8>(x * 4 % 256);
+	    p[1] = static_cast<u8>(y * 4 % 256);
+	    p[2] = static_cast<u8>(128 + 100 * std::sin((x + y) * 0.1f));
+	    p[3] = static_cast<u8>(255 - (x + y) * 2 % 256);
+	}
+    }
+
+    return image;
+}
+
+// Root mean square error over the given channels.
+static f32 GetError(std::vector<u8> const& a, std::vector<u8> const& b, u32 firstChannel, u32 channelCount)
+{
+    double sum{0.0};
+    std::size_t count{0};
+
+    for (std::size_t i{0}; i < a.size(); i += 4) {
+	for (u32 c{firstChannel}; c < firstChannel + channelCount; ++c) {
+	    double const d{static_cast<double>(a[i + c]) - b[i + c]};
+	    sum += d * d;
+	    ++count;
+	}
+    }
+
+    return static_cast<f32>(std::sqrt(sum / count));
+}
+
+static std::vector<u8> RoundTrip(texture_format format, std::vector<u8> const& image, u32 width, u32 height)
+{
+    std::vector<std::byte> encoded(texture_cache::GetLevelSize(format, width, height));
+    std::vector<u8> decoded(image.size());
+
+    texture_cache::EncodeLevel(format, image.data(), width, height, encoded.data());
+    texture_cache::DecodeLevel(format, encoded.data(), width, height, decoded.data());
+
+    return decoded;
+}
+
+int main()
+{
+    // A flat block comes back within the endpoint precision.
+    {
+	std::vector<u8> flat(16 * 4);
+
+	for (u32 i{0}; i < 16; ++i) {
+	    flat[i * 4 + 0] = 200;
+	    flat[i * 4 + 1] = 100;
+	    flat[i * 4 + 2] = 50;
+	    flat[i * 4 + 3] = 77;
+	}
+
+	std::vector<u8> const bc1{RoundTrip(texture_format::bc1, flat, 4, 4)};
+	std::vector<u8> const bc3{RoundTrip(texture_format::bc3, flat, 4, 4)};
+	std::vector<u8> const bc7{RoundTrip(texture_format::bc7, flat, 4, 4)};
+
+	for (u32 i{0}; i < 16 * 4; i += 4) {
+	    for (u32 c{0}; c < 3; ++c) {
+		// 5 bits for red and blue, 6 for green.
+		assert(std::abs(bc1[i + c] - flat[i + c]) <= 4);
+		assert(std::abs(bc3[i + c] - flat[i + c]) <= 4);
+		assert(std::abs(bc7[i + c] - flat[i + c]) <= 1);
+	    }
+
+	    assert(bc1[i + 3] == 255);
+	    assert(bc3[i + 3] == 77);
+	    assert(std::abs(bc7[i + 3] - 77) <= 1);
+	}
+    }
+
+    // Only the two endpoint colours: BC7 gets them exactly (to the shared low bit), BC1 to 565.
+    {
+	std::vector<u8> twoColours(16 * 4);
+
+	for (u32 i{0}; i < 16; ++i) {
+	    u8 const v{static_cast<u8>(i % 3 == 0 ? 16 : 240)};
+
+	    twoColours[i * 4 + 0] = twoColours[i * 4 + 1] = twoColours[i * 4 + 2] = v;
+	    twoColours[i * 4 + 3] = 255;
+	}
+
+	assert(GetError(twoColours, RoundTrip(texture_format::bc1, twoColours, 4, 4), 0, 3) <= 4.f);
+	assert(GetError(twoColours, RoundTrip(texture_format::bc7, twoColours, 4, 4), 0, 4) <= 1.f);
+    }
+
+    // Whole images, including sizes that aren't a multiple of the block size.
+    for (auto const& [width, height] : {std::pair{64u, 64u}, std::pair{13u, 7u}, std::pair{1u, 1u}}) {
+	std::vector<u8> const image{MakeImage(width, height)};
+
+	f32 const bc1{GetError(image, RoundTrip(texture_format::bc1, image, width, height), 0, 3)};
+	f32 const bc3Colour{GetError(image, RoundTrip(texture_format::bc3, image, width, height), 0, 3)};
+	f32 const bc3Alpha{GetError(image, RoundTrip(texture_format::bc3, image, width, height), 3, 1)};
+	f32 const bc7{GetError(image, RoundTrip(texture_format::bc7, image, width, height), 0, 4)};
+
+	std::cout << width << "x" << height << " RMSE: BC1 " << bc1 << ", BC3 " << bc3Colour << " (alpha " << bc3Alpha
+		  << "), BC7 " << bc7 << '\n';
+
+	assert(RoundTrip(texture_format::rgba8, image, width, height) == image);
+	assert(bc1 < 4.f && bc3Colour < 4.f && bc3Alpha < 2.f && bc7 < 3.f);
+    }
+
+    // Not mode 6, nothing to decode.
+    {
+	std::byte block[16]{std::byte{1}}; // mode 0
+	u8 decoded[16 * 4];
+
+	texture_cache::DecodeBC7(block, decoded);
+	assert(decoded[0] == 255 && decoded[1] == 0 && decoded[2] == 255);
+    }
+
+    // Baking builds every level down to 1x1 and a flat image stays flat all the way.
+    {
+	std::vector<u8> flat(13 * 7 * 4, 90);
+	texture_cache::baked_texture baked;
+
+	assert(texture_cache::Bake(flat.data(), 13, 7, 3, texture_format::rgba8, 1, baked));
+	assert(baked._levelCount == 4 && baked._channels == 3);
+	assert(baked._levels[1]._width == 6 && baked._levels[1]._height == 3);
+	assert(baked._levels[3]._width == 1 && baked._levels[3]._height == 1);
+
+	for (u32 i{0}; i < baked._levelCount; ++i) {
+	    u8 const* level{reinterpret_cast<u8 const*>(baked.GetLevelData(i))};
+
+	    for (u64 j{0}; j < baked._levels[i]._size; ++j) {
+		assert(level[j] == 90);
+	    }
+	}
+
+	texture_cache::Release(baked);
+    }
+
+    // Cache file round trip.
+    {
+	std::filesystem::path const file{"./test_texture_cache.ltex"};
+	u64 constexpr kHash{0x1234'5678'9abc'def0};
+	u32 constexpr kSize{256};
+
+	std::vector<u8> const image{MakeImage(kSize, kSize)};
+	texture_cache::baked_texture baked;
+
+	using clock = std::chrono::steady_clock;
+
+	for (auto const format : {texture_format::bc1, texture_format::bc3, texture_format::bc7}) {
+	    auto const start = clock::now();
+	    assert(texture_cache::Bake(image.data(), kSize, kSize, 4, format, kHash, baked));
+	    double const ms{std::chrono::duration<double, std::milli>(clock::now() - start).count()};
+
+	    std::cout << "baked " << kSize << "x" << kSize << " with mips as format " << static_cast<u32>(format) << " in " << ms
+		      << " ms, " << baked._memory.size() << " bytes\n";
+	}
+
+	assert(baked._levelCount == 9);
+	assert(texture_cache::Write(file, baked));
+
+	texture_cache::baked_texture read;
+
+	assert(texture_cache::Read(file, kHash, read));
+	assert(read._file._data != nullptr && read._memory.empty());
+	assert(read._format == texture_format::bc7 && read._width == kSize && read._levelCount == baked._levelCount);
+
+	for (u32 i{0}; i < read._levelCount; ++i) {
+	    assert(read._levels[i]._size == baked._levels[i]._size);
+	    assert(std::equal(read.GetLevelData(i), read.GetLevelData(i) + read._levels[i]._size, baked.GetLevelData(i)));
+	}
+
+	texture_cache::Release(read);
+	assert(read._file._data == nullptr);
+
+	// The source changed.
+	assert(!texture_cache::Read(file, kHash + 1, read));
+
+	// Cut off in the middle of the last level.
+	std::filesystem::resize_file(file, std::filesystem::file_size(file) - 4);
+	assert(!texture_cache::Read(file, kHash, read));
+
+	assert(!texture_cache::Read("./does_not_exist.ltex", kHash, read));
+
+	std::filesystem::remove(file);
+	texture_cache::Release(baked);
+    }
+
+    // Flipped is a different texture.
+    assert(texture_cache::HashSource("./missing.png", false) != texture_cache::HashSource("./missing.png", true));
+
+    return 0;
+}
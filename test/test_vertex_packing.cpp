@@ -0,0 +1,195 @@
+#include "l_mesh_optimiser.h"
+#include "l_vertex_packing.h"
+#include "l_test_obj.h"
+#include "glm/geometric.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <numbers>
+#include <vector>
+
+using namespace lain;
+using vertex_packing::packed_vertex;
+
+//
+// Packs vertices, unpacks them the way GL and the shaders do and checks the
+// error stays within what each encoding promises. Then does it for the game's
+// models and prints how much smaller their vertex buffers get. Run from the
+// repository root.
+//
+
+// In degrees. Not acos of the dot product, that's all rounding error at these angles.
+static f32 GetAngle(glm::vec3 const& a, glm::vec3 const& b)
+{
+    return std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b)) * 180.f / std::numbers::pi_v<f32>;
+}
+
+struct pack_error final
+{
+    f32 _position; // relative to the largest extent
+    f32 _normal; // degrees
+    f32 _texCoords;
+};
+
+static pack_error RoundTrip(std::vector<vertex_data> const& vertices)
+{
+    vertex_packing::quantisation const quantisation{vertex_packing::GetQuantisation(vertices)};
+    std::vector<packed_vertex> const packed{vertex_packing::Pack(vertices, quantisation)};
+    f32 const extent{std::max({quantisation._scale.x, quantisation._scale.y, quantisation._scale.z})};
+    pack_error error{0.f, 0.f, 0.f};
+
+    for (u32 i{0}; i < vertices.size(); ++i) {
+	vertex_data const& original{vertices[i]};
+	vertex_data const unpacked{vertex_packing::Unpack(packed[i], quantisation)};
+
+	// Half a step of 16 bits on every axis, plus a bit for the float maths.
+	for (u32 j{0}; j < 3; ++j) {
+	    f32 const difference{std::abs(unpacked._position[j] - original._position[j])};
+
+	    assert(difference <= quantisation._scale[j] / 65535.f * 0.5f + 1e-6f * (1.f + std::abs(original._position[j])));
+	}
+
+	error._position = std::max(error._position, glm::length(unpacked._position - original._position) / extent);
+
+	if (glm::length(original._normal) > 0.f) {
+	    error._normal = std::max(error._normal, GetAngle(unpacked._normal, glm::normalize(original._normal)));
+	}
+
+	// Half floats keep 11 significant bits, so half a step is 2^-11 of the value.
+	for (u32 j{0}; j < 2; ++j) {
+	    f32 const difference{std::abs(unpacked._texCoords[j] - original._texCoords[j])};
+
+	    assert(difference <= std::max(std::abs(original._texCoords[j]) * 0x1p-11f, 0x1p-25f));
+	    error._texCoords = std::max(error._texCoords, difference);
+	}
+    }
+
+    return error;
+}
+
+static void Report(char const* name, mesh_data mesh)
+{
+    mesh_optimiser::Optimise(mesh);
+
+    pack_error const error{RoundTrip(mesh._vertices)};
+    u32 const vertexCount{static_cast<u32>(mesh._vertices.size())};
+    u32 const indexSize{vertexCount <= 65536 ? 2u : 4u};
+    u64 const indexBytes{mesh._indices.size() * indexSize};
+    u64 const fullBytes{vertexCount * sizeof(vertex_data)};
+    u64 const packedBytes{vertexCount * sizeof(packed_vertex)};
+
+    // What one draw reads: every vertex the post-transform cache misses on, plus the indices.
+    f32 const misses{mesh_optimiser::AnalyseVertexCache(mesh._indices, vertexCount)._acmr * (mesh._indices.size() / 3)};
+
+    std::cout << name << ": " << vertexCount << " vertices, max error position " << error._position
+	      << " of the extent, normal " << error._normal << " deg, uv " << error._texCoords << '\n';
+    std::cout << "  vertex buffer " << fullBytes / 1024 << " -> " << packedBytes / 1024 << " KiB (+ " << indexBytes / 1024
+	      << " KiB of indices), fetched per draw " << static_cast<u64>(misses * sizeof(vertex_data) + indexBytes) / 1024
+	      << " -> " << static_cast<u64>(misses * sizeof(packed_vertex) + indexBytes) / 1024 << " KiB\n";
+
+    assert(error._normal < 0.01f);
+}
+
+int main()
+{
+    // Halves: every one of them converts back to itself, and rounding goes to the nearest even.
+    for (u32 i{0}; i < 0x10000; ++i) {
+	u16 const half{static_cast<u16>(i)};
+	bool const isNan{(half & 0x7c00) == 0x7c00 && (half & 0x3ff) != 0};
+
+	if (!isNan) {
+	    assert(vertex_packing::FloatToHalf(vertex_packing::HalfToFloat(half)) == half);
+	}
+    }
+
+    assert(vertex_packing::FloatToHalf(1.f) == 0x3c00);
+    assert(vertex_packing::FloatToHalf(-2.f) == 0xc000);
+    assert(vertex_packing::FloatToHalf(65504.f) == 0x7bff);
+    assert(vertex_packing::FloatToHalf(65520.f) == 0x7c00);
+    assert(vertex_packing::FloatToHalf(1.f + 0x1p-11f) == 0x3c00); // halfway, down to even
+    assert(vertex_packing::FloatToHalf(1.f + 0x1p-11f + 0x1p-20f) == 0x3c01);
+    assert(vertex_packing::FloatToHalf(0x1p-24f) == 0x0001); // smallest denormal
+    assert(vertex_packing::FloatToHalf(0x1p-25f) == 0x0000); // halfway, down to even
+    assert(vertex_packing::FloatToHalf(0x1p-25f * 1.5f) == 0x0001);
+    assert(std::isnan(vertex_packing::HalfToFloat(vertex_packing::FloatToHalf(std::nanf("")))));
+
+#ifdef __STDCPP_FLOAT16_T__
+    // The compiler's conversion as the reference, over a spread of floats of both signs.
+    for (u32 bits{0}; bits < 0x7f800000; bits += 997) {
+	for (u32 const sign : {0u, 0x80000000u}) {
+	    u32 const pattern{bits | sign};
+	    f32 value;
+	    std::memcpy(&value, &pattern, sizeof(value));
+
+	    std::float16_t const reference{static_cast<std::float16_t>(value)};
+	    u16 expected;
+	    std::memcpy(&expected, &reference, sizeof(expected));
+
+	    assert(vertex_packing::FloatToHalf(value) == expected);
+	}
+    }
+#endif
+
+    // Normals: the axes come back exactly, everything else within a hundredth of a degree.
+    {
+	for (glm::vec3 const axis : {glm::vec3(1.f, 0.f, 0.f), glm::vec3(0.f, -1.f, 0.f), glm::vec3(0.f, 0.f, 1.f), glm::vec3(0.f, 0.f, -1.f)}) {
+	    i16 encoded[2];
+
+	    vertex_packing::EncodeOctahedral(axis, encoded);
+	    assert(vertex_packing::DecodeOctahedral(encoded) == axis);
+	}
+
+	i16 zero[2];
+	vertex_packing::EncodeOctahedral(glm::vec3(0.f), zero);
+	assert(vertex_packing::DecodeOctahedral(zero) == glm::vec3(0.f, 0.f, 1.f));
+
+	// Evenly spread over the sphere.
+	u32 constexpr kCount{100000};
+	f32 maxAngle{0.f};
+
+	for (u32 i{0}; i < kCount; ++i) {
+	    f32 const z{1.f - 2.f * (i + 0.5f) / kCount};
+	    f32 const r{std::sqrt(1.f - z * z)};
+	    f32 const phi{i * std::numbers::pi_v<f32> * (3.f - std::sqrt(5.f))};
+	    glm::vec3 const normal{r * std::cos(phi), r * std::sin(phi), z};
+	    i16 encoded[2];
+
+	    vertex_packing::EncodeOctahedral(normal, encoded);
+	    maxAngle = std::max(maxAngle, GetAngle(vertex_packing::DecodeOctahedral(encoded), normal));
+	}
+
+	std::cout << "octahedral snorm16: max error " << maxAngle << " deg over " << kCount << " normals\n";
+	assert(maxAngle < 0.01f);
+    }
+
+    // Positions across the bounds, including a flat axis.
+    {
+	std::vector<vertex_data> vertices;
+
+	for (u32 i{0}; i <= 1000; ++i) {
+	    f32 const t{i / 1000.f};
+
+	    vertices.push_back(vertex_data{glm::vec3(-3.f + 6.3f * t, 2.f, 100.f * t * t), glm::vec3(0.f, 1.f, 0.f), glm::vec2(t, 4.f * t)});
+	}
+
+	vertex_packing::quantisation const quantisation{vertex_packing::GetQuantisation(vertices)};
+
+	assert(quantisation._offset == glm::vec3(-3.f, 2.f, 0.f));
+	assert(quantisation._scale.y == 0.f);
+
+	packed_vertex const first{vertex_packing::Pack(vertices.front(), quantisation)};
+	packed_vertex const last{vertex_packing::Pack(vertices.back(), quantisation)};
+
+	assert(first._position[0] == 0 && first._position[1] == 0 && first._position[2] == 0);
+	assert(last._position[0] == 65535 && last._position[1] == 0 && last._position[2] == 65535);
+
+	RoundTrip(vertices);
+    }
+
+    Report("ball.obj", test_obj::Load("./res/models/ball.obj"));
+    Report("maze.obj", test_obj::Load("./res/models/maze.obj"));
+
+    return 0;
+}
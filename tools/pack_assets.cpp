@@ -0,0 +1,51 @@
+#include "l_asset_pack.h"
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+
+using namespace lain;
+
+//
+// pack_assets <pack> <directory>...
+//
+// Packs every file under the given directories, named by their path relative to
+// the working directory, so run it from where the game runs from:
+//
+//   pack_assets res.pak res/shaders res/models res/cache
+//
+int main(int argc, char* argv[])
+{
+  if (argc < 3) {
+    std::cerr << "usage: " << argv[0] << " <pack> <directory>...\n";
+    return EXIT_FAILURE;
+  }
+
+  std::vector<asset_pack::pack_input> inputs;
+
+  for (int i{2}; i < argc; ++i) {
+    std::error_code error;
+
+    std::filesystem::recursive_directory_iterator it{argv[i], error};
+
+    // No exceptions, so not a range for.
+    for (; !error && it != std::filesystem::recursive_directory_iterator{}; it.increment(error)) {
+      // Half written caches.
+      if (it->is_regular_file() && it->path().extension() != ".tmp") {
+	inputs.emplace_back(asset_pack::NormaliseName(it->path()), it->path());
+      }
+    }
+
+    if (error) {
+      std::cerr << argv[0] << ": couldn't read " << argv[i] << ": " << error.message() << '\n';
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (!asset_pack::Write(argv[1], inputs)) {
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "packed " << inputs.size() << " files into " << argv[1] << '\n';
+
+  return EXIT_SUCCESS;
+}